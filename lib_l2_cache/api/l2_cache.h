@@ -14,26 +14,66 @@
 #include "l2_cache_debug.h"
 #endif /* L2_CACHE_DEBUG_ON */
 
+#if L2_CACHE_PREFETCH_ON
+#include "l2_cache_prefetch.h"
+#endif /* L2_CACHE_PREFETCH_ON */
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+#include "l2_cache_adaptive.h"
+#endif /* L2_CACHE_ADAPTIVE_FETCH_ON */
+
+#if L2_CACHE_HEATMAP_ON
+#include "l2_cache_heatmap.h"
+#endif /* L2_CACHE_HEATMAP_ON */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Direct-map buffer: one 16-bit tag per line, then the line data
 #define L2_CACHE_BUFFER_WORDS_DIRECT_MAP(LINE_COUNT, LINE_SIZE_BYTES)       \
-            (LINE_COUNT * (((LINE_SIZE_BYTES) + sizeof(int)))/sizeof(int))
+            (((LINE_COUNT) * (sizeof(uint16_t) + (LINE_SIZE_BYTES)) + sizeof(int) - 1)/sizeof(int))
 
+// Two-way buffer: two 16-bit tags per set, one last-hit byte per set (padded to a word),
+// then the data for both ways
 #define L2_CACHE_BUFFER_WORDS_TWO_WAY(LINE_COUNT, LINE_SIZE_BYTES)          \
-            (LINE_COUNT * 2*(((LINE_SIZE_BYTES) + 2*sizeof(int)))/sizeof(int))
+            ((LINE_COUNT) + ((LINE_COUNT) + sizeof(int) - 1)/sizeof(int)         \
+                + ((LINE_COUNT) * 2*(LINE_SIZE_BYTES))/sizeof(int))
+
+// Compressed buffer: one line as read from flash, the pool of compressed lines, then a 16-bit
+// pool offset per line index
+#define L2_CACHE_BUFFER_WORDS_COMPRESSED(LINE_COUNT, LINE_SIZE_BYTES, POOL_BYTES)   \
+            (((LINE_SIZE_BYTES) + (POOL_BYTES))/sizeof(int)                           \
+                + ((LINE_COUNT) * sizeof(uint16_t) + sizeof(int) - 1)/sizeof(int))
 
 #define L2_CACHE_SWMEM_READ_FN  __attribute__((fptrgroup("l2_cache_swmem_read_fptr_grp")))
 typedef void (*l2_cache_swmem_read_fn)(void*, const void*, const size_t);
 
+/**
+ * One piece of a vectored read: `bytes` bytes from flash address `src` to `dst`.
+ */
+typedef struct {
+  void* dst;
+  const void* src;
+  size_t bytes;
+} l2_cache_read_seg_t;
+
+#define L2_CACHE_SWMEM_READV_FN  __attribute__((fptrgroup("l2_cache_swmem_readv_fptr_grp")))
+typedef void (*l2_cache_swmem_readv_fn)(const l2_cache_read_seg_t*, const unsigned);
+
 #define L2_CACHE_SETUP_FN_ATTR  __attribute__((fptrgroup("l2_cache_setup_fptr_grp")))
-typedef void (*l2_cache_setup_fn)(const unsigned, const unsigned, void*, l2_cache_swmem_read_fn);
+typedef int (*l2_cache_setup_fn)(const unsigned, const unsigned, void*, l2_cache_swmem_read_fn);
 
 #define L2_CACHE_THREAD_FN_ATTR  __attribute__((fptrgroup("l2_cache_thread_fptr_grp")))
 typedef void (*l2_cache_thread_fn)(void*);
 
 /**
  * Initialize for two-way set associative read-only L2 cache.
+ *
+ * Returns 0, or -1 if the geometry is rejected as for l2_cache_setup_direct_map(), in which
+ * case nothing has been set up.
  */
-
-void l2_cache_setup_two_way(
+int l2_cache_setup_two_way(
     const unsigned line_count,
     const unsigned line_size_bytes,
     void* cache_buffer,
@@ -41,8 +81,17 @@ void l2_cache_setup_two_way(
 
 /**
  * Initialize for direct-mapped L2 read-only cache.
+ *
+ * Only 16 bits of each tag are kept, so a line's tag (the flash address bits above the line
+ * and index bits) must fit in 15, leaving all ones to mark an empty line:
+ *
+ *   log2(line_size_bytes) + log2(line_count) >= L2_CACHE_SWMEM_ADDRESS_BITS - 15
+ *
+ * which is 9 by default, e.g. at least 16 lines of 32 bytes. The cache must also be smaller
+ * than the flash-backed part of SwMem. Returns 0, or -1 (in every build) if either doesn't
+ * hold, in which case nothing has been set up.
  */
-void l2_cache_setup_direct_map(
+int l2_cache_setup_direct_map(
     const unsigned line_count,
     const unsigned line_size_bytes,
     void* cache_buffer,
@@ -62,6 +111,424 @@ void l2_cache_direct_map(void*);
  */
 void l2_cache_two_way(void*);
 
+#if L2_CACHE_SEGMENTS_ON
+// Tags only, for l2_cache_setup_*_segments(); the line data goes in the segments
+#define L2_CACHE_TAG_WORDS_DIRECT_MAP(LINE_COUNT)                           \
+            (((LINE_COUNT) * sizeof(uint16_t) + sizeof(int) - 1)/sizeof(int))
+
+#define L2_CACHE_TAG_WORDS_TWO_WAY(LINE_COUNT)                              \
+            ((LINE_COUNT) + ((LINE_COUNT) + sizeof(int) - 1)/sizeof(int))
+
+/**
+ * A piece of free SRAM given to the cache for line data.
+ */
+typedef struct {
+  void* buffer;
+  size_t bytes;
+} l2_cache_segment_t;
+
+/**
+ * Initialize for the direct-mapped cache (or, below, the two-way cache) as
+ * l2_cache_setup_direct_map() does, but with the line data spread over `segment_count`
+ * segments of SRAM rather than following the tags in one buffer. `tag_buffer` holds
+ * L2_CACHE_TAG_WORDS_DIRECT_MAP(line_count) words.
+ *
+ * The sets are split into the fewest equal, power-of-two sized groups (at most
+ * 1 << L2_CACHE_SEGMENT_TABLE_BITS) which can each be given a whole segment or part of one,
+ * and a fill finds its group's segment from the top bits of its set index. So a group of a
+ * two-way cache takes 2 * line_size_bytes for each of its sets, and room in a segment short
+ * of a whole group goes unused.
+ *
+ * Returns 0, or -1 if the groups can't be made small enough to fit, in which case nothing
+ * has been set up.
+ *
+ * Also returns -1 for a geometry l2_cache_setup_direct_map() would reject.
+ *
+ * `segments` is copied, so needn't be kept. The segments needn't be in any order, and each
+ * is word-aligned if need be.
+ */
+int l2_cache_setup_direct_map_segments(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* tag_buffer,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count,
+    l2_cache_swmem_read_fn read_func);
+
+/**
+ * `line_count` is the number of sets, as for l2_cache_setup_two_way(), and `tag_buffer` holds
+ * L2_CACHE_TAG_WORDS_TWO_WAY(line_count) words.
+ */
+int l2_cache_setup_two_way_segments(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* tag_buffer,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count,
+    l2_cache_swmem_read_fn read_func);
+#endif /* L2_CACHE_SEGMENTS_ON */
+
+
+/**
+ * The kinds of cache a region (see l2_cache_setup_regions()) can have.
+ */
+typedef enum {
+  L2_CACHE_REGION_DIRECT_MAP,
+  L2_CACHE_REGION_TWO_WAY,
+} l2_cache_region_type_t;
+
+#if L2_CACHE_TRANSFORM_ON
+#define L2_CACHE_TRANSFORM_FN  __attribute__((fptrgroup("l2_cache_transform_fptr_grp")))
+
+/**
+ * Decode the `encoded_bytes` bytes at `encoded`, read from flash, into the `line_bytes` bytes
+ * of a cache line at `line`. Called on the cache thread on every miss in the region.
+ */
+typedef void (*l2_cache_transform_fn)(void* line, const void* encoded,
+                                      const size_t encoded_bytes, const size_t line_bytes);
+#endif /* L2_CACHE_TRANSFORM_ON */
+
+/**
+ * A range of SwMem addresses with its own cache.
+ */
+typedef struct {
+  const void* start;          /// first address in the region
+  size_t len;                 /// size of the region in bytes, or 0 for everything else
+  l2_cache_region_type_t type;
+  unsigned line_count;        /// lines (or for the two-way cache, sets)
+  unsigned line_size_bytes;
+  void* cache_buffer;         /// L2_CACHE_BUFFER_WORDS_*(line_count, line_size_bytes) words
+#if L2_CACHE_TRANSFORM_ON
+  /// NULL, or a decoder through which each line of the region is filled. The region is then
+  /// a decoded view of data kept encoded in flash: line k of the region (from `start`) is
+  /// `transform` of the `encoded_line_bytes` bytes at `encoded + k * encoded_line_bytes`,
+  /// and only those are read on a miss. `start` needn't hold anything in flash, but must be
+  /// line-aligned, and `encoded_line_bytes` at most L2_CACHE_TRANSFORM_MAX_BYTES.
+  L2_CACHE_TRANSFORM_FN
+  l2_cache_transform_fn transform;
+  const void* encoded;        /// SwMem address of the encoded data
+  unsigned encoded_line_bytes;
+#endif /* L2_CACHE_TRANSFORM_ON */
+} l2_cache_region_t;
+
+#if L2_CACHE_TRANSFORM_ON
+/**
+ * Transforms for l2_cache_region_t.transform.
+ *
+ * l2_cache_transform_int4: two signed 4-bit values a byte, low nibble first, to int8
+ * (encoded_line_bytes is half the line size).
+ *
+ * l2_cache_transform_delta8: each byte the difference from the one before, the first from 0,
+ * to the running sum (encoded_line_bytes is the line size).
+ *
+ * l2_cache_transform_byteswap32: words of the other byte order (encoded_line_bytes is the
+ * line size).
+ */
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_int4(void* line, const void* encoded,
+                             const size_t encoded_bytes, const size_t line_bytes);
+
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_delta8(void* line, const void* encoded,
+                               const size_t encoded_bytes, const size_t line_bytes);
+
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_byteswap32(void* line, const void* encoded,
+                                   const size_t encoded_bytes, const size_t line_bytes);
+#endif /* L2_CACHE_TRANSFORM_ON */
+
+/**
+ * Initialize for an L2 read-only cache which gives each region of SwMem a cache of its own,
+ * with its own line size, line count and kind of cache. For example, a large blob of weights
+ * read straight through can have a few 1 KiB lines, while a table which is read at random
+ * has many 64-byte lines.
+ *
+ * Each fill is served by the first of the `region_count` regions which contains it. A
+ * region with `len` 0 contains everything, so can be given last to catch whatever the others
+ * don't. Fills which are in no region are read from flash each time.
+ *
+ * `regions` is copied, so needn't be kept.
+ *
+ * Returns 0, or -1 if any region's geometry is rejected as for l2_cache_setup_direct_map(),
+ * in which case no region is served (though the buffers of the regions before it may have
+ * been written).
+ *
+ * With L2_CACHE_TRANSFORM_ON, a region can be given a transform (see l2_cache_region_t),
+ * so that it caches data which is kept in a denser encoding in flash already decoded.
+ *
+ * NOTE: Each region is served exactly as l2_cache_direct_map() or l2_cache_two_way() would
+ *       serve it, but by a fill loop written in C, which takes longer over every fill.
+ * NOTE: l2_cache_set_readv(), l2_cache_preload(), warm lists, the prefetcher, adaptive fetch
+ *       and l2_cache_read() need a single cache, so don't work with regions (see each for
+ *       what it does instead).
+ */
+int l2_cache_setup_regions(
+    const l2_cache_region_t regions[],
+    const unsigned region_count,
+    l2_cache_swmem_read_fn read_func);
+
+/**
+ * L2 read-only cache with a separate cache for each region of SwMem (see
+ * l2_cache_setup_regions()).
+ */
+void l2_cache_regions(void*);
+
+/**
+ * Initialize for an L2 read-only cache which keeps its lines compressed, so that more of them
+ * fit in the same SRAM when the data is sparse (weights, glyphs and tables with many zero
+ * bytes).
+ *
+ * Each line is kept as the non-zero bytes of each of its 32-byte blocks and a mask of where
+ * they go, in a pool of `pool_bytes` bytes. A line takes as much of the pool as it needs,
+ * and the oldest lines are dropped to make room. A hit expands the 32 bytes asked for; a
+ * block of zeros and a block with no zero bytes cost next to nothing to serve. Lines are
+ * found through `line_count` line indexes (a power of two), which should be several times
+ * the number of whole lines the pool could hold uncompressed.
+ *
+ * `cache_buffer` holds L2_CACHE_BUFFER_WORDS_COMPRESSED(line_count, line_size_bytes,
+ * pool_bytes) words. `pool_bytes` is a multiple of 4, under 256 KiB, and has room for at
+ * least one line with no zero bytes in it.
+ *
+ * Returns 0, or -1 if `pool_bytes` is out of range, in which case the cache isn't set up.
+ *
+ * NOTE: Served by a fill loop written in C, so a hit takes longer than with
+ *       l2_cache_direct_map() or l2_cache_two_way(). It pays off where the extra lines held
+ *       save more misses than that costs (see the workload benchmark).
+ * NOTE: l2_cache_set_readv(), l2_cache_preload(), warm lists, the prefetcher, adaptive fetch
+ *       and l2_cache_read() need lines stored as they are in flash, so don't work with it
+ *       (see each for what it does instead).
+ */
+int l2_cache_setup_compressed(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    const unsigned pool_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func);
+
+/**
+ * L2 read-only cache keeping its lines compressed (see l2_cache_setup_compressed()).
+ */
+void l2_cache_compressed(void*);
+
+/**
+ * Lines the compressed cache holds.
+ */
+unsigned l2_cache_compressed_lines_held(void);
+
+#if L2_CACHE_PARTITION_ON
+/// Way given to a partition which may use either way, as without partitions
+#define L2_CACHE_WAY_ANY   (2)
+
+/**
+ * A range of SwMem addresses given a way of the two-way cache to itself.
+ */
+typedef struct {
+  const void* start;          /// first address in the partition
+  size_t len;                 /// size of the partition in bytes
+  unsigned way;               /// 0, 1 or L2_CACHE_WAY_ANY
+} l2_cache_partition_t;
+
+/**
+ * Split the ways of the two-way cache between ranges of SwMem, so that (for example) code
+ * keeps its lines however much data is streamed through the cache.
+ *
+ * A miss on a line in `partitions[k]` (the first that contains it) only ever fills way
+ * `partitions[k].way`, and a miss on a line in none of them only ever fills `other_way`.
+ * Partitions given different ways therefore never evict each other's lines. Ranges should be
+ * line-aligned, so that each line is in one partition.
+ *
+ * Give no partitions and L2_CACHE_WAY_ANY for `other_way` to go back to sharing both ways.
+ *
+ * `partitions` is copied, so needn't be kept.
+ *
+ * May be called at any time, from any one thread on the tile, including while the cache is
+ * running. The new partitions apply to the next miss; lines already cached stay where they
+ * are until evicted. If a miss is still looking through the partitions set two calls ago,
+ * this waits for it to finish looking before reusing their memory.
+ *
+ * NOTE: Two-way regions (see l2_cache_setup_regions()) are partitioned too.
+ */
+void l2_cache_two_way_set_partitions(
+    const l2_cache_partition_t partitions[],
+    const unsigned count,
+    const unsigned other_way);
+#endif /* L2_CACHE_PARTITION_ON */
+
+
+/**
+ * Give the L2 cache a vectored read function, and set how many lines are fetched on each miss.
+ *
+ * When a miss can fetch several lines that are adjacent in flash, all of their segments are
+ * handed to `readv_func` in a single call, in ascending flash address order. Segments whose
+ * `src` follow on from one another should be read as one continuous flash transaction, even
+ * when their `dst` are not contiguous.
+ *
+ * `readv_func` may be NULL, in which case the read function given at setup is called once
+ * for each run of lines that is contiguous in both flash and the cache.
+ *
+ * `miss_fetch_lines` is the number of lines fetched on each miss, starting with the line that
+ * missed. Lines which are already cached are skipped. 1 (the default) fetches only the line
+ * that missed, exactly as without this call.
+ *
+ * NOTE: Must be called after l2_cache_setup_*() and before the cache thread is started.
+ */
+void l2_cache_set_readv(
+    l2_cache_swmem_readv_fn readv_func,
+    const unsigned miss_fetch_lines);
+
+/**
+ * Load every line overlapping `[address, address + len)` into the L2 cache, using as few
+ * flash transactions as possible.
+ *
+ * Does nothing with l2_cache_setup_regions() or l2_cache_setup_compressed().
+ *
+ * NOTE: The tables are owned by the cache thread, so this must be called after
+ *       l2_cache_setup_*() and before the cache thread is started.
+ */
+void l2_cache_preload(
+    const void* address,
+    const size_t len);
+
+#if L2_CACHE_BULK_READ_ON
+/**
+ * Copy `len` bytes from `src` to `dst`, without going through SwMem fills.
+ *
+ * Lines that are in the L2 cache are copied straight out of the cache buffer. Everything else
+ * is read from flash into `dst` with as few calls to the read function as possible (up to
+ * L2_CACHE_BULK_READ_CHUNK_BYTES at a time). Lines read from flash are not added to the cache,
+ * so a large copy doesn't evict the working set.
+ *
+ * `src` need not be line-aligned, and need not be in SwMem at all (in which case this is
+ * just memcpy()). With l2_cache_setup_regions() or l2_cache_setup_compressed() it is also
+ * just memcpy(), through SwMem fills like any other access.
+ *
+ * May be called from any thread on the tile while the cache is running.
+ */
+void l2_cache_read(
+    void* dst,
+    const void* src,
+    const size_t len);
+#endif /* L2_CACHE_BULK_READ_ON */
+
+#if L2_CACHE_QUERY_ON
+/// Words of bitmap l2_cache_query_range() may write for `LEN` bytes, however they're aligned
+#define L2_CACHE_QUERY_BITMAP_WORDS(LEN, LINE_SIZE_BYTES)                   \
+            (((((LEN) + 2*(LINE_SIZE_BYTES) - 2)/(LINE_SIZE_BYTES)) + 31)/32)
+
+/**
+ * Find which of the lines overlapping `[address, address + len)` are in the L2 cache.
+ *
+ * Bit k of `bitmap_out` (bit k%32 of word k/32) is set if the k'th line, counting from the
+ * line holding `address`, is cached. Lines outside the flash-backed part of SwMem are
+ * never cached. Returns the number of lines that are.
+ *
+ * The tag tables are read without locking. Each word of the bitmap is a snapshot taken
+ * while the cache thread wasn't replacing lines, retaken if it replaced any meanwhile; a
+ * range longer than 32 lines may be made of several snapshots.
+ *
+ * May be called from any thread on the tile while the cache is running, but not from the
+ * read function.
+ *
+ * NOTE: Needs a single cache. With l2_cache_setup_regions() or l2_cache_setup_compressed(),
+ *       returns 0 and leaves `bitmap_out` alone.
+ */
+unsigned l2_cache_query_range(
+    const void* address,
+    const size_t len,
+    uint32_t* bitmap_out);
+#endif /* L2_CACHE_QUERY_ON */
+
+/**
+ * A run of SwMem in which every word has the same value, such as a zero-initialised table or
+ * erased (0xFFFFFFFF) padding.
+ */
+typedef struct {
+  uint32_t start;       /// offset from the start of SwMem; a multiple of 32
+  uint32_t bytes;       /// a multiple of 32
+  uint32_t value;       /// every word in the run
+} l2_cache_const_run_t;
+
+#if L2_CACHE_CONST_MAP_ON
+/**
+ * Serve misses in constant runs straight from a vector of the run's value, without reading
+ * flash or taking a cache line.
+ *
+ * `runs` must be sorted by `start`, must not overlap, and must stay valid (in SRAM) while the
+ * cache runs; it isn't copied. Give no runs to turn this off.
+ *
+ * tools/l2_cache_const_map.py builds the runs from the SwMem image.
+ *
+ * NOTE: Must be called before the cache thread is started, or while it's stopped.
+ * NOTE: Each miss searches the runs, which takes time logarithmic in their number.
+ */
+void l2_cache_set_const_map(
+    const l2_cache_const_run_t runs[],
+    const unsigned count);
+
+/// Fills served from constant runs
+extern volatile uint32_t l2_cache_const_fill_count;
+#endif /* L2_CACHE_CONST_MAP_ON */
+
+/**
+ * A list of flash lines to load at boot, as sorted runs of consecutive lines.
+ *
+ * Each run is `L2_CACHE_WARM_RUN(first_line, line_count)`, where `first_line` counts
+ * `line_bytes` lines from the start of SwMem. A list made for one line size still works with
+ * a cache using another; it just covers slightly more or less than it did.
+ *
+ * tools/l2_cache_warm_list.py builds one from a list of fill addresses.
+ */
+typedef struct {
+  uint32_t magic;       // L2_CACHE_WARM_LIST_MAGIC; anything else (e.g. erased flash) is ignored
+  uint32_t line_bytes;
+  uint32_t run_count;
+  uint32_t run[];
+} l2_cache_warm_list_t;
+
+#define L2_CACHE_WARM_LIST_MAGIC      0x4C57324C
+
+#define L2_CACHE_WARM_RUN_MAX_LINES   256
+#define L2_CACHE_WARM_RUN(FIRST_LINE, LINE_COUNT)   (((FIRST_LINE) << 8) | ((LINE_COUNT) - 1))
+#define L2_CACHE_WARM_RUN_FIRST(RUN)                ((RUN) >> 8)
+#define L2_CACHE_WARM_RUN_LINES(RUN)                (((RUN) & 0xFF) + 1)
+
+/// Bytes taken by a warm list of `RUN_COUNT` runs
+#define L2_CACHE_WARM_LIST_BYTES(RUN_COUNT)             (sizeof(l2_cache_warm_list_t) + (RUN_COUNT) * sizeof(uint32_t))
+
+/**
+ * Write the lines currently held in the L2 cache to `list` as a warm list, so that they can
+ * be saved (e.g. to flash) and handed to l2_cache_warm_from_list() on a later boot.
+ *
+ * `max_lines` is the room in `list->run[]`, in words; it is also used as scratch space, so
+ * at most `max_lines` lines are recorded. Room for the whole cache never runs short.
+ *
+ * Returns the size of the list in bytes, or 0 (with nothing written) with
+ * l2_cache_setup_regions() or l2_cache_setup_compressed().
+ *
+ * NOTE: May be called while the cache is running, in which case the list is a snapshot that
+ *       may be missing lines which were being replaced at the time.
+ */
+size_t l2_cache_warm_list_export(
+    l2_cache_warm_list_t* list,
+    const unsigned max_lines);
+
+/**
+ * Load the lines in a warm list into the L2 cache before it serves its first fill.
+ *
+ * This only records the list; the cache thread loads it, using batched reads, as soon as it
+ * starts. The application can carry on with its own initialization meanwhile, and any SwMem
+ * access simply waits until the list has been loaded.
+ *
+ * `list` may itself be in SwMem, in which case it is read through the read function given at
+ * setup rather than through the cache. It must stay valid until the cache thread is running.
+ *
+ * Ignored with l2_cache_setup_regions() or l2_cache_setup_compressed().
+ *
+ * NOTE: Must be called after l2_cache_setup_*() and before the cache thread is started.
+ */
+void l2_cache_warm_from_list(
+    const l2_cache_warm_list_t* list);
+
 
 /// The following are basically for debugging purposes, but must be visible when L2_CACHE_DEBUG_ON is
 /// not enabled because they're required to test for correctness.
@@ -122,4 +589,16 @@ typedef struct {
 l2_cache_direct_map_addr_dbg_t l2_cache_direct_map_get_addr_info(
     const void* address);
 
+#ifdef __cplusplus
+}
+#endif
+
+#if L2_CACHE_FLASH_SERVER_ON
+#include "l2_cache_flash_server.h"
+#endif /* L2_CACHE_FLASH_SERVER_ON */
+
+#if L2_CACHE_STREAM_ON
+#include "l2_cache_stream.h"
+#endif /* L2_CACHE_STREAM_ON */
+
 #endif // L2_CACHE_H_
@@ -0,0 +1,245 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_HPP_
+#define L2_CACHE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "l2_cache.h"
+#include "l2_cache_ref.h"
+
+/*
+  C++ wrapper with the cache geometry fixed at compile time.
+
+  An l2_cache<Engine, LineBytes, Lines> checks its geometry with static_assert (so a line
+  count or size which l2_cache_setup_*() would reject doesn't build), and owns a buffer of
+  exactly the right size and alignment. For example:
+
+    static l2_cache<l2_cache_two_way_engine, 256, 64> cache;
+
+    cache.setup(flash_read_bytes);
+    run_async(cache.thread(), NULL, stack);
+
+  Nothing here has any state of its own beyond the buffer, and everything other than the
+  calls into the C API is constexpr, so it costs nothing over calling the C API directly.
+  The same definition works on the device and in the host tests (see tests/host), where
+  ref_fill() stands in for the cache thread.
+
+  NOTE: The library holds on to the buffer, so the object must outlive the cache thread.
+        Give it static storage.
+*/
+
+
+/**
+ * The direct-mapped cache, as Engine for l2_cache<>. `Lines` is the number of lines.
+ */
+struct l2_cache_direct_map_engine {
+  typedef l2_cache_direct_map_addr_dbg_t addr_info_t;
+
+  /// Lines held for each index
+  static constexpr unsigned ways = 1;
+
+  static constexpr size_t buffer_words(
+      const unsigned line_count,
+      const unsigned line_size_bytes)
+  {
+    return L2_CACHE_BUFFER_WORDS_DIRECT_MAP(line_count, line_size_bytes);
+  }
+
+  static void setup(
+      const unsigned line_count,
+      const unsigned line_size_bytes,
+      void* cache_buffer,
+      l2_cache_swmem_read_fn read_func)
+  {
+    l2_cache_setup_direct_map(line_count, line_size_bytes, cache_buffer, read_func);
+  }
+
+  static l2_cache_thread_fn thread()
+  {
+    return l2_cache_direct_map;
+  }
+
+  static addr_info_t addr_info(
+      const void* address)
+  {
+    return l2_cache_direct_map_get_addr_info(address);
+  }
+
+  static const void* ref_fill(
+      const unsigned fill_addr)
+  {
+    return l2_cache_direct_map_ref_fill(fill_addr);
+  }
+};
+
+/**
+ * The two-way set associative cache, as Engine for l2_cache<>. `Lines` is the number of
+ * sets, each of which holds two lines.
+ */
+struct l2_cache_two_way_engine {
+  typedef l2_cache_two_way_addr_dbg_t addr_info_t;
+
+  /// Lines held for each index
+  static constexpr unsigned ways = 2;
+
+  static constexpr size_t buffer_words(
+      const unsigned line_count,
+      const unsigned line_size_bytes)
+  {
+    return L2_CACHE_BUFFER_WORDS_TWO_WAY(line_count, line_size_bytes);
+  }
+
+  static void setup(
+      const unsigned line_count,
+      const unsigned line_size_bytes,
+      void* cache_buffer,
+      l2_cache_swmem_read_fn read_func)
+  {
+    l2_cache_setup_two_way(line_count, line_size_bytes, cache_buffer, read_func);
+  }
+
+  static l2_cache_thread_fn thread()
+  {
+    return l2_cache_two_way;
+  }
+
+  static addr_info_t addr_info(
+      const void* address)
+  {
+    return l2_cache_two_way_get_addr_info(address);
+  }
+
+  static const void* ref_fill(
+      const unsigned fill_addr)
+  {
+    return l2_cache_two_way_ref_fill(fill_addr);
+  }
+};
+
+
+/// log2 of a power of 2 (C++11 constexpr, so one return statement)
+static constexpr unsigned l2_cache_log2(
+    const unsigned value)
+{
+  return (value <= 1)? 0 : 1 + l2_cache_log2(value >> 1);
+}
+
+static constexpr bool l2_cache_is_pow2(
+    const unsigned value)
+{
+  return (value != 0) && ((value & (value - 1)) == 0);
+}
+
+
+/**
+ * An L2 cache with `Lines` lines (or sets) of `LineBytes` bytes, served by `Engine`.
+ */
+template <typename Engine, unsigned LineBytes, unsigned Lines>
+class l2_cache {
+public:
+  typedef Engine engine;
+  typedef typename Engine::addr_info_t addr_info_t;
+
+  static constexpr unsigned line_bytes = LineBytes;
+  static constexpr unsigned line_count = Lines;
+  static constexpr unsigned ways = Engine::ways;
+
+  /// Bits of an address below the index, the index, and the tag the engine compares
+  static constexpr unsigned line_bits = l2_cache_log2(LineBytes);
+  static constexpr unsigned index_bits = l2_cache_log2(Lines);
+  static constexpr unsigned tag_bits = L2_CACHE_SWMEM_ADDRESS_BITS - line_bits - index_bits;
+
+  /// Bytes of flash the cache can hold
+  static constexpr size_t capacity_bytes = (size_t) ways * Lines * LineBytes;
+
+  /// Size of the buffer, exactly as L2_CACHE_BUFFER_WORDS_*() gives it
+  static constexpr size_t buffer_words = Engine::buffer_words(Lines, LineBytes);
+
+  // The same checks as l2_cache_setup_*(), but at compile time
+  static_assert( l2_cache_is_pow2(LineBytes), "LineBytes must be a power of 2" );
+  static_assert( LineBytes >= 32, "LineBytes must be at least 32 (one SwMem fill)" );
+  static_assert( l2_cache_is_pow2(Lines), "Lines must be a power of 2" );
+  static_assert( Lines >= 2, "Lines must be at least 2 (the engines need an index bit)" );
+  static_assert( L2_CACHE_SWMEM_ADDRESS_BITS > line_bits + index_bits,
+                 "the cache is bigger than the flash-backed part of SwMem" );
+  static_assert( tag_bits <= 15,
+                 "tags don't fit in the tag table; use fewer, smaller lines or lower "
+                 "L2_CACHE_SWMEM_ADDRESS_BITS" );
+
+  /**
+   * Set up the cache to read flash with `read_func`. Same as l2_cache_setup_*(), which can't
+   * fail here, the geometry having been checked at compile time.
+   */
+  void setup(
+      l2_cache_swmem_read_fn read_func)
+  {
+    Engine::setup(Lines, LineBytes, buffer_, read_func);
+  }
+
+  /**
+   * The cache thread to start once set up (e.g. with run_async()).
+   */
+  static l2_cache_thread_fn thread()
+  {
+    return Engine::thread();
+  }
+
+  /**
+   * Same as l2_cache_*_get_addr_info().
+   */
+  static addr_info_t addr_info(
+      const void* address)
+  {
+    return Engine::addr_info(address);
+  }
+
+  /**
+   * Serve one fill with the reference engine, as the cache thread would (see l2_cache_ref.h).
+   */
+  static const void* ref_fill(
+      const unsigned fill_addr)
+  {
+    return Engine::ref_fill(fill_addr);
+  }
+
+  /// Offset of an address into its line
+  static constexpr unsigned offset(
+      const unsigned addr)
+  {
+    return addr & (LineBytes - 1);
+  }
+
+  /// Index (line or set) of the table entry an address is cached in
+  static constexpr unsigned index(
+      const unsigned addr)
+  {
+    return (addr >> line_bits) & (Lines - 1);
+  }
+
+  /// Tag kept in the tag table for an address
+  static constexpr unsigned tag(
+      const unsigned addr)
+  {
+    return (addr >> (line_bits + index_bits)) & 0xFFFF;
+  }
+
+  /// Address of the start of the line an address is in
+  static constexpr unsigned line_address(
+      const unsigned addr)
+  {
+    return addr & ~(LineBytes - 1);
+  }
+
+  void* buffer()
+  {
+    return buffer_;
+  }
+
+private:
+  alignas(8) uint32_t buffer_[buffer_words];
+};
+
+#endif // L2_CACHE_HPP_
@@ -0,0 +1,84 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_ADAPTIVE_H_
+#define L2_CACHE_ADAPTIVE_H_
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  With L2_CACHE_ADAPTIVE_FETCH_ON, each miss fetches a run of whole lines whose length
+  (1 to L2_CACHE_ADAPTIVE_MAX_LINES) is kept for each region of L2_CACHE_ADAPTIVE_REGION_BITS.
+
+  The cache thread records which 32-byte parts of the lines it fetched get filled from. Every
+  L2_CACHE_ADAPTIVE_WINDOW misses in a region, the run is doubled if most of those misses
+  carried straight on from the last run fetched, or halved if less than half of what was
+  fetched was used.
+*/
+
+extern struct {
+    volatile uint32_t miss_count;     /// misses handled
+    volatile uint32_t fetched_bytes;  /// bytes read from flash for them
+    volatile uint32_t flash_ticks;    /// reference clock ticks spent reading them
+    volatile uint32_t tracked_bytes;  /// fetched bytes whose use has been counted so far
+    volatile uint32_t used_bytes;     /// ...and how many of those were filled from
+} l2_cache_adaptive_stats;
+
+/**
+ * Number of lines currently fetched on a miss at `address`.
+ */
+unsigned l2_cache_adaptive_fetch_lines(
+    const void* address);
+
+static inline void l2_cache_adaptive_stats_reset(void)
+{
+    l2_cache_adaptive_stats.miss_count = 0;
+    l2_cache_adaptive_stats.fetched_bytes = 0;
+    l2_cache_adaptive_stats.flash_ticks = 0;
+    l2_cache_adaptive_stats.tracked_bytes = 0;
+    l2_cache_adaptive_stats.used_bytes = 0;
+}
+
+#if L2_CACHE_DEBUG_FLOAT_ON
+/// Fraction of the bytes fetched which were used
+static inline float l2_cache_adaptive_efficiency(void)
+{
+    return ((float)l2_cache_adaptive_stats.used_bytes)/l2_cache_adaptive_stats.tracked_bytes;
+}
+
+/// Flash time for each byte fetched which was used, in reference clock ticks
+static inline float l2_cache_adaptive_ticks_per_useful_byte(void)
+{
+    return ((float)l2_cache_adaptive_stats.flash_ticks)
+            / (l2_cache_adaptive_stats.fetched_bytes * l2_cache_adaptive_efficiency());
+}
+#else
+/// Percentage of the bytes fetched which were used
+static inline uint32_t l2_cache_adaptive_efficiency(void)
+{
+    const uint32_t tracked = l2_cache_adaptive_stats.tracked_bytes;
+    return tracked? (uint32_t)(((uint64_t)l2_cache_adaptive_stats.used_bytes*100)/tracked) : 0;
+}
+
+/// Flash time for each KiB fetched which was used, in reference clock ticks
+static inline uint32_t l2_cache_adaptive_ticks_per_useful_kib(void)
+{
+    const uint32_t tracked = l2_cache_adaptive_stats.tracked_bytes;
+    const uint64_t useful = tracked? ((uint64_t)l2_cache_adaptive_stats.fetched_bytes
+                                        * l2_cache_adaptive_stats.used_bytes) / tracked : 0;
+    return useful? (uint32_t)(((uint64_t)l2_cache_adaptive_stats.flash_ticks * 1024) / useful) : 0;
+}
+#endif /* L2_CACHE_DEBUG_FLOAT_ON */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L2_CACHE_ADAPTIVE_FETCH_ON */
+
+#endif /* L2_CACHE_ADAPTIVE_H_ */
@@ -12,4 +12,28 @@
 #error L2_CACHE_LINE_SIZE_LOG2 must be at least 6!
 #endif
 
+#if (L2_CACHE_SWMEM_ADDRESS_BITS > 28)
+#error L2_CACHE_SWMEM_ADDRESS_BITS can be at most 28!
+#endif
+
+#if (L2_CACHE_FLASH_SERVER_QUEUE > 32)
+#error L2_CACHE_FLASH_SERVER_QUEUE can be at most 32!
+#endif
+
+#if (L2_CACHE_ADAPTIVE_MAX_LINES < 1)
+#error L2_CACHE_ADAPTIVE_MAX_LINES must be at least 1!
+#endif
+
+#if L2_CACHE_HEATMAP_HITS_ON && !L2_CACHE_HEATMAP_ON
+#error L2_CACHE_HEATMAP_HITS_ON needs L2_CACHE_HEATMAP_ON!
+#endif
+
+#if (L2_CACHE_SEGMENT_TABLE_BITS > 8)
+#error L2_CACHE_SEGMENT_TABLE_BITS can be at most 8!
+#endif
+
+#if (L2_CACHE_TRANSFORM_MAX_BYTES % 4) != 0
+#error L2_CACHE_TRANSFORM_MAX_BYTES must be a multiple of 4!
+#endif
+
 #endif /* L2_CACHE_CONFIG_CHECKS_H_ */
@@ -7,6 +7,10 @@
 #if L2_CACHE_DEBUG_ON
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern struct {
     volatile uint32_t fill_request_count;
     volatile uint32_t hit_count;
@@ -47,6 +51,10 @@ static inline uint32_t l2_cache_debug_hit_rate(void)
 }
 #endif /* L2_CACHE_DEBUG_FLOAT_ON */
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* L2_CACHE_DEBUG_ON */
 
 #endif /* L2_CACHE_DEBUG_H_ */
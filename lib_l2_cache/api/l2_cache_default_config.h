@@ -42,6 +42,343 @@
 #define L2_CACHE_LINE_COUNT       (64)
 #endif
 
+/**
+ * Number of address bits actually backed by flash in the SwMem window.
+ *
+ * Only the bottom 16 bits of each tag are kept in the tag table, so the tag bits
+ * left over once the line and index bits have been removed from a flash address
+ * must fit in 15 bits:
+ *
+ *   L2_CACHE_SWMEM_ADDRESS_BITS - log2(line_size_bytes) - log2(line_count) <= 15
+ *
+ * l2_cache_setup_*() return -1 for a geometry where they don't.
+ *
+ * The default covers a 16 MiB flash, the most that a 3-byte QSPI address can reach.
+ *
+ * NOTE: Must be at most 28
+ */
+#ifndef L2_CACHE_SWMEM_ADDRESS_BITS
+#define L2_CACHE_SWMEM_ADDRESS_BITS   (24)
+#endif
+
+/**
+ * Most segments handed to the vectored read function in one call.
+ *
+ * Longer batches are split into several calls. Each segment costs 12 bytes of
+ * stack on the cache thread.
+ */
+#ifndef L2_CACHE_FETCH_MAX_SEGMENTS
+#define L2_CACHE_FETCH_MAX_SEGMENTS   (8)
+#endif
+
+/**
+ * Most regions l2_cache_setup_regions() can be given.
+ */
+#ifndef L2_CACHE_MAX_REGIONS
+#define L2_CACHE_MAX_REGIONS   (4)
+#endif
+
+/**
+ * Flag to enable way partitioning of the two-way cache (see l2_cache_two_way_set_partitions()).
+ *
+ * Each miss then calls out to C to pick its way, which costs a little time on every miss.
+ */
+#ifndef L2_CACHE_PARTITION_ON
+#define L2_CACHE_PARTITION_ON   (0)
+#endif /* L2_CACHE_PARTITION_ON */
+
+/**
+ * Most partitions l2_cache_two_way_set_partitions() can be given.
+ */
+#ifndef L2_CACHE_MAX_PARTITIONS
+#define L2_CACHE_MAX_PARTITIONS   (4)
+#endif
+
+/**
+ * Flag to enable the stride prefetcher.
+ *
+ * The prefetcher watches the fill addresses handled by the cache thread, picks out
+ * up to L2_CACHE_PREFETCH_STREAMS streams with a constant stride, and fetches ahead
+ * of each once its stride has repeated L2_CACHE_PREFETCH_CONFIDENCE times.
+ *
+ * NOTE: The prefetcher runs on the cache thread after each fill has been served,
+ *       and needs more stack there (see l2_cache_*.nstackwords).
+ * NOTE: A prefetch is read from flash on the cache thread before it takes the next fill
+ *       request, so a fill requested while it's being read waits for it, as it would
+ *       behind a miss. Prefetching pays off when the thread which asked for the last fill
+ *       has enough to do before it asks for the next, and costs a flash read's wait on the
+ *       next fill when it doesn't.
+ */
+#ifndef L2_CACHE_PREFETCH_ON
+#define L2_CACHE_PREFETCH_ON  (0)
+#endif /* L2_CACHE_PREFETCH_ON */
+
+/**
+ * Number of streams the prefetcher tracks at once.
+ */
+#ifndef L2_CACHE_PREFETCH_STREAMS
+#define L2_CACHE_PREFETCH_STREAMS   (4)
+#endif
+
+/**
+ * log2() of the size of the address region which each stream is keyed by.
+ *
+ * Fills within the same region are assumed to belong to the same stream.
+ */
+#ifndef L2_CACHE_PREFETCH_REGION_BITS
+#define L2_CACHE_PREFETCH_REGION_BITS   (14)
+#endif
+
+/**
+ * Number of times in a row a stride must repeat before prefetches are issued for it.
+ */
+#ifndef L2_CACHE_PREFETCH_CONFIDENCE
+#define L2_CACHE_PREFETCH_CONFIDENCE   (2)
+#endif
+
+/**
+ * Default number of strides ahead of a stream to prefetch.
+ *
+ * Can be changed at runtime with l2_cache_prefetch_set_distance().
+ */
+#ifndef L2_CACHE_PREFETCH_DISTANCE
+#define L2_CACHE_PREFETCH_DISTANCE   (2)
+#endif
+
+/**
+ * Number of recently prefetched lines remembered, to count how many get used.
+ */
+#ifndef L2_CACHE_PREFETCH_TRACKED_LINES
+#define L2_CACHE_PREFETCH_TRACKED_LINES   (8)
+#endif
+
+/**
+ * Flag to enable the constant-fill map (see l2_cache_set_const_map()).
+ *
+ * Each miss is then first looked up in the map, which costs a little time on each miss, and
+ * saves a flash read and a cache line on each one in a constant run.
+ */
+#ifndef L2_CACHE_CONST_MAP_ON
+#define L2_CACHE_CONST_MAP_ON  (0)
+#endif /* L2_CACHE_CONST_MAP_ON */
+
+/**
+ * Flag to enable adaptive fetch size (see l2_cache_adaptive.h).
+ *
+ * Each miss then fetches a run of lines whose length is adjusted, for each region, to how
+ * much of what was fetched there gets used. This replaces the fixed number of lines given
+ * to l2_cache_set_readv(), which becomes the starting point.
+ *
+ * NOTE: Every fill, hit or miss, then costs the cache thread a call to record which part
+ *       of its line was used, which looks at one tracked entry for each way (one for a
+ *       direct-mapped cache, two for a two-way one).
+ */
+#ifndef L2_CACHE_ADAPTIVE_FETCH_ON
+#define L2_CACHE_ADAPTIVE_FETCH_ON  (0)
+#endif /* L2_CACHE_ADAPTIVE_FETCH_ON */
+
+/**
+ * log2() of the size of each region which keeps its own fetch size.
+ */
+#ifndef L2_CACHE_ADAPTIVE_REGION_BITS
+#define L2_CACHE_ADAPTIVE_REGION_BITS   (16)
+#endif
+
+/**
+ * Number of regions whose fetch size is kept at once. The least recently missed is
+ * forgotten to make room for a new one.
+ */
+#ifndef L2_CACHE_ADAPTIVE_REGIONS
+#define L2_CACHE_ADAPTIVE_REGIONS   (4)
+#endif
+
+/**
+ * Most lines fetched on one miss.
+ */
+#ifndef L2_CACHE_ADAPTIVE_MAX_LINES
+#define L2_CACHE_ADAPTIVE_MAX_LINES   (4)
+#endif
+
+/**
+ * Misses in a region between changes to its fetch size.
+ */
+#ifndef L2_CACHE_ADAPTIVE_WINDOW
+#define L2_CACHE_ADAPTIVE_WINDOW   (16)
+#endif
+
+/**
+ * Number of fetched lines whose use is recorded, a power of 2. Lines are kept by the slot
+ * they're in, so with at least as many as the cache has slots each line is counted when
+ * it's evicted; with fewer, slots share entries and a line can be counted early. Each costs
+ * 16 bytes.
+ */
+#ifndef L2_CACHE_ADAPTIVE_TRACKED_LINES
+#define L2_CACHE_ADAPTIVE_TRACKED_LINES   (64)
+#endif
+
+/**
+ * Flag to enable the miss heatmap (see l2_cache_heatmap.h).
+ *
+ * The cache thread then counts each miss against its flash page and its cache set, which
+ * costs a call on each miss. Hits aren't counted unless L2_CACHE_HEATMAP_HITS_ON is set too.
+ */
+#ifndef L2_CACHE_HEATMAP_ON
+#define L2_CACHE_HEATMAP_ON  (0)
+#endif /* L2_CACHE_HEATMAP_ON */
+
+/**
+ * Flag to count hits in the miss heatmap as well. This costs a call on every hit.
+ */
+#ifndef L2_CACHE_HEATMAP_HITS_ON
+#define L2_CACHE_HEATMAP_HITS_ON  (0)
+#endif /* L2_CACHE_HEATMAP_HITS_ON */
+
+/**
+ * log2() of the size of each flash page counted by the heatmap.
+ */
+#ifndef L2_CACHE_HEATMAP_PAGE_BITS
+#define L2_CACHE_HEATMAP_PAGE_BITS   (12)
+#endif
+
+/**
+ * Number of pages counted by the heatmap, from the start of SwMem. Fills beyond them are
+ * counted together.
+ */
+#ifndef L2_CACHE_HEATMAP_PAGES
+#define L2_CACHE_HEATMAP_PAGES   (256)
+#endif
+
+/**
+ * Number of cache sets counted by the heatmap. Sets beyond them share entries (set k is
+ * counted in entry k % L2_CACHE_HEATMAP_SETS).
+ */
+#ifndef L2_CACHE_HEATMAP_SETS
+#define L2_CACHE_HEATMAP_SETS   (64)
+#endif
+
+/**
+ * Flag to enable l2_cache_setup_*_segments(), which spread the line data over several pieces
+ * of SRAM.
+ *
+ * Each fill then finds its line's segment in a small table, which costs a few instructions on
+ * every fill, hit or miss, whichever setup was used.
+ */
+#ifndef L2_CACHE_SEGMENTS_ON
+#define L2_CACHE_SEGMENTS_ON  (0)
+#endif /* L2_CACHE_SEGMENTS_ON */
+
+/**
+ * log2() of the most groups of sets the line data can be split into, each in one segment.
+ * The segment table takes a word for each.
+ */
+#ifndef L2_CACHE_SEGMENT_TABLE_BITS
+#define L2_CACHE_SEGMENT_TABLE_BITS   (4)
+#endif
+
+/**
+ * Flag to enable regions whose lines are decoded on a miss (see l2_cache_region_t.transform).
+ *
+ * Costs nothing on fills in other regions, but a buffer of L2_CACHE_TRANSFORM_MAX_BYTES.
+ */
+#ifndef L2_CACHE_TRANSFORM_ON
+#define L2_CACHE_TRANSFORM_ON  (0)
+#endif /* L2_CACHE_TRANSFORM_ON */
+
+/**
+ * Most encoded bytes read for a line of a region with a transform. The encoded line is read
+ * into a buffer of this size before it's decoded into the cache.
+ */
+#ifndef L2_CACHE_TRANSFORM_MAX_BYTES
+#define L2_CACHE_TRANSFORM_MAX_BYTES   (1024)
+#endif
+
+/**
+ * Flag to enable l2_cache_read().
+ *
+ * l2_cache_read() reads flash from the calling thread, so every flash read the cache
+ * makes is then taken under a hardware lock, and the cache thread publishes when it
+ * is replacing a line. This costs one lock and a little time on each miss.
+ */
+#ifndef L2_CACHE_BULK_READ_ON
+#define L2_CACHE_BULK_READ_ON  (0)
+#endif /* L2_CACHE_BULK_READ_ON */
+
+/**
+ * Most bytes l2_cache_read() reads from flash while holding the flash lock.
+ *
+ * Smaller chunks let the cache thread serve misses sooner during a long read.
+ */
+#ifndef L2_CACHE_BULK_READ_CHUNK_BYTES
+#define L2_CACHE_BULK_READ_CHUNK_BYTES   (4096)
+#endif
+
+/**
+ * Flag to enable the tile streaming API (see l2_cache_stream.h).
+ *
+ * The stream's fetch thread reads flash alongside the cache thread, so every flash read the
+ * cache makes is then taken under a hardware lock, as for l2_cache_read().
+ */
+#ifndef L2_CACHE_STREAM_ON
+#define L2_CACHE_STREAM_ON  (0)
+#endif /* L2_CACHE_STREAM_ON */
+
+/**
+ * Whether every flash read is taken under a hardware lock, so that threads other than the
+ * cache thread can read flash too. Follows from the options which need it.
+ */
+#define L2_CACHE_FLASH_LOCK_ON  (L2_CACHE_BULK_READ_ON || L2_CACHE_STREAM_ON)
+
+/**
+ * Flag to enable l2_cache_query_range().
+ *
+ * The cache thread then publishes when it is replacing a line (as for l2_cache_read()),
+ * which costs a little time on each miss.
+ */
+#ifndef L2_CACHE_QUERY_ON
+#define L2_CACHE_QUERY_ON  (0)
+#endif /* L2_CACHE_QUERY_ON */
+
+/**
+ * Whether the cache thread publishes line replacements in l2_cache_fill_seq, so that other
+ * threads can read the tables while it runs. Follows from the options which need it.
+ */
+#define L2_CACHE_FILL_SEQ_ON  (L2_CACHE_BULK_READ_ON || L2_CACHE_QUERY_ON)
+
+/**
+ * Flag to enable the flash server (see l2_cache_flash_server.h).
+ */
+#ifndef L2_CACHE_FLASH_SERVER_ON
+#define L2_CACHE_FLASH_SERVER_ON  (0)
+#endif /* L2_CACHE_FLASH_SERVER_ON */
+
+/**
+ * Most bytes the flash server reads in one transaction, and the size of its buffer.
+ *
+ * Longer client reads are split up. A miss can wait for one read of this size which is
+ * already under way, so smaller values bound miss latency more tightly.
+ */
+#ifndef L2_CACHE_FLASH_SERVER_BUFFER_BYTES
+#define L2_CACHE_FLASH_SERVER_BUFFER_BYTES   (1024)
+#endif
+
+/**
+ * Most requests the flash server holds at once. Each client has at most one request
+ * outstanding, so this is the most clients which can be considered for each batch.
+ *
+ * NOTE: Must be at most 32
+ */
+#ifndef L2_CACHE_FLASH_SERVER_QUEUE
+#define L2_CACHE_FLASH_SERVER_QUEUE   (8)
+#endif
+
+/**
+ * Number of times an application read can be passed over for cache misses before
+ * it is treated as a miss itself, so that a stream of misses can't starve it.
+ */
+#ifndef L2_CACHE_FLASH_SERVER_APP_SKIPS
+#define L2_CACHE_FLASH_SERVER_APP_SKIPS   (8)
+#endif
+
 /**
  * Flags to enable debug
  */
@@ -0,0 +1,110 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_FLASH_SERVER_H_
+#define L2_CACHE_FLASH_SERVER_H_
+
+#if L2_CACHE_FLASH_SERVER_ON
+#include <stddef.h>
+#include <xcore/chanend.h>
+
+#include "l2_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Flash server: one thread which owns the flash and reads it on behalf of clients anywhere
+ * in the system, so that caches on several tiles and the application can share one flash.
+ *
+ * Clients send read requests over channels to a single server chanend. The server takes
+ * cache misses before application reads, and reads requests for adjacent (or overlapping)
+ * flash together as one transaction. No read is longer than L2_CACHE_FLASH_SERVER_BUFFER_BYTES,
+ * so a miss never waits behind more than one such read (plus any other misses queued ahead).
+ *
+ * The server and each client only need the ID of the server's chanend, which can be passed
+ * between tiles like any other word. For example, on the tile with the flash:
+ *
+ *   chanend_t server = chanend_alloc();
+ *   run_async(server_thread, (void*) server, stack);   // calls l2_cache_flash_server()
+ *
+ * and on any tile, before its cache thread is started:
+ *
+ *   l2_cache_flash_server_connect(server);
+ *   l2_cache_setup_two_way(..., l2_cache_flash_server_read);
+ */
+
+/// Priority of reads made by the L2 cache
+#define L2_CACHE_FLASH_PRIORITY_MISS    (1)
+/// Priority of other reads
+#define L2_CACHE_FLASH_PRIORITY_APP     (0)
+
+/**
+ * One client of a flash server. Each thread reading through the server needs its own
+ * (or must not read at the same time as another thread using the same one).
+ */
+typedef struct {
+    chanend_t c;        /// connected to the server
+    unsigned priority;  /// L2_CACHE_FLASH_PRIORITY_*
+} l2_cache_flash_client_t;
+
+/**
+ * Serve flash reads from the clients of chanend `c`, using `read_func` to read the flash.
+ *
+ * Never returns.
+ */
+void l2_cache_flash_server(
+    const chanend_t c,
+    l2_cache_swmem_read_fn read_func);
+
+/**
+ * Allocate a chanend for a client and connect it to the server chanend `server`.
+ */
+void l2_cache_flash_client_init(
+    l2_cache_flash_client_t* client,
+    const chanend_t server,
+    const unsigned priority);
+
+/**
+ * Free a client's chanend.
+ */
+void l2_cache_flash_client_free(
+    l2_cache_flash_client_t* client);
+
+/**
+ * Read `bytes` bytes of flash from `src` to `dst` through the server, waiting until they've
+ * arrived. Long reads are split into L2_CACHE_FLASH_SERVER_BUFFER_BYTES requests.
+ */
+void l2_cache_flash_client_read(
+    const l2_cache_flash_client_t* client,
+    void* dst,
+    const void* src,
+    const size_t bytes);
+
+/**
+ * Connect this tile's L2 cache to the server chanend `server`, as a client with
+ * L2_CACHE_FLASH_PRIORITY_MISS.
+ *
+ * NOTE: Must be called before l2_cache_flash_server_read() is used (by the setup or by the
+ *       cache thread).
+ */
+void l2_cache_flash_server_connect(
+    const chanend_t server);
+
+/**
+ * Read function for l2_cache_setup_*() which reads through the flash server.
+ */
+L2_CACHE_SWMEM_READ_FN
+void l2_cache_flash_server_read(
+    void* dst,
+    const void* src,
+    const size_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L2_CACHE_FLASH_SERVER_ON */
+
+#endif /* L2_CACHE_FLASH_SERVER_H_ */
@@ -0,0 +1,73 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_HEATMAP_H_
+#define L2_CACHE_HEATMAP_H_
+
+#if L2_CACHE_HEATMAP_ON
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Misses remembered in each set for spotting refetches; enough to see lines taking turns
+/// in a two-way set
+#define L2_CACHE_HEATMAP_RECENT   (4)
+
+/*
+  With L2_CACHE_HEATMAP_ON, the cache thread counts each miss read from flash against its
+  flash page (1 << L2_CACHE_HEATMAP_PAGE_BITS bytes) and its cache set, in fixed tables, so a
+  unit in the field can report where its misses come from without a fill trace.
+
+  A set's refetches are misses on a line which missed in that set within its last
+  L2_CACHE_HEATMAP_RECENT misses, so was evicted again soon after it was read: a set with many
+  is overloaded. The counters stop at 0xFFFF rather than wrap.
+
+  Fills served from the constant map (l2_cache_set_const_map()) aren't counted.
+*/
+
+typedef struct {
+    uint16_t misses;
+    uint16_t hits;      /// with L2_CACHE_HEATMAP_HITS_ON
+} l2_cache_heatmap_page_t;
+
+typedef struct {
+    uint16_t misses;
+    uint16_t refetches;
+    uint32_t recent[L2_CACHE_HEATMAP_RECENT];  /// line addresses of the set's last misses, newest first
+} l2_cache_heatmap_set_t;
+
+extern struct {
+    /// Page k covers SwMem offsets k << L2_CACHE_HEATMAP_PAGE_BITS onwards
+    l2_cache_heatmap_page_t page[L2_CACHE_HEATMAP_PAGES];
+    /// ...and this everything beyond the last page
+    l2_cache_heatmap_page_t beyond;
+
+    /// Set k is counted in entry k % L2_CACHE_HEATMAP_SETS
+    l2_cache_heatmap_set_t set[L2_CACHE_HEATMAP_SETS];
+} l2_cache_heatmap;
+
+/**
+ * Zero the heatmap. The cache may be running.
+ */
+void l2_cache_heatmap_reset(void);
+
+/**
+ * Print every page and set with any counts, one per line, with debug_printf() (over xScope,
+ * if the application has set that up):
+ *
+ *   L2 heatmap page 0x40003000: 120 misses, 4410 hits
+ *   L2 heatmap set 17: 95 misses, 60 refetches
+ *
+ * Pages beyond the last are printed as one, with the first address beyond.
+ */
+void l2_cache_heatmap_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L2_CACHE_HEATMAP_ON */
+
+#endif /* L2_CACHE_HEATMAP_H_ */
@@ -0,0 +1,71 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_PREFETCH_H_
+#define L2_CACHE_PREFETCH_H_
+
+#if L2_CACHE_PREFETCH_ON
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern struct {
+    volatile uint32_t miss_count;     /// fills which had to wait for flash
+    volatile uint32_t issued_count;   /// lines fetched by the prefetcher
+    volatile uint32_t useful_count;   /// prefetched lines which were later filled from
+} l2_cache_prefetch_stats;
+
+/**
+ * Set how many strides ahead of each stream the prefetcher fetches.
+ *
+ * 0 turns prefetching off, while still training the streams.
+ */
+void l2_cache_prefetch_set_distance(
+    const unsigned distance);
+
+static inline void l2_cache_prefetch_stats_reset(void)
+{
+    l2_cache_prefetch_stats.miss_count = 0;
+    l2_cache_prefetch_stats.issued_count = 0;
+    l2_cache_prefetch_stats.useful_count = 0;
+}
+
+#if L2_CACHE_DEBUG_FLOAT_ON
+/// Fraction of prefetched lines which were used
+static inline float l2_cache_prefetch_accuracy(void)
+{
+    return ((float)l2_cache_prefetch_stats.useful_count)/l2_cache_prefetch_stats.issued_count;
+}
+
+/// Fraction of would-be misses which the prefetcher turned into hits
+static inline float l2_cache_prefetch_coverage(void)
+{
+    return ((float)l2_cache_prefetch_stats.useful_count)
+            / (l2_cache_prefetch_stats.useful_count + l2_cache_prefetch_stats.miss_count);
+}
+#else
+/// Percentage of prefetched lines which were used
+static inline uint32_t l2_cache_prefetch_accuracy(void)
+{
+    const uint32_t issued = l2_cache_prefetch_stats.issued_count;
+    return issued? (uint32_t)(((uint64_t)l2_cache_prefetch_stats.useful_count*100)/issued) : 0;
+}
+
+/// Percentage of would-be misses which the prefetcher turned into hits
+static inline uint32_t l2_cache_prefetch_coverage(void)
+{
+    const uint32_t useful = l2_cache_prefetch_stats.useful_count;
+    const uint32_t total = useful + l2_cache_prefetch_stats.miss_count;
+    return total? (uint32_t)(((uint64_t)useful*100)/total) : 0;
+}
+#endif /* L2_CACHE_DEBUG_FLOAT_ON */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L2_CACHE_PREFETCH_ON */
+
+#endif /* L2_CACHE_PREFETCH_H_ */
@@ -0,0 +1,84 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_REF_H_
+#define L2_CACHE_REF_H_
+
+#include "l2_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+  Portable C reference versions of the cache engines.
+
+  These do exactly what l2_cache_direct_map() and l2_cache_two_way() do for each fill, and
+  use the same config and tables (so l2_cache_setup_*() and l2_cache_*_get_addr_info() work
+  with them unchanged), but take their fill requests from an l2_cache_fill_source_t instead
+  of the SwMem fill resource. They build on any target, which lets the cache logic be tested
+  on a host machine (see tests/host).
+
+  They are much slower than the assembly engines, and aren't meant for production use.
+*/
+
+typedef struct l2_cache_fill_source_t l2_cache_fill_source_t;
+
+#define L2_CACHE_FILL_NEXT_FN      __attribute__((fptrgroup("l2_cache_fill_next_fptr_grp")))
+#define L2_CACHE_FILL_COMPLETE_FN  __attribute__((fptrgroup("l2_cache_fill_complete_fptr_grp")))
+
+/**
+ * Where a reference engine gets fill requests from, and hands the filled data to.
+ */
+struct l2_cache_fill_source_t {
+  /// Wait for the next fill request and return its (32-byte aligned) address, or 0 to stop
+  L2_CACHE_FILL_NEXT_FN
+  unsigned (*next)(l2_cache_fill_source_t* source);
+
+  /// Complete the fill request at `fill_addr` with the 32 bytes at `data`
+  L2_CACHE_FILL_COMPLETE_FN
+  void (*complete)(l2_cache_fill_source_t* source, const unsigned fill_addr, const void* data);
+
+  void* context;
+};
+
+/**
+ * Serve a single fill request exactly as l2_cache_direct_map() would, and return the 32 bytes
+ * of data for it.
+ */
+const void* l2_cache_direct_map_ref_fill(
+    const unsigned fill_addr);
+
+/**
+ * Serve a single fill request exactly as l2_cache_two_way() would, and return the 32 bytes
+ * of data for it.
+ */
+const void* l2_cache_two_way_ref_fill(
+    const unsigned fill_addr);
+
+/**
+ * Serve fill requests from `source` with l2_cache_direct_map_ref_fill() until it returns 0.
+ */
+void l2_cache_direct_map_ref(
+    l2_cache_fill_source_t* source);
+
+/**
+ * Serve fill requests from `source` with l2_cache_two_way_ref_fill() until it returns 0.
+ */
+void l2_cache_two_way_ref(
+    l2_cache_fill_source_t* source);
+
+#if defined(__XS3A__)
+/**
+ * Drop-in replacements for l2_cache_direct_map() and l2_cache_two_way() which serve real
+ * SwMem fills with the reference engines. Never return.
+ */
+void l2_cache_direct_map_ref_swmem(void*);
+void l2_cache_two_way_ref_swmem(void*);
+#endif // defined(__XS3A__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // L2_CACHE_REF_H_
@@ -0,0 +1,110 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_STREAM_H_
+#define L2_CACHE_STREAM_H_
+
+#if L2_CACHE_STREAM_ON
+#include <stddef.h>
+#include <xcore/chanend.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Tile streaming: for data read in an order known in advance (e.g. a layer's weights, tile by
+ * tile), a fetch thread reads each tile from flash into one of two SRAM buffers while the
+ * application works on the tile in the other, instead of each one missing in the cache.
+ *
+ * Tiles are read with the cache's read function, under the same lock as the cache's misses,
+ * so the cache must be set up first. They bypass the cache, so don't evict its working set.
+ *
+ *   l2_cache_stream_init(&stream, tiles, tile_count, buffer_a, buffer_b);
+ *   run_async(l2_cache_stream_thread, &stream, stack);
+ *
+ *   const void* tile;
+ *   while((tile = l2_cache_stream_acquire(&stream)) != NULL) {
+ *       compute(tile);
+ *       l2_cache_stream_release(&stream);    // its buffer now takes the tile after next
+ *   }
+ *
+ *   l2_cache_stream_free(&stream);
+ *
+ * The fetch thread returns once the last tile has been released. To go through the tiles
+ * again, initialise the stream again and start another fetch thread.
+ */
+
+/**
+ * One tile: `bytes` bytes at `src`, a SwMem address.
+ */
+typedef struct {
+    const void* src;
+    size_t bytes;
+} l2_cache_stream_tile_t;
+
+/**
+ * A stream of tiles. Only touch it through the functions below.
+ */
+typedef struct {
+    const l2_cache_stream_tile_t* tile;
+    unsigned count;
+    void* buffer[2];
+
+    unsigned acquired;      /// tiles handed to the application
+    unsigned released;      /// ...and given back
+
+    chanend_t app_end;      /// tile i ready: fetch thread -> application
+    chanend_t fetch_end;    /// tile i released: application -> fetch thread
+
+    /// Reference clock ticks the application has spent waiting in l2_cache_stream_acquire().
+    /// Zero when every read was hidden behind the work on the tile before.
+    unsigned wait_ticks;
+} l2_cache_stream_t;
+
+/**
+ * Set up a stream over `count` tiles, read into `buffer_a` and `buffer_b` in turn. Each
+ * buffer must hold the largest tile. `tiles` must stay valid until the stream is freed.
+ */
+void l2_cache_stream_init(
+    l2_cache_stream_t* stream,
+    const l2_cache_stream_tile_t tiles[],
+    const unsigned count,
+    void* buffer_a,
+    void* buffer_b);
+
+/**
+ * The fetch thread: reads the tiles in order, each as soon as a buffer is free. Returns once
+ * every tile has been released.
+ */
+void l2_cache_stream_thread(
+    void* stream);
+
+/**
+ * Wait until the next tile is in its buffer, and return the buffer. Returns NULL once every
+ * tile has been acquired.
+ *
+ * NOTE: The application holds one tile at a time; release it before acquiring the next.
+ */
+const void* l2_cache_stream_acquire(
+    l2_cache_stream_t* stream);
+
+/**
+ * Give back the tile last acquired, so its buffer can be refilled.
+ */
+void l2_cache_stream_release(
+    l2_cache_stream_t* stream);
+
+/**
+ * Free the stream's chanends, once every tile has been acquired and released.
+ */
+void l2_cache_stream_free(
+    l2_cache_stream_t* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* L2_CACHE_STREAM_ON */
+
+#endif /* L2_CACHE_STREAM_H_ */
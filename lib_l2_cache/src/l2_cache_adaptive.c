@@ -0,0 +1,331 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+#include <xcore/hwtimer.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+/*
+
+Region table
+
+  Region | Fetch Lines | Next Addr | Misses | Run Misses | Fetched Parts | Used Parts | Last Seen
+  -------------------------------------------------------------------------------------------
+   ...   |     ...     |    ...    |  ...   |    ...     |      ...      |    ...     |    ...
+
+  Region: Line address >> L2_CACHE_ADAPTIVE_REGION_BITS
+  Fetch Lines: Lines fetched on each miss in the region
+  Next Addr: The line after the last run fetched; a miss there means the run was too short
+  Misses, Run Misses: Misses since the last decision, and how many of them were at Next Addr
+  Fetched Parts, Used Parts: Parts of the tracked lines retired since the last decision, and
+                             how many of them were filled from
+  Last Seen: When the region last missed; the least recently seen entry is replaced
+
+  A part is 32 bytes (one fill), or 1/32 of a line for lines over 1 KiB, so a line's parts
+  fit in one word.
+
+Tracked lines
+
+  The lines fetched on a miss, by the slot they're held in (slot & (TRACKED_LINES - 1)), each
+  with a bit for every part which has been filled from. A line is retired, and its parts
+  counted, when a later miss fetches another line into its entry, i.e. once it has been
+  evicted (or, with more slots than entries, when a slot sharing its entry is fetched into).
+
+  A fill looks only at the entries of the slots its line could be in, one for each way.
+
+*/
+
+#define PART_BITS(LINE_BITS)    (((LINE_BITS) > 10)? (LINE_BITS) - 5 : 5)
+
+typedef struct {
+    unsigned region;
+    unsigned fetch_lines;
+    unsigned next_addr;
+    unsigned misses;
+    unsigned run_misses;
+    unsigned fetched_parts;
+    unsigned used_parts;
+    unsigned last_seen;
+} region_t;
+
+typedef struct {
+    unsigned line_addr;     /// 0 when not in use
+    region_t* region;       /// the region it was fetched for...
+    unsigned region_key;    /// ...unless that entry has since been given to another region
+    uint32_t used;
+} tracked_t;
+
+static struct {
+    region_t region[L2_CACHE_ADAPTIVE_REGIONS];
+    unsigned tick;          /// misses seen, wrapping (harmlessly) after 2^32
+
+    tracked_t tracked[L2_CACHE_ADAPTIVE_TRACKED_LINES];
+} adaptive;
+
+#if (L2_CACHE_ADAPTIVE_TRACKED_LINES & (L2_CACHE_ADAPTIVE_TRACKED_LINES - 1)) != 0
+#error L2_CACHE_ADAPTIVE_TRACKED_LINES must be a power of 2
+#endif
+
+__typeof__(l2_cache_adaptive_stats) l2_cache_adaptive_stats;
+
+
+static unsigned initial_fetch_lines(void)
+{
+    const unsigned lines = l2_cache_engine.miss_fetch_lines;
+    return (lines > L2_CACHE_ADAPTIVE_MAX_LINES)? L2_CACHE_ADAPTIVE_MAX_LINES : lines;
+}
+
+
+static region_t* find_region(
+    const unsigned key)
+{
+    for(int k = 0; k < L2_CACHE_ADAPTIVE_REGIONS; k++) {
+        region_t* r = &adaptive.region[k];
+
+        if(r->last_seen != 0 && r->region == key)
+            return r;
+    }
+
+    return NULL;
+}
+
+
+static region_t* claim_region(
+    const unsigned key)
+{
+    adaptive.tick++;
+
+    region_t* r = find_region(key);
+
+    if(r == NULL) {
+        // Unused entries were last seen at 0, so they're always picked first
+        r = &adaptive.region[0];
+        for(int k = 1; k < L2_CACHE_ADAPTIVE_REGIONS; k++) {
+            if(adaptive.region[k].last_seen < r->last_seen)
+                r = &adaptive.region[k];
+        }
+
+        r->region = key;
+        r->fetch_lines = initial_fetch_lines();
+        r->next_addr = 0;
+        r->misses = 0;
+        r->run_misses = 0;
+        r->fetched_parts = 0;
+        r->used_parts = 0;
+    }
+
+    r->last_seen = adaptive.tick;
+    return r;
+}
+
+
+static void retire(
+    tracked_t* t)
+{
+    if(t->line_addr == 0)
+        return;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned part_bits = PART_BITS(line_bits);
+    const unsigned used = __builtin_popcount(t->used);
+
+    l2_cache_adaptive_stats.tracked_bytes += 1 << line_bits;
+    l2_cache_adaptive_stats.used_bytes += used << part_bits;
+
+    if(t->region->region == t->region_key) {
+        t->region->fetched_parts += 1 << (line_bits - part_bits);
+        t->region->used_parts += used;
+    }
+
+    t->line_addr = 0;
+}
+
+
+// The slot a line would be in if it were in `way`
+static unsigned way_slot(
+    const unsigned line_addr,
+    const unsigned way)
+{
+    const unsigned set_count = l2_cache_engine.set_count;
+
+    return way * set_count + ((line_addr >> l2_cache_engine.line_bits) & (set_count - 1));
+}
+
+
+static tracked_t* slot_entry(
+    const unsigned slot)
+{
+    return &adaptive.tracked[slot & (L2_CACHE_ADAPTIVE_TRACKED_LINES - 1)];
+}
+
+
+// Start tracking a line which a miss has just fetched
+static void track(
+    const unsigned line_addr,
+    region_t* r)
+{
+    const unsigned ways = l2_cache_engine.slot_count / l2_cache_engine.set_count;
+    tracked_t* t = NULL;
+
+    for(int way = 0; way < ways; way++) {
+        const unsigned slot = way_slot(line_addr, way);
+        tracked_t* e = slot_entry(slot);
+
+        // An earlier copy of the line, evicted since, in another way
+        if(e->line_addr == line_addr)
+            retire(e);
+
+        if(l2_cache_engine.line_at(slot) == line_addr)
+            t = e;
+    }
+
+    DEBUG_ASSERT( t != NULL );
+
+    // Whatever was tracked here has been evicted
+    retire(t);
+
+    t->line_addr = line_addr;
+    t->region = r;
+    t->region_key = r->region;
+    t->used = 0;
+}
+
+
+static void decide(
+    region_t* r)
+{
+    if(r->run_misses * 2 >= r->misses) {
+        // Most misses carried straight on from the last run, so fetch longer runs
+        if(r->fetch_lines < L2_CACHE_ADAPTIVE_MAX_LINES)
+            r->fetch_lines *= 2;
+        if(r->fetch_lines > L2_CACHE_ADAPTIVE_MAX_LINES)
+            r->fetch_lines = L2_CACHE_ADAPTIVE_MAX_LINES;
+    } else if(r->used_parts * 2 < r->fetched_parts && r->fetch_lines > 1) {
+        // Most of what was fetched went unused
+        r->fetch_lines /= 2;
+    }
+
+    DEBUG_PRINT("Adaptive: region 0x%08X, %u/%u run misses, %u/%u parts used, fetching %u lines\n",
+                r->region << L2_CACHE_ADAPTIVE_REGION_BITS, r->run_misses, r->misses,
+                r->used_parts, r->fetched_parts, r->fetch_lines);
+
+    r->misses = 0;
+    r->run_misses = 0;
+    r->fetched_parts = 0;
+    r->used_parts = 0;
+}
+
+
+void l2_cache_adaptive_fetch(
+    void* dst,
+    const unsigned line_addr)
+{
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned line_bytes = 1 << line_bits;
+
+    region_t* r = claim_region(line_addr >> L2_CACHE_ADAPTIVE_REGION_BITS);
+
+    r->misses++;
+    if(line_addr == r->next_addr)
+        r->run_misses++;
+
+    // Cut short exactly as l2_cache_fetch_lines() would
+    unsigned lines = r->fetch_lines;
+
+    if(lines > l2_cache_engine.set_count)
+        lines = l2_cache_engine.set_count;
+
+    if(lines > (SWMEM_END - line_addr) / line_bytes)
+        lines = (SWMEM_END - line_addr) / line_bytes;
+
+    // Only the lines which aren't cached yet get read (the first has already been claimed)
+    unsigned fetch_addr[L2_CACHE_ADAPTIVE_MAX_LINES];
+    unsigned fetched = 0;
+    unsigned addr = line_addr;
+
+    for(int k = 0; k < lines; k++, addr += line_bytes) {
+        if(k == 0 || l2_cache_engine.lookup(addr) == NULL)
+            fetch_addr[fetched++] = addr;
+    }
+
+    const unsigned start = get_reference_time();
+    l2_cache_fetch_lines(line_addr, lines, dst);
+    l2_cache_adaptive_stats.flash_ticks += get_reference_time() - start;
+
+    // Now that they have slots
+    for(int k = 0; k < fetched; k++)
+        track(fetch_addr[k], r);
+
+    l2_cache_adaptive_stats.miss_count++;
+    l2_cache_adaptive_stats.fetched_bytes += fetched << line_bits;
+
+    r->next_addr = line_addr + (lines << line_bits);
+
+    if(r->misses >= L2_CACHE_ADAPTIVE_WINDOW)
+        decide(r);
+}
+
+
+/**
+ * Called by the cache thread once each fill has been served, hit or miss. This is on every
+ * hit's path, so it looks at one entry for each way and nothing else.
+ */
+void l2_cache_adaptive_observe(
+    const unsigned fill_addr)
+{
+    // Nothing has been filled yet, or there's no single engine (e.g. a region cache)
+    if(fill_addr == 0 || l2_cache_engine.claim == NULL)
+        return;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned line_addr = (fill_addr >> line_bits) << line_bits;
+    const unsigned ways = l2_cache_engine.slot_count / l2_cache_engine.set_count;
+
+    for(int way = 0; way < ways; way++) {
+        tracked_t* t = slot_entry(way_slot(line_addr, way));
+
+        if(t->line_addr == line_addr) {
+            t->used |= 1u << ((fill_addr - line_addr) >> PART_BITS(line_bits));
+            return;
+        }
+    }
+}
+
+
+unsigned l2_cache_adaptive_fetch_lines(
+    const void* address)
+{
+    const region_t* r = find_region(((unsigned) address) >> L2_CACHE_ADAPTIVE_REGION_BITS);
+
+    return (r != NULL)? r->fetch_lines : initial_fetch_lines();
+}
+
+
+void l2_cache_adaptive_reset(void)
+{
+    for(int k = 0; k < L2_CACHE_ADAPTIVE_REGIONS; k++) {
+        adaptive.region[k].last_seen = 0;
+    }
+
+    for(int k = 0; k < L2_CACHE_ADAPTIVE_TRACKED_LINES; k++) {
+        adaptive.tracked[k].line_addr = 0;
+    }
+
+    adaptive.tick = 0;
+}
+
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
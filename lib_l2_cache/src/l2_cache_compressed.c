@@ -0,0 +1,382 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+#include <xclib.h>
+#include <xcore/swmem_fill.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define FILL_BYTES  (32)
+#define FILL_WORDS  (FILL_BYTES / sizeof(uint32_t))
+
+// Index entry of a line with no record
+#define NO_RECORD   (0xFFFF)
+
+/*
+  Each cached line is a record in the pool, which is filled like a ring: records are written
+  at the head, and the oldest are dropped from the tail to make room. A record is
+
+    word 0:   line address
+    word 1:   record size in words
+    then:     one mask word for each 32-byte block of the line, bit k set if byte k isn't 0
+    then:     the word offset (from the record's start) of each block's bytes, 16 bits each,
+              padded to a word
+    then:     each block's non-zero bytes, in order, padded to a word
+
+  so any block can be expanded without looking at the others. A block of all zeros takes no
+  bytes, and a block with no zeros is its own 32 bytes, which a fill can be served from
+  where they are.
+
+  A line's index entry is the pool offset of its record (or NO_RECORD), and the record's line
+  address says whether it still holds that line.
+*/
+
+static struct {
+    swmem_fill_t swmem_fill_handle;
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn read_func;
+    uint16_t* index;          /// record offset for each line index
+    uint32_t* staging;        /// a line as read from flash
+    uint32_t* pool;
+    unsigned pool_words;
+    unsigned head;            /// where the next record goes
+    unsigned tail;            /// the oldest record
+    unsigned wrap_at;         /// with wrapped, the end of the records after the tail
+    unsigned wrapped;         /// whether the head has gone back to the start of the pool
+    unsigned index_mask;
+    unsigned line_bits;
+    unsigned blocks;          /// 32-byte blocks per line
+    unsigned held;            /// lines held
+} compressed;
+
+// Served for any block of zeros
+static const uint32_t zero_block[FILL_WORDS] = { 0 };
+
+
+static inline unsigned index_of(
+    const unsigned line_addr)
+{
+    return (line_addr >> compressed.line_bits) & compressed.index_mask;
+}
+
+
+static inline const uint16_t* block_offsets(
+    const uint32_t* record)
+{
+    return (const uint16_t*) &record[2 + compressed.blocks];
+}
+
+
+// Drop the oldest record
+static void drop_tail(void)
+{
+    const uint32_t* record = &compressed.pool[compressed.tail];
+    const unsigned index = index_of(record[0]);
+
+    if(compressed.index[index] == compressed.tail) {
+        compressed.index[index] = NO_RECORD;
+        compressed.held--;
+    }
+
+    compressed.tail += record[1];
+
+    if(compressed.tail == compressed.wrap_at) {
+        compressed.tail = 0;
+        compressed.wrapped = 0;
+    }
+}
+
+
+// Room for a record of `words` words at the head, dropping the oldest records to make it
+static uint32_t* pool_alloc(
+    const unsigned words)
+{
+    while(1) {
+        if(!compressed.wrapped) {
+            // Nothing held, so start again at the front
+            if(compressed.tail == compressed.head)
+                compressed.head = compressed.tail = 0;
+
+            if(compressed.pool_words - compressed.head >= words)
+                break;
+
+            compressed.wrap_at = compressed.head;
+            compressed.head = 0;
+            compressed.wrapped = 1;
+        } else {
+            if(compressed.tail - compressed.head >= words)
+                break;
+
+            drop_tail();
+        }
+    }
+
+    uint32_t* record = &compressed.pool[compressed.head];
+    compressed.head += words;
+    return record;
+}
+
+
+// Non-zero bytes of a 32-byte block, as a mask
+static inline uint32_t block_mask(
+    const uint8_t* block)
+{
+    uint32_t mask = 0;
+
+    for(int k = 0; k < FILL_BYTES; k++) {
+        if(block[k])
+            mask |= 1u << k;
+    }
+
+    return mask;
+}
+
+
+// Words the non-zero bytes of a block with this mask take
+static inline unsigned block_words(
+    const uint32_t mask)
+{
+    unsigned bytes = 0;
+
+    for(uint32_t m = mask; m; m &= m - 1)
+        bytes++;
+
+    return (bytes + 3) / 4;
+}
+
+
+// Store the line in the staging buffer as a record
+static void store_line(
+    const unsigned line_addr)
+{
+    const uint8_t* line = (const uint8_t*) compressed.staging;
+    const unsigned blocks = compressed.blocks;
+    const unsigned header_words = 2 + blocks + (blocks + 1) / 2;
+
+    unsigned words = header_words;
+
+    for(int b = 0; b < blocks; b++)
+        words += block_words(block_mask(&line[b * FILL_BYTES]));
+
+    // The line's old record (if any) no longer holds it; its room goes when it's dropped
+    const unsigned index = index_of(line_addr);
+
+    if(compressed.index[index] != NO_RECORD) {
+        compressed.index[index] = NO_RECORD;
+        compressed.held--;
+    }
+
+    uint32_t* record = pool_alloc(words);
+    uint16_t* offset = (uint16_t*) &record[2 + blocks];
+
+    record[0] = line_addr;
+    record[1] = words;
+
+    unsigned at = header_words;
+
+    for(int b = 0; b < blocks; b++) {
+        const uint8_t* src = &line[b * FILL_BYTES];
+        uint8_t* dst = (uint8_t*) &record[at];
+        const uint32_t mask = block_mask(src);
+
+        record[2 + b] = mask;
+        offset[b] = at;
+
+        if(mask == 0xFFFFFFFF) {
+            memcpy(dst, src, FILL_BYTES);
+        } else {
+            for(int k = 0; k < FILL_BYTES; k++) {
+                if(src[k])
+                    *dst++ = src[k];
+            }
+        }
+
+        at += block_words(mask);
+    }
+
+    DEBUG_ASSERT( at == words );
+
+    compressed.index[index] = record - compressed.pool;
+    compressed.held++;
+}
+
+
+// Bytes set in each 4-bit slice of a block mask
+static const uint8_t nibble_bytes[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+
+// The low bytes of `bytes`, one to each byte of a word whose bit is set in `nibble`
+static inline uint32_t spread_bytes(
+    uint32_t bytes,
+    unsigned nibble)
+{
+    uint32_t word = 0;
+
+    for(unsigned shift = 0; nibble; nibble >>= 1, shift += 8) {
+        if(nibble & 1) {
+            word |= (bytes & 0xFF) << shift;
+            bytes >>= 8;
+        }
+    }
+
+    return word;
+}
+
+
+// The 32 bytes of a block of a record
+static const void* expand_block(
+    const uint32_t* record,
+    const unsigned block)
+{
+    static uint32_t expanded[FILL_WORDS];
+
+    const uint32_t mask = record[2 + block];
+    const uint32_t* src = &record[block_offsets(record)[block]];
+
+    if(mask == 0)
+        return zero_block;
+    if(mask == 0xFFFFFFFF)
+        return src;
+
+    // A word at a time: its slice of the mask says how many of the packed bytes it takes, and
+    // they're read with (at most two) word loads, never past the word holding the last
+    unsigned at = 0;
+
+    for(int k = 0; k < FILL_WORDS; k++) {
+        const unsigned nibble = (mask >> (4 * k)) & 0xF;
+        const unsigned count = nibble_bytes[nibble];
+
+        if(count == 0) {
+            expanded[k] = 0;
+            continue;
+        }
+
+        const unsigned shift = 8 * (at & 3);
+        uint32_t bytes = src[at >> 2] >> shift;
+
+        if((at & 3) + count > 4)
+            bytes |= src[(at >> 2) + 1] << (32 - shift);
+
+        expanded[k] = (count == 4)? bytes : spread_bytes(bytes, nibble);
+        at += count;
+    }
+
+    return expanded;
+}
+
+
+const void* l2_cache_compressed_fill(
+    const unsigned fill_addr)
+{
+    const unsigned line_addr = fill_addr & ~((1 << compressed.line_bits) - 1);
+    const unsigned block = (fill_addr - line_addr) / FILL_BYTES;
+    const unsigned offset = compressed.index[index_of(line_addr)];
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.fill_request_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+    if(offset != NO_RECORD && compressed.pool[offset] == line_addr) {
+#if L2_CACHE_DEBUG_ON
+        l2_cache_debug_stats.hit_count++;
+#endif // L2_CACHE_DEBUG_ON
+        return expand_block(&compressed.pool[offset], block);
+    }
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.miss_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+    // Served straight from the line as read, which is then kept compressed
+    compressed.read_func(compressed.staging, (const void*) line_addr, 1 << compressed.line_bits);
+    store_line(line_addr);
+
+    return &compressed.staging[block * FILL_WORDS];
+}
+
+
+void l2_cache_compressed(void* unused)
+{
+#if defined(__XS3A__)
+    const swmem_fill_t swmem = compressed.swmem_fill_handle;
+
+    while(1) {
+        const fill_slot_t fill_addr = swmem_fill_in(swmem);
+        swmem_fill_populate_from_buffer(swmem, fill_addr,
+                                        (const uint32_t*) l2_cache_compressed_fill(fill_addr));
+    }
+#endif // defined(__XS3A__)
+}
+
+
+unsigned l2_cache_compressed_lines_held(void)
+{
+    return compressed.held;
+}
+
+
+L2_CACHE_SETUP_FN_ATTR
+int l2_cache_setup_compressed(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    const unsigned pool_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func)
+{
+    const unsigned line_bits = 31 - clz(line_size_bytes);
+    const unsigned blocks = line_size_bytes / FILL_BYTES;
+
+    DEBUG_ASSERT( line_size_bytes >= FILL_BYTES ); // minimum line size is 32 bytes
+    DEBUG_ASSERT( (1 << line_bits) == line_size_bytes ); // line_size_bytes is a power of 2
+    DEBUG_ASSERT( (line_count & (line_count - 1)) == 0 ); // line_count is a power of 2
+    DEBUG_ASSERT( (((unsigned) cache_buffer) & 0x3) == 0 ); // cache_buffer is word-aligned
+
+    // Record offsets must fit in the 16-bit index (short of NO_RECORD), and even a line with
+    // no zeros in it must fit in the pool. Neither can be caught at compile time, and either
+    // would corrupt the pool, so they're checked in every build.
+    if(pool_bytes / sizeof(uint32_t) >= NO_RECORD)
+        return -1;
+    if(pool_bytes / sizeof(uint32_t) < 2 + blocks + (blocks + 1) / 2 + blocks * FILL_WORDS)
+        return -1;
+
+    compressed.swmem_fill_handle = swmem_fill_get();
+    compressed.read_func = read_func;
+    compressed.staging = cache_buffer;
+    compressed.pool = &compressed.staging[line_size_bytes / sizeof(uint32_t)];
+    compressed.pool_words = pool_bytes / sizeof(uint32_t);
+    compressed.index = (uint16_t*) &compressed.pool[compressed.pool_words];
+    compressed.head = 0;
+    compressed.tail = 0;
+    compressed.wrap_at = 0;
+    compressed.wrapped = 0;
+    compressed.index_mask = line_count - 1;
+    compressed.line_bits = line_bits;
+    compressed.blocks = blocks;
+    compressed.held = 0;
+
+    for(int k = 0; k < line_count; k++)
+        compressed.index[k] = NO_RECORD;
+
+    DEBUG_PRINT("%s","Cache Type: Compressed (read-only)\n");
+    DEBUG_PRINT("Line Size:   %u bytes, %u line indexes\n", line_size_bytes, line_count);
+    DEBUG_PRINT("Pool:        0x%08X, %u B\n", (unsigned) compressed.pool, pool_bytes);
+
+    // Preload and the like need lines stored as they are in flash. With debug on, they
+    // check for these.
+    l2_cache_engine.claim = NULL;
+    l2_cache_engine.lookup = NULL;
+    l2_cache_engine.line_at = NULL;
+
+    return 0;
+}
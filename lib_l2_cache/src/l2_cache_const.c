@@ -0,0 +1,107 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_CONST_MAP_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define FILL_BYTES  32
+
+static struct {
+    const l2_cache_const_run_t* run;
+    unsigned count;
+
+    /// The value of the last constant fill, in every word (so only the first needs checking);
+    /// the engines fill straight from it
+    uint32_t fill[FILL_BYTES / sizeof(uint32_t)] __attribute__((aligned(8)));
+} const_map;
+
+volatile uint32_t l2_cache_const_fill_count;
+
+
+// The run containing `offset` (from the start of SwMem), or NULL
+static const l2_cache_const_run_t* find_run(
+    const unsigned offset)
+{
+    unsigned lo = 0;
+    unsigned hi = const_map.count;
+
+    // Runs are sorted and don't overlap, so the only candidate is the last one starting at
+    // or before `offset`
+    while(lo < hi) {
+        const unsigned mid = (lo + hi) / 2;
+
+        if(const_map.run[mid].start <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if(lo == 0)
+        return NULL;
+
+    const l2_cache_const_run_t* run = &const_map.run[lo - 1];
+
+    return (offset - run->start < run->bytes)? run : NULL;
+}
+
+
+const void* l2_cache_const_fill(
+    const unsigned fill_addr)
+{
+    const l2_cache_const_run_t* run = find_run(fill_addr - XS1_SWMEM_BASE);
+
+    if(run == NULL)
+        return NULL;
+
+    if(const_map.fill[0] != run->value) {
+        for(int k = 0; k < FILL_BYTES / sizeof(uint32_t); k++) {
+            const_map.fill[k] = run->value;
+        }
+    }
+
+    l2_cache_const_fill_count++;
+
+    return const_map.fill;
+}
+
+
+unsigned l2_cache_const_covers(
+    const unsigned addr,
+    const unsigned bytes)
+{
+    const unsigned offset = addr - XS1_SWMEM_BASE;
+    const l2_cache_const_run_t* run = find_run(offset);
+
+    return (run != NULL) && (offset + bytes - run->start <= run->bytes);
+}
+
+
+void l2_cache_set_const_map(
+    const l2_cache_const_run_t runs[],
+    const unsigned count)
+{
+    for(int k = 0; k < count; k++) {
+        DEBUG_ASSERT( (runs[k].start % FILL_BYTES) == 0 ); // fill-aligned
+        DEBUG_ASSERT( (runs[k].bytes % FILL_BYTES) == 0 );
+        DEBUG_ASSERT( k == 0 || runs[k].start >= runs[k-1].start + runs[k-1].bytes ); // sorted
+    }
+
+    const_map.run = runs;
+    const_map.count = count;
+
+    DEBUG_PRINT("Constant Map: %u runs\n", count);
+}
+
+#endif // L2_CACHE_CONST_MAP_ON
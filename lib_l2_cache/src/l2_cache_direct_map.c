@@ -10,6 +10,7 @@
 #include <xcore/hwtimer.h>
 
 #include "l2_cache.h"
+#include "l2_cache_internal.h"
 #include "xcore_utils.h"
 
 // =============== Debugging Stuff =============== //
@@ -17,7 +18,10 @@
 #define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
 
 // Tag table initialized to this to signal that the tag is dirty
-#define DIRTY_TAG_VALUE  (0xFFFFFFFF)
+#define DIRTY_TAG_VALUE  (0xFFFF)
+
+// Only the bottom TAG_BITS bits of a tag are kept in the tag table
+#define TAG_BITS         (16)
 
 static inline unsigned zext(const unsigned value, const unsigned bits)
 {
@@ -29,33 +33,169 @@ static inline unsigned zext(const unsigned value, const unsigned bits)
  * This struct is allocated in l2_cache.S.  Because there can only be one SwMem handler,
  * there's no reason not to make the cache config global.
  */
-extern struct {
-    swmem_fill_t swmem_fill_handle; /// resource handle for SwMem fills
-    unsigned index_bits;      /// log2() of the number of L2 cache entries
-    void* data_table;         /// data table
-    int* tag_table;           /// tag table
-    L2_CACHE_SWMEM_READ_FN
-    l2_cache_swmem_read_fn read_func;  /// function which populates the data table on a cache miss
-    uint32_t offset_mask;     /// mask to extract the data table offset from a fill address
-    unsigned line_size_bytes; /// Size of an L2 cache line in bytes
-    unsigned line_size;       /// log2() of line_size_bytes
-} l2_cache_config_direct_map;
+extern l2_cache_direct_map_config_t l2_cache_config_direct_map;
 
 #define l2_cache_config l2_cache_config_direct_map
 
-L2_CACHE_SETUP_FN_ATTR
-void l2_cache_setup_direct_map(
+#if !defined(__XS3A__)
+// There's no l2_cache_direct_map.S off-target, so the config lives here for the reference engine
+__typeof__(l2_cache_config_direct_map) l2_cache_config_direct_map;
+#endif // !defined(__XS3A__)
+
+#if L2_CACHE_DEBUG_ON
+void l2_cache_direct_map_debug(
+    const void* fill_address,
+    const uint16_t* tag_table,
+    const int* data_table);
+#endif // L2_CACHE_DEBUG_ON
+
+// Where the data for a fill address is (or goes): its offset into the data table, or with
+// segments into its group's segment
+static inline uint8_t* data_at(
+    const l2_cache_direct_map_config_t* config,
+    const unsigned addr)
+{
+#if L2_CACHE_SEGMENTS_ON
+    void* base = config->segment[(addr >> config->segment_shift) & config->segment_mask];
+#else
+    void* base = config->data_table;
+#endif // L2_CACHE_SEGMENTS_ON
+
+    return ((uint8_t*) base) + (addr & config->offset_mask);
+}
+
+L2_CACHE_CLAIM_FN
+static void* l2_cache_direct_map_claim(
+    const unsigned line_addr)
+{
+    unsigned addr = line_addr >> l2_cache_config.line_size;
+    const unsigned index = zext(addr, l2_cache_config.index_bits);
+    const unsigned tag = zext(addr >> l2_cache_config.index_bits, TAG_BITS);
+
+    if(l2_cache_config.tag_table[index] == tag)
+        return NULL;
+
+    l2_cache_config.tag_table[index] = tag;
+
+    return data_at(&l2_cache_config, index << l2_cache_config.line_size);
+}
+
+L2_CACHE_LOOKUP_FN
+static const void* l2_cache_direct_map_lookup(
+    const unsigned line_addr)
+{
+    unsigned addr = line_addr >> l2_cache_config.line_size;
+    const unsigned index = zext(addr, l2_cache_config.index_bits);
+    const unsigned tag = zext(addr >> l2_cache_config.index_bits, TAG_BITS);
+
+    if(l2_cache_config.tag_table[index] != tag)
+        return NULL;
+
+    return data_at(&l2_cache_config, index << l2_cache_config.line_size);
+}
+
+L2_CACHE_LINE_AT_FN
+static unsigned l2_cache_direct_map_line_at(
+    const unsigned slot)
+{
+    const unsigned tag = l2_cache_config.tag_table[slot];
+
+    if(tag == DIRTY_TAG_VALUE)
+        return 0;
+
+    return l2_cache_line_address(tag, slot, l2_cache_config.index_bits, l2_cache_config.line_size);
+}
+
+// Does exactly what l2_cache_direct_map.S does for a single fill
+const void* l2_cache_direct_map_fill(
+    l2_cache_direct_map_config_t* config,
+    const unsigned fill_addr)
+{
+    unsigned addr = fill_addr >> config->line_size;
+    const unsigned index = zext(addr, config->index_bits);
+    const unsigned tag = zext(addr >> config->index_bits, TAG_BITS);
+
+    uint8_t* fill_data = data_at(config, fill_addr);
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_direct_map_debug((void*) fill_addr, config->tag_table, config->data_table);
+    l2_cache_debug_stats.fill_request_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+    if(config->tag_table[index] == tag) {
+#if L2_CACHE_DEBUG_ON
+        l2_cache_debug_stats.hit_count++;
+#endif // L2_CACHE_DEBUG_ON
+#if L2_CACHE_HEATMAP_HITS_ON
+        l2_cache_heatmap_hit(fill_addr);
+#endif // L2_CACHE_HEATMAP_HITS_ON
+        return fill_data;
+    }
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.miss_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+#if L2_CACHE_CONST_MAP_ON
+    const void* const_data = l2_cache_const_fill(fill_addr);
+    if(const_data != NULL)
+        return const_data;
+#endif // L2_CACHE_CONST_MAP_ON
+
+#if L2_CACHE_HEATMAP_ON
+    l2_cache_heatmap_miss(fill_addr);
+#endif // L2_CACHE_HEATMAP_ON
+
+    const unsigned outer = l2_cache_fill_begin();
+    const unsigned line_offset = zext(fill_addr, config->line_size);
+
+    config->tag_table[index] = tag;
+    config->read_func(fill_data - line_offset, (void*) (fill_addr - line_offset),
+                      config->line_size_bytes);
+
+    l2_cache_fill_end(outer);
+
+    return fill_data;
+}
+
+L2_CACHE_REF_FILL_FN
+const void* l2_cache_direct_map_ref_fill(
+    const unsigned fill_addr)
+{
+    return l2_cache_direct_map_fill(&l2_cache_config, fill_addr);
+}
+
+void l2_cache_direct_map_ref(
+    l2_cache_fill_source_t* source)
+{
+    l2_cache_ref_run(source, l2_cache_direct_map_ref_fill);
+}
+
+#if defined(__XS3A__)
+void l2_cache_direct_map_ref_swmem(void* unused)
+{
+    l2_cache_fill_source_t source;
+    l2_cache_ref_swmem_source(&source, l2_cache_config.swmem_fill_handle);
+    l2_cache_direct_map_ref(&source);
+}
+#endif // defined(__XS3A__)
+
+int l2_cache_direct_map_config_init(
+    l2_cache_direct_map_config_t* config,
     const unsigned line_count,
     const unsigned line_size_bytes,
     void* cache_buffer,
     l2_cache_swmem_read_fn read_func)
 {
-    int* tag_table = cache_buffer;
-    void* data_table = &((int*)cache_buffer)[line_count];
+    uint16_t* tag_table = cache_buffer;
+    void* data_table = &tag_table[line_count];
 
     const unsigned cache_index_bits = 31 - clz(line_count);
     const unsigned line_bits = 31 - clz(line_size_bytes);
 
+    if(!l2_cache_tags_fit(line_bits, cache_index_bits, TAG_BITS))
+        return -1;
+
     uint32_t offset_mask = (1 << (line_bits + cache_index_bits)) - 1;
 
     DEBUG_ASSERT( line_size_bytes >= 32 ); // minimum line size is 32 bytes
@@ -64,21 +204,48 @@ void l2_cache_setup_direct_map(
     DEBUG_ASSERT( (((unsigned)data_table) & 0x3) == 0); // data_table is word-aligned
     DEBUG_ASSERT( (((unsigned)tag_table) & 0x1) == 0); // tag_table is short-aligned
 
+    config->index_bits = cache_index_bits;
+    config->data_table = data_table;
+    config->tag_table = tag_table;
+    config->read_func = read_func;
+    config->offset_mask = offset_mask;
+    config->line_size_bytes = line_size_bytes;
+    config->line_size = line_bits;
+
+#if L2_CACHE_SEGMENTS_ON
+    // One segment, the data table
+    config->segment_shift = 0;
+    config->segment_mask = 0;
+    config->segment[0] = data_table;
+#endif // L2_CACHE_SEGMENTS_ON
+
+    for(int k = 0; k < line_count; k++) {
+        config->tag_table[k] = DIRTY_TAG_VALUE;
+    }
+
+    return 0;
+}
+
+L2_CACHE_SETUP_FN_ATTR
+int l2_cache_setup_direct_map(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func)
+{
+    if(l2_cache_direct_map_config_init(&l2_cache_config, line_count, line_size_bytes,
+                                       cache_buffer, read_func) < 0)
+        return -1;
+
     l2_cache_config.swmem_fill_handle = swmem_fill_get();
-    l2_cache_config.index_bits = cache_index_bits;
-    l2_cache_config.data_table = data_table;
-    l2_cache_config.tag_table = tag_table;
-    l2_cache_config.read_func = read_func;
-    l2_cache_config.offset_mask = offset_mask;
-    l2_cache_config.line_size_bytes = line_size_bytes;
-    l2_cache_config.line_size = line_bits;
 
     #if L2_CACHE_DEBUG_ON
-        // First two address bits for SwMem are always 01  (0x40000000 - 0x7FFFFFFF), so
-        // they needn't be included in the tag.
+        // First two address bits for SwMem are always 01  (0x40000000 - 0x7FFFFFFF), and
+        // only L2_CACHE_SWMEM_ADDRESS_BITS below them are backed by flash, so the tag
+        // always fits in a short.
 
-        const unsigned data_table_end = ((unsigned)data_table) + line_count*line_size_bytes - 1;
-        const unsigned tag_table_end = ((unsigned)tag_table) + line_count*sizeof(uint16_t) - 1;
+        const unsigned data_table_end = ((unsigned)l2_cache_config.data_table) + line_count*line_size_bytes - 1;
+        const unsigned tag_table_end = ((unsigned)l2_cache_config.tag_table) + line_count*sizeof(uint16_t) - 1;
 
         DEBUG_PRINT("%s","Cache Type: Direct Mapped (read-only)\n");
         DEBUG_PRINT("SwMem Fill Handle: %u\n", l2_cache_config.swmem_fill_handle);
@@ -90,20 +257,55 @@ void l2_cache_setup_direct_map(
         DEBUG_PRINT("Read Func:   0x%08X\n", (unsigned) read_func);
         DEBUG_PRINT("Offset Mask: 0x%08X\n", (unsigned) l2_cache_config.offset_mask);
         DEBUG_PRINT("Cache Size: %u B\n", line_count * line_size_bytes);
-        DEBUG_PRINT("Tag Table Size: %u B\n", line_count * sizeof(int));
+        DEBUG_PRINT("Tag Table Size: %u B\n", line_count * sizeof(uint16_t));
     #endif // L2_CACHE_DEBUG_ON
 
-    for(int k = 0; k < line_count; k++) {
-        l2_cache_config.tag_table[k] = DIRTY_TAG_VALUE;
-    }
+    l2_cache_engine_init(l2_cache_direct_map_claim, l2_cache_direct_map_lookup,
+                         l2_cache_direct_map_line_at,
+                         &l2_cache_config.read_func, read_func,
+                         l2_cache_config.line_size, line_count, line_count);
+
+    return 0;
+}
+
+#if L2_CACHE_SEGMENTS_ON
+int l2_cache_setup_direct_map_segments(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* tag_buffer,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count,
+    l2_cache_swmem_read_fn read_func)
+{
+    void* table[1 << L2_CACHE_SEGMENT_TABLE_BITS];
+
+    const int group_bits = l2_cache_segments_assign(table, line_count, line_size_bytes,
+                                                    segments, segment_count);
+    if(group_bits < 0)
+        return -1;
+
+    // Only the tags are in tag_buffer; the data table it implies is never used
+    if(l2_cache_setup_direct_map(line_count, line_size_bytes, tag_buffer, read_func) < 0)
+        return -1;
+
+    // A group is the sets with the same top group_bits index bits
+    l2_cache_config.segment_shift = l2_cache_config.line_size + l2_cache_config.index_bits - group_bits;
+    l2_cache_config.segment_mask = (1 << group_bits) - 1;
+    l2_cache_config.offset_mask = (1 << l2_cache_config.segment_shift) - 1;
+    l2_cache_config.data_table = table[0];
+
+    for(int k = 0; k < (1 << group_bits); k++)
+        l2_cache_config.segment[k] = table[k];
 
+    return 0;
 }
+#endif // L2_CACHE_SEGMENTS_ON
 
 
 #if L2_CACHE_DEBUG_ON
 void l2_cache_direct_map_debug(
     const void* fill_address,
-    const int* tag_table,
+    const uint16_t* tag_table,
     const int* data_table)
 {
     // DEBUG_PRINT("Rx Fill Request: 0x%08X\n", (unsigned) fill_address);
@@ -127,12 +329,11 @@ l2_cache_direct_map_addr_dbg_t l2_cache_direct_map_get_addr_info(
     addr >>= l2_cache_config.line_size;
     x.entry_index = zext(addr, l2_cache_config.index_bits);
     addr >>= l2_cache_config.index_bits;
-    x.tag = addr;
+    x.tag = zext(addr, TAG_BITS);
     x.is_hit = 0;
 
     x.entry.tag = l2_cache_config.tag_table[x.entry_index];
-    x.entry.slot = (int*) (((unsigned)l2_cache_config.data_table)
-                        + (x.entry_index * l2_cache_config.line_size_bytes));
+    x.entry.slot = (int*) data_at(&l2_cache_config, x.entry_index << l2_cache_config.line_size);
 
     x.is_hit = (x.tag == x.entry.tag);
 
@@ -142,7 +343,7 @@ l2_cache_direct_map_addr_dbg_t l2_cache_direct_map_get_addr_info(
         x.miss.bytes = l2_cache_config.line_size_bytes;
     }
 
-    x.cache_address = (void*) (((unsigned) &x.entry.slot) + x.entry_offset);
+    x.cache_address = (void*) (((unsigned) x.entry.slot) + x.entry_offset);
 
     return x;
 }
@@ -0,0 +1,243 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+// One past the last flash-backed SwMem address
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+l2_cache_engine_t l2_cache_engine;
+
+#if L2_CACHE_FILL_SEQ_ON
+volatile unsigned l2_cache_fill_seq = 0;
+#endif /* L2_CACHE_FILL_SEQ_ON */
+
+#if L2_CACHE_FLASH_LOCK_ON
+#define FLASH_LOCK()    lock_acquire(l2_cache_engine.flash_lock)
+#define FLASH_UNLOCK()  lock_release(l2_cache_engine.flash_lock)
+#else
+#define FLASH_LOCK()
+#define FLASH_UNLOCK()
+#endif /* L2_CACHE_FLASH_LOCK_ON */
+
+
+void l2_cache_flash_read(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    FLASH_LOCK();
+    l2_cache_engine.read_func(dst, src, bytes);
+    FLASH_UNLOCK();
+}
+
+
+static void issue_reads(
+    const l2_cache_read_seg_t* segs,
+    const unsigned seg_count)
+{
+    if(seg_count == 0)
+        return;
+
+    FLASH_LOCK();
+
+    if(l2_cache_engine.readv_func != NULL) {
+        l2_cache_engine.readv_func(segs, seg_count);
+    } else {
+        for(int k = 0; k < seg_count; k++) {
+            l2_cache_engine.read_func(segs[k].dst, segs[k].src, segs[k].bytes);
+        }
+    }
+
+    FLASH_UNLOCK();
+}
+
+
+void l2_cache_fetch_lines(
+    const unsigned line_addr,
+    unsigned line_count,
+    void* first_dst)
+{
+    l2_cache_read_seg_t segs[L2_CACHE_FETCH_MAX_SEGMENTS];
+    unsigned seg_count = 0;
+
+    const unsigned line_bytes = 1 << l2_cache_engine.line_bits;
+
+    DEBUG_ASSERT( (line_addr & (line_bytes - 1)) == 0 ); // line_addr is line-aligned
+
+    if(line_count > l2_cache_engine.set_count)
+        line_count = l2_cache_engine.set_count;
+
+    if(line_count > (SWMEM_END - line_addr) / line_bytes)
+        line_count = (SWMEM_END - line_addr) / line_bytes;
+
+    unsigned addr = line_addr;
+    const unsigned outer = l2_cache_fill_begin();
+
+    for(int k = 0; k < line_count; k++, addr += line_bytes) {
+#if L2_CACHE_CONST_MAP_ON
+        // Lines which are all constant never need a slot (the engine checked the first already)
+        if(!(k == 0 && first_dst != NULL) && l2_cache_const_covers(addr, line_bytes))
+            continue;
+#endif // L2_CACHE_CONST_MAP_ON
+
+        uint8_t* dst = (k == 0 && first_dst != NULL)? first_dst : l2_cache_engine.claim(addr);
+
+        // Already cached
+        if(dst == NULL)
+            continue;
+
+        if(seg_count != 0) {
+            l2_cache_read_seg_t* last = &segs[seg_count-1];
+
+            // Extend the last segment if this line follows on in both flash and the cache
+            if(((unsigned)last->src) + last->bytes == addr
+                    && ((unsigned)last->dst) + last->bytes == (unsigned)dst) {
+                last->bytes += line_bytes;
+                continue;
+            }
+
+            if(seg_count == L2_CACHE_FETCH_MAX_SEGMENTS) {
+                issue_reads(segs, seg_count);
+                seg_count = 0;
+            }
+        }
+
+        segs[seg_count].dst = dst;
+        segs[seg_count].src = (const void*) addr;
+        segs[seg_count].bytes = line_bytes;
+        seg_count++;
+    }
+
+    issue_reads(segs, seg_count);
+
+    l2_cache_fill_end(outer);
+}
+
+
+// Installed as the engine's read function when more than one line is fetched on each miss,
+// or when misses need counting, locking or sizing. The engine has already claimed `dst` for the line that missed.
+L2_CACHE_SWMEM_READ_FN
+static void l2_cache_miss_fetch(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+#if L2_CACHE_PREFETCH_ON
+    l2_cache_prefetch_stats.miss_count++;
+#endif // L2_CACHE_PREFETCH_ON
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    l2_cache_adaptive_fetch(dst, (unsigned) src);
+#else
+    l2_cache_fetch_lines((unsigned) src, l2_cache_engine.miss_fetch_lines, dst);
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+}
+
+
+static void update_miss_read_func(void)
+{
+    const unsigned use_handler = (l2_cache_engine.miss_fetch_lines > 1) || L2_CACHE_PREFETCH_ON
+                                    || L2_CACHE_FLASH_LOCK_ON || L2_CACHE_ADAPTIVE_FETCH_ON;
+
+    *l2_cache_engine.miss_read_func = use_handler? l2_cache_miss_fetch : l2_cache_engine.read_func;
+}
+
+
+void l2_cache_engine_init(
+    l2_cache_claim_fn claim,
+    l2_cache_lookup_fn lookup,
+    l2_cache_line_at_fn line_at,
+    l2_cache_swmem_read_fn* miss_read_func,
+    l2_cache_swmem_read_fn read_func,
+    const unsigned line_bits,
+    const unsigned set_count,
+    const unsigned slot_count)
+{
+    l2_cache_engine.claim = claim;
+    l2_cache_engine.lookup = lookup;
+    l2_cache_engine.line_at = line_at;
+    l2_cache_engine.miss_read_func = miss_read_func;
+    l2_cache_engine.read_func = read_func;
+    l2_cache_engine.readv_func = NULL;
+    l2_cache_engine.line_bits = line_bits;
+    l2_cache_engine.set_count = set_count;
+    l2_cache_engine.slot_count = slot_count;
+    l2_cache_engine.miss_fetch_lines = 1;
+
+#if L2_CACHE_FLASH_LOCK_ON
+    // Setup may be repeated; the lock only needs allocating once
+    if(l2_cache_engine.flash_lock == 0)
+        l2_cache_engine.flash_lock = lock_alloc();
+    DEBUG_ASSERT( l2_cache_engine.flash_lock != 0 );
+#endif /* L2_CACHE_FLASH_LOCK_ON */
+
+#if L2_CACHE_PREFETCH_ON
+    l2_cache_prefetch_reset();
+#endif // L2_CACHE_PREFETCH_ON
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    l2_cache_adaptive_reset();
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+
+    update_miss_read_func();
+}
+
+
+void l2_cache_engine_start(void)
+{
+    l2_cache_warm_pending();
+}
+
+
+void l2_cache_set_readv(
+    l2_cache_swmem_readv_fn readv_func,
+    const unsigned miss_fetch_lines)
+{
+    DEBUG_ASSERT( l2_cache_engine.claim != NULL ); // cache has been set up
+    DEBUG_ASSERT( miss_fetch_lines >= 1 );
+
+    l2_cache_engine.readv_func = readv_func;
+    l2_cache_engine.miss_fetch_lines = miss_fetch_lines;
+
+    update_miss_read_func();
+
+    DEBUG_PRINT("ReadV Func:  0x%08X\n", (unsigned) readv_func);
+    DEBUG_PRINT("Miss Fetch:  %u lines\n", miss_fetch_lines);
+}
+
+
+void l2_cache_preload(
+    const void* address,
+    const size_t len)
+{
+    // No single engine (e.g. a region cache), so nowhere to put the lines
+    if(l2_cache_engine.claim == NULL || len == 0)
+        return;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+
+    unsigned first = ((unsigned) address) >> line_bits;
+    unsigned last = (((unsigned) address) + len - 1) >> line_bits;
+
+    // Runs are cut at the set count anyway, so do them a set count at a time
+    while(first <= last) {
+        unsigned count = last - first + 1;
+        if(count > l2_cache_engine.set_count)
+            count = l2_cache_engine.set_count;
+
+        l2_cache_fetch_lines(first << line_bits, count, NULL);
+        first += count;
+    }
+}
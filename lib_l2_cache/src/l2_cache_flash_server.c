@@ -0,0 +1,287 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_FLASH_SERVER_ON
+
+#if defined(__XS3A__)
+#include <xcore/chanend.h>
+#include <xcore/select.h>
+#endif // defined(__XS3A__)
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+/*
+
+Protocol
+
+  Every client chanend has the server's chanend as its destination. A request is one
+  packet, so requests from different clients never interleave:
+
+    client -> server:   client chanend, src, bytes, priority, END
+
+  The server points its chanend at the client for the reply:
+
+    server -> client:   data (whole words, then any odd bytes), END
+
+  A client waits for its reply before sending another request, so has at most one
+  request outstanding.
+
+*/
+
+
+static unsigned effective_priority(
+    const l2_cache_flash_request_t* request)
+{
+    if(request->skips >= L2_CACHE_FLASH_SERVER_APP_SKIPS)
+        return L2_CACHE_FLASH_PRIORITY_MISS;
+    return request->priority;
+}
+
+
+void l2_cache_flash_server_plan(
+    l2_cache_flash_request_t* queue,
+    const unsigned count,
+    l2_cache_flash_batch_t* batch)
+{
+    DEBUG_ASSERT( count > 0 && count <= L2_CACHE_FLASH_SERVER_QUEUE );
+
+    // The queue is in arrival order, so the first with the highest priority is the oldest
+    unsigned first = 0;
+    for(int k = 1; k < count; k++) {
+        if(effective_priority(&queue[k]) > effective_priority(&queue[first]))
+            first = k;
+    }
+
+    uint32_t in_batch = 1 << first;
+    unsigned lo = queue[first].src;
+    unsigned hi = lo + queue[first].bytes;
+
+    batch->request[0] = first;
+    batch->count = 1;
+
+    // Add anything which overlaps or adjoins the range, until nothing more fits. Each
+    // addition can bring others into reach, so go round again until nothing changes.
+    unsigned grown = 1;
+    while(grown) {
+        grown = 0;
+
+        for(int k = 0; k < count; k++) {
+            const unsigned src = queue[k].src;
+            const unsigned end = src + queue[k].bytes;
+
+            if((in_batch & (1 << k)) || src > hi || end < lo)
+                continue;
+
+            const unsigned new_lo = (src < lo)? src : lo;
+            const unsigned new_hi = (end > hi)? end : hi;
+
+            if(new_hi - new_lo > L2_CACHE_FLASH_SERVER_BUFFER_BYTES)
+                continue;
+
+            lo = new_lo;
+            hi = new_hi;
+            in_batch |= 1 << k;
+            batch->request[batch->count++] = k;
+            grown = 1;
+        }
+    }
+
+    batch->src = lo;
+    batch->bytes = hi - lo;
+
+    for(int k = 0; k < count; k++) {
+        if(!(in_batch & (1 << k)))
+            queue[k].skips++;
+    }
+}
+
+
+#if defined(__XS3A__)
+
+static void receive_request(
+    const chanend_t c,
+    l2_cache_flash_request_t* request)
+{
+    request->client = chanend_in_word(c);
+    request->src = chanend_in_word(c);
+    request->bytes = chanend_in_word(c);
+    request->priority = chanend_in_word(c);
+    request->skips = 0;
+    chanend_check_end_token(c);
+
+    DEBUG_ASSERT( request->bytes <= L2_CACHE_FLASH_SERVER_BUFFER_BYTES );
+}
+
+
+static unsigned request_waiting(
+    const chanend_t c)
+{
+    SELECT_RES(
+        CASE_THEN(c, waiting),
+        DEFAULT_THEN(none))
+    {
+        waiting:
+            return 1;
+        none:
+            return 0;
+    }
+}
+
+
+static void send_reply(
+    const chanend_t c,
+    const chanend_t client,
+    const uint8_t* data,
+    const unsigned bytes)
+{
+    chanend_set_dest(c, client);
+
+    int k = 0;
+    for(; k + sizeof(uint32_t) <= bytes; k += sizeof(uint32_t)) {
+        uint32_t word;
+        memcpy(&word, &data[k], sizeof(word));
+        chanend_out_word(c, word);
+    }
+
+    for(; k < bytes; k++)
+        chanend_out_byte(c, data[k]);
+
+    chanend_out_end_token(c);
+}
+
+
+void l2_cache_flash_server(
+    const chanend_t c,
+    l2_cache_swmem_read_fn read_func)
+{
+    static uint32_t buffer[L2_CACHE_FLASH_SERVER_BUFFER_BYTES / sizeof(uint32_t)];
+
+    l2_cache_flash_request_t queue[L2_CACHE_FLASH_SERVER_QUEUE];
+    l2_cache_flash_batch_t batch;
+    unsigned count = 0;
+
+    while(1) {
+        if(count == 0)
+            receive_request(c, &queue[count++]);
+
+        // Take in everything else which has arrived, so it can be prioritised and batched
+        while(count < L2_CACHE_FLASH_SERVER_QUEUE && request_waiting(c))
+            receive_request(c, &queue[count++]);
+
+        l2_cache_flash_server_plan(queue, count, &batch);
+
+        read_func(buffer, (const void*) batch.src, batch.bytes);
+
+        uint32_t served = 0;
+        for(int k = 0; k < batch.count; k++) {
+            const l2_cache_flash_request_t* request = &queue[batch.request[k]];
+            send_reply(c, request->client,
+                       &((uint8_t*) buffer)[request->src - batch.src], request->bytes);
+            served |= 1 << batch.request[k];
+        }
+
+        // Keep what's left in arrival order
+        unsigned left = 0;
+        for(int k = 0; k < count; k++) {
+            if(!(served & (1 << k)))
+                queue[left++] = queue[k];
+        }
+        count = left;
+    }
+}
+
+
+void l2_cache_flash_client_init(
+    l2_cache_flash_client_t* client,
+    const chanend_t server,
+    const unsigned priority)
+{
+    client->c = chanend_alloc();
+    DEBUG_ASSERT( client->c != 0 );
+
+    chanend_set_dest(client->c, server);
+    client->priority = priority;
+}
+
+
+void l2_cache_flash_client_free(
+    l2_cache_flash_client_t* client)
+{
+    chanend_free(client->c);
+    client->c = 0;
+}
+
+
+void l2_cache_flash_client_read(
+    const l2_cache_flash_client_t* client,
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    const chanend_t c = client->c;
+    uint8_t* d = dst;
+    unsigned s = (unsigned) src;
+    size_t left = bytes;
+
+    while(left != 0) {
+        const unsigned chunk = (left < L2_CACHE_FLASH_SERVER_BUFFER_BYTES)?
+                                    left : L2_CACHE_FLASH_SERVER_BUFFER_BYTES;
+
+        chanend_out_word(c, c);
+        chanend_out_word(c, s);
+        chanend_out_word(c, chunk);
+        chanend_out_word(c, client->priority);
+        chanend_out_end_token(c);
+
+        int k = 0;
+        for(; k + sizeof(uint32_t) <= chunk; k += sizeof(uint32_t)) {
+            const uint32_t word = chanend_in_word(c);
+            memcpy(&d[k], &word, sizeof(word));
+        }
+
+        for(; k < chunk; k++)
+            d[k] = chanend_in_byte(c);
+
+        chanend_check_end_token(c);
+
+        d += chunk;
+        s += chunk;
+        left -= chunk;
+    }
+}
+
+
+static l2_cache_flash_client_t miss_client;
+
+
+void l2_cache_flash_server_connect(
+    const chanend_t server)
+{
+    l2_cache_flash_client_init(&miss_client, server, L2_CACHE_FLASH_PRIORITY_MISS);
+
+    DEBUG_PRINT("Flash Server: 0x%08X\n", (unsigned) server);
+}
+
+
+L2_CACHE_SWMEM_READ_FN
+void l2_cache_flash_server_read(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    l2_cache_flash_client_read(&miss_client, dst, src, bytes);
+}
+
+#endif // defined(__XS3A__)
+
+#endif // L2_CACHE_FLASH_SERVER_ON
@@ -0,0 +1,107 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_HEATMAP_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define COUNT(COUNTER)  do { if((COUNTER) != UINT16_MAX) (COUNTER)++; } while(0)
+
+__typeof__(l2_cache_heatmap) l2_cache_heatmap;
+
+
+static l2_cache_heatmap_page_t* page_of(
+    const unsigned fill_addr)
+{
+    const unsigned page = (fill_addr - XS1_SWMEM_BASE) >> L2_CACHE_HEATMAP_PAGE_BITS;
+
+    return (page < L2_CACHE_HEATMAP_PAGES)? &l2_cache_heatmap.page[page] : &l2_cache_heatmap.beyond;
+}
+
+
+void l2_cache_heatmap_miss(
+    const unsigned fill_addr)
+{
+    COUNT(page_of(fill_addr)->misses);
+
+    // No single engine (e.g. a region cache), so no one set index
+    if(l2_cache_engine.claim == NULL)
+        return;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned line_addr = (fill_addr >> line_bits) << line_bits;
+    const unsigned index = (fill_addr >> line_bits) & (l2_cache_engine.set_count - 1);
+
+    l2_cache_heatmap_set_t* set = &l2_cache_heatmap.set[index % L2_CACHE_HEATMAP_SETS];
+
+    COUNT(set->misses);
+
+    // Move the line to the front of the set's recent misses, counting a refetch if it was
+    // already there
+    int k = 0;
+    while(k < L2_CACHE_HEATMAP_RECENT - 1 && set->recent[k] != line_addr)
+        k++;
+
+    if(set->recent[k] == line_addr)
+        COUNT(set->refetches);
+
+    for(; k > 0; k--)
+        set->recent[k] = set->recent[k-1];
+
+    set->recent[0] = line_addr;
+}
+
+
+void l2_cache_heatmap_hit(
+    const unsigned fill_addr)
+{
+    COUNT(page_of(fill_addr)->hits);
+}
+
+
+void l2_cache_heatmap_reset(void)
+{
+    memset(&l2_cache_heatmap, 0, sizeof(l2_cache_heatmap));
+}
+
+
+static void dump_page(
+    const unsigned addr,
+    const l2_cache_heatmap_page_t* page)
+{
+    if(page->misses != 0 || page->hits != 0)
+        debug_printf("L2 heatmap page 0x%08X: %u misses, %u hits\n", addr, page->misses, page->hits);
+}
+
+
+void l2_cache_heatmap_dump(void)
+{
+    for(int k = 0; k < L2_CACHE_HEATMAP_PAGES; k++) {
+        dump_page(XS1_SWMEM_BASE + (k << L2_CACHE_HEATMAP_PAGE_BITS), &l2_cache_heatmap.page[k]);
+    }
+
+    dump_page(XS1_SWMEM_BASE + (L2_CACHE_HEATMAP_PAGES << L2_CACHE_HEATMAP_PAGE_BITS),
+              &l2_cache_heatmap.beyond);
+
+    for(int k = 0; k < L2_CACHE_HEATMAP_SETS; k++) {
+        const l2_cache_heatmap_set_t* set = &l2_cache_heatmap.set[k];
+
+        if(set->misses != 0)
+            debug_printf("L2 heatmap set %u: %u misses, %u refetches\n", k, set->misses,
+                         set->refetches);
+    }
+}
+
+#endif // L2_CACHE_HEATMAP_ON
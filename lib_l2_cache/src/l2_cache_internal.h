@@ -0,0 +1,414 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef L2_CACHE_INTERNAL_H_
+#define L2_CACHE_INTERNAL_H_
+
+#include "l2_cache.h"
+#include "l2_cache_ref.h"
+
+#if L2_CACHE_FLASH_LOCK_ON
+#include <xcore/lock.h>
+#endif /* L2_CACHE_FLASH_LOCK_ON */
+
+#define L2_CACHE_CLAIM_FN  __attribute__((fptrgroup("l2_cache_claim_fptr_grp")))
+typedef void* (*l2_cache_claim_fn)(const unsigned);
+
+#define L2_CACHE_LOOKUP_FN  __attribute__((fptrgroup("l2_cache_lookup_fptr_grp")))
+typedef const void* (*l2_cache_lookup_fn)(const unsigned);
+
+#define L2_CACHE_LINE_AT_FN  __attribute__((fptrgroup("l2_cache_line_at_fptr_grp")))
+typedef unsigned (*l2_cache_line_at_fn)(const unsigned);
+
+/**
+ * The direct-mapped engine's config. l2_cache_direct_map.S has one of these (and the field
+ * offsets baked in); the region engine has one for each direct-mapped region.
+ */
+typedef struct {
+    swmem_fill_t swmem_fill_handle; /// resource handle for SwMem fills
+    unsigned index_bits;      /// log2() of the number of L2 cache entries
+    void* data_table;         /// data table
+    uint16_t* tag_table;      /// tag table
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn read_func;  /// function which populates the data table on a cache miss
+    uint32_t offset_mask;     /// mask to extract the data table offset from a fill address
+    unsigned line_size_bytes; /// Size of an L2 cache line in bytes
+    unsigned line_size;       /// log2() of line_size_bytes
+#if L2_CACHE_SEGMENTS_ON
+    unsigned segment_shift;   /// a fill address's segment table entry is found by shifting it
+    unsigned segment_mask;    /// ...right this far, and masking it with this
+    void* segment[1 << L2_CACHE_SEGMENT_TABLE_BITS]; /// data for each group of sets
+#endif /* L2_CACHE_SEGMENTS_ON */
+} l2_cache_direct_map_config_t;
+
+typedef struct {
+    uint16_t tag[2];
+} l2_cache_tags_t;
+
+/**
+ * The two-way engine's config, likewise shared with l2_cache_two_way.S.
+ */
+typedef struct {
+    swmem_fill_t swmem_fill_handle; /// resource handle for SwMem fills
+    l2_cache_tags_t* tag_table; /// tags for each set
+    uint8_t* last_hit;        /// way which had the most recent hit, for each set
+    void* data_table;         /// data for all of way 0, followed by all of way 1
+    unsigned index_bits;      /// log2() of the number of L2 cache entries
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn read_func;  /// function which populates the data table on a cache miss
+    struct {
+        unsigned bytes; /// Size of an L2 cache line in bytes
+        unsigned bits;  /// log2() of line_size.bytes
+    } line_size;
+    unsigned way_bytes;       /// Size of the data table for one way
+    uint32_t offset_mask;     /// mask to extract the way 0 data table offset from a fill address
+#if L2_CACHE_SEGMENTS_ON
+    unsigned segment_shift;   /// as for the direct-mapped config; each group's segment holds
+    unsigned segment_mask;    /// all of its way 0 data, then all of its way 1 data
+    void* segment[1 << L2_CACHE_SEGMENT_TABLE_BITS];
+#endif /* L2_CACHE_SEGMENTS_ON */
+} l2_cache_two_way_config_t;
+
+/**
+ * Whether the tag left of a flash address, once the line and index bits are taken off, fits
+ * in `tag_bits` with room for the empty line marker (all ones).
+ */
+static inline int l2_cache_tags_fit(
+    const unsigned line_bits,
+    const unsigned index_bits,
+    const unsigned tag_bits)
+{
+    return (line_bits + index_bits < L2_CACHE_SWMEM_ADDRESS_BITS) &&
+           (L2_CACHE_SWMEM_ADDRESS_BITS - line_bits - index_bits < tag_bits);
+}
+
+/**
+ * Lay out the tables in `cache_buffer` and mark every line empty. Everything in the config
+ * except the SwMem fill handle is set.
+ *
+ * Returns 0, or -1 if the tags don't fit (see l2_cache_setup_direct_map()), in which case
+ * neither the config nor `cache_buffer` has been touched.
+ */
+int l2_cache_direct_map_config_init(
+    l2_cache_direct_map_config_t* config,
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func);
+
+int l2_cache_two_way_config_init(
+    l2_cache_two_way_config_t* config,
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func);
+
+#if L2_CACHE_SEGMENTS_ON
+/**
+ * Split `set_count` sets of `set_bytes` each into the fewest equal, power-of-two sized groups
+ * which fit in the segments, and point `table[k]` at the data for group k. Returns log2() of
+ * the number of groups, or -1 if they don't fit.
+ */
+int l2_cache_segments_assign(
+    void* table[],
+    const unsigned set_count,
+    const unsigned set_bytes,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count);
+#endif /* L2_CACHE_SEGMENTS_ON */
+
+/**
+ * Serve one fill from the cache described by `config` exactly as the assembly engine would,
+ * and return the 32 bytes of data for it.
+ */
+const void* l2_cache_direct_map_fill(
+    l2_cache_direct_map_config_t* config,
+    const unsigned fill_addr);
+
+const void* l2_cache_two_way_fill(
+    l2_cache_two_way_config_t* config,
+    const unsigned fill_addr);
+
+/**
+ * Whichever cache was set up last. Because there can only be one SwMem handler, there
+ * is only ever one of these.
+ *
+ * Everything that touches the tag tables must run either before the cache thread is
+ * started or on the cache thread itself (from inside the read function).
+ */
+typedef struct {
+    /// Reserve a slot for the line at a (line-aligned) flash address, updating the tag and
+    /// replacement state as a miss would. Returns the slot, or NULL if the line is cached.
+    L2_CACHE_CLAIM_FN
+    l2_cache_claim_fn claim;
+
+    /// Slot holding the line at a (line-aligned) flash address, or NULL. Changes nothing, so
+    /// it may be called from any thread (see l2_cache_fill_seq for making that safe).
+    L2_CACHE_LOOKUP_FN
+    l2_cache_lookup_fn lookup;
+
+    /// Flash address of the line held in a slot (0 to slot_count-1), or 0 if it's empty
+    L2_CACHE_LINE_AT_FN
+    l2_cache_line_at_fn line_at;
+
+    /// The read function slot in the engine's own config, which the miss path calls
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn* miss_read_func;
+
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn read_func;   /// read function given at setup
+    L2_CACHE_SWMEM_READV_FN
+    l2_cache_swmem_readv_fn readv_func; /// optional vectored read function
+
+    unsigned line_bits;         /// log2() of the line size in bytes
+    unsigned set_count;         /// consecutive lines that never share a set
+    unsigned slot_count;        /// lines the cache can hold
+    unsigned miss_fetch_lines;  /// lines fetched on each miss
+#if L2_CACHE_FLASH_LOCK_ON
+    lock_t flash_lock;          /// held around every flash read
+#endif /* L2_CACHE_FLASH_LOCK_ON */
+} l2_cache_engine_t;
+
+extern l2_cache_engine_t l2_cache_engine;
+
+/**
+ * Called by l2_cache_setup_*() once the engine's own config is filled in.
+ */
+void l2_cache_engine_init(
+    l2_cache_claim_fn claim,
+    l2_cache_lookup_fn lookup,
+    l2_cache_line_at_fn line_at,
+    l2_cache_swmem_read_fn* miss_read_func,
+    l2_cache_swmem_read_fn read_func,
+    const unsigned line_bits,
+    const unsigned set_count,
+    const unsigned slot_count);
+
+/**
+ * Called by the cache thread once, before it serves its first fill.
+ */
+void l2_cache_engine_start(void);
+
+/**
+ * Loads any warm list handed to l2_cache_warm_from_list(). Called from l2_cache_engine_start().
+ */
+void l2_cache_warm_pending(void);
+
+/**
+ * Read flash with the read function given at setup, from any thread.
+ */
+void l2_cache_flash_read(
+    void* dst,
+    const void* src,
+    const size_t bytes);
+
+#if L2_CACHE_FILL_SEQ_ON
+/**
+ * Odd while the cache thread is replacing lines, and changed on every replacement.
+ *
+ * A thread other than the cache thread can copy from a slot found with lookup(), and keep the
+ * copy if l2_cache_fill_seq was even before the lookup and unchanged after the copy. The
+ * same goes for anything else read from the tables.
+ *
+ * The engines bump it around their own miss handling; C code which claims and fills lines
+ * brackets itself with l2_cache_fill_begin() and l2_cache_fill_end().
+ */
+extern volatile unsigned l2_cache_fill_seq;
+#endif /* L2_CACHE_FILL_SEQ_ON */
+
+/**
+ * Start replacing lines. Returns whether this made l2_cache_fill_seq odd, i.e. whether the
+ * matching l2_cache_fill_end() needs to make it even again.
+ */
+static inline unsigned l2_cache_fill_begin(void)
+{
+#if L2_CACHE_FILL_SEQ_ON
+    if(l2_cache_fill_seq & 1)
+        return 0;
+    l2_cache_fill_seq++;
+    return 1;
+#else
+    return 0;
+#endif /* L2_CACHE_FILL_SEQ_ON */
+}
+
+static inline void l2_cache_fill_end(
+    const unsigned outer)
+{
+#if L2_CACHE_FILL_SEQ_ON
+    if(outer)
+        l2_cache_fill_seq++;
+#endif /* L2_CACHE_FILL_SEQ_ON */
+}
+
+/**
+ * Rebuild the flash address of a cached line from its 16-bit tag and its index.
+ */
+static inline unsigned l2_cache_line_address(
+    const unsigned tag,
+    const unsigned index,
+    const unsigned index_bits,
+    const unsigned line_bits)
+{
+    // Bit 30 is the only SwMem address bit that can be missing from a 16-bit tag
+    return 0x40000000 | (tag << (line_bits + index_bits)) | (index << line_bits);
+}
+
+/**
+ * Fetch up to `line_count` consecutive lines starting at the line-aligned flash address
+ * `line_addr`, skipping any which are already cached.
+ *
+ * `first_dst`, if not NULL, is a slot the caller has already claimed for the first line.
+ *
+ * Runs longer than the number of sets are cut short so that no line in the run can evict
+ * another.
+ */
+void l2_cache_fetch_lines(
+    const unsigned line_addr,
+    unsigned line_count,
+    void* first_dst);
+
+/**
+ * Serve one fill with the cache of whichever region it's in (see l2_cache_setup_regions()),
+ * and return the 32 bytes of data for it.
+ */
+const void* l2_cache_regions_fill(
+    const unsigned fill_addr);
+
+/**
+ * Serve one fill with the compressed cache (see l2_cache_setup_compressed()), and return the
+ * 32 bytes of data for it.
+ */
+const void* l2_cache_compressed_fill(
+    const unsigned fill_addr);
+
+#if L2_CACHE_PARTITION_ON
+/**
+ * The way a two-way cache miss at `addr` fills, given that the replacement policy would
+ * fill `lru_way` (see l2_cache_two_way_set_partitions()). Called by l2_cache_two_way.S on
+ * every miss.
+ */
+unsigned l2_cache_partition_way(
+    const unsigned addr,
+    const unsigned lru_way);
+#endif /* L2_CACHE_PARTITION_ON */
+
+#define L2_CACHE_REF_FILL_FN  __attribute__((fptrgroup("l2_cache_ref_fill_fptr_grp")))
+typedef const void* (*l2_cache_ref_fill_fn)(const unsigned);
+
+/**
+ * The loop of a reference engine: everything l2_cache_*.S does around each fill.
+ */
+void l2_cache_ref_run(
+    l2_cache_fill_source_t* source,
+    l2_cache_ref_fill_fn fill);
+
+#if defined(__XS3A__)
+/**
+ * A fill source which serves real SwMem fill requests. Never stops.
+ */
+void l2_cache_ref_swmem_source(
+    l2_cache_fill_source_t* source,
+    swmem_fill_t swmem);
+#endif // defined(__XS3A__)
+
+#if L2_CACHE_FLASH_SERVER_ON
+/**
+ * A read waiting in the flash server.
+ */
+typedef struct {
+    chanend_t client;   /// where the data goes
+    unsigned src;
+    unsigned bytes;     /// at most L2_CACHE_FLASH_SERVER_BUFFER_BYTES
+    unsigned priority;
+    unsigned skips;     /// times other requests have been served first
+} l2_cache_flash_request_t;
+
+/**
+ * Requests which the flash server serves with one flash read of `[src, src + bytes)`.
+ */
+typedef struct {
+    unsigned src;
+    unsigned bytes;
+    unsigned count;
+    unsigned request[L2_CACHE_FLASH_SERVER_QUEUE];  /// queue indices, the first chosen first
+} l2_cache_flash_batch_t;
+
+/**
+ * Pick the next batch from the `count` requests in `queue`: the oldest request with the
+ * highest priority, and every other request touching the range read for it while that fits
+ * in the server's buffer. Requests left out have their skips counted.
+ */
+void l2_cache_flash_server_plan(
+    l2_cache_flash_request_t* queue,
+    const unsigned count,
+    l2_cache_flash_batch_t* batch);
+#endif /* L2_CACHE_FLASH_SERVER_ON */
+
+#if L2_CACHE_PREFETCH_ON
+/**
+ * Called by the cache thread once each fill has been served, with the fill address
+ * (or 0 before the first fill).
+ */
+void l2_cache_prefetch_observe(
+    const unsigned fill_addr);
+
+/**
+ * Forget the streams and prefetched lines of the last cache. Called by l2_cache_engine_init().
+ */
+void l2_cache_prefetch_reset(void);
+#endif // L2_CACHE_PREFETCH_ON
+
+#if L2_CACHE_CONST_MAP_ON
+/**
+ * The 32 bytes of data for a fill in a constant run (see l2_cache_set_const_map()), or NULL
+ * if the fill isn't in one. Called by the engines on every miss, before anything is evicted.
+ */
+const void* l2_cache_const_fill(
+    const unsigned fill_addr);
+
+/**
+ * Whether `[addr, addr + bytes)` is all in one constant run.
+ */
+unsigned l2_cache_const_covers(
+    const unsigned addr,
+    const unsigned bytes);
+#endif // L2_CACHE_CONST_MAP_ON
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+/**
+ * Serve a miss at the line-aligned flash address `line_addr`, whose slot `dst` the engine has
+ * already claimed, fetching as many lines as its region currently gets.
+ */
+void l2_cache_adaptive_fetch(
+    void* dst,
+    const unsigned line_addr);
+
+/**
+ * Called by the cache thread once each fill has been served, with the fill address
+ * (or 0 before the first fill).
+ */
+void l2_cache_adaptive_observe(
+    const unsigned fill_addr);
+
+/**
+ * Forget everything learnt about the last cache. Called by l2_cache_engine_init().
+ */
+void l2_cache_adaptive_reset(void);
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+
+#if L2_CACHE_HEATMAP_ON
+/**
+ * Count a miss at `fill_addr` which is about to be read from flash. Called by the engines.
+ */
+void l2_cache_heatmap_miss(
+    const unsigned fill_addr);
+
+/**
+ * Count a hit at `fill_addr`. Called by the engines with L2_CACHE_HEATMAP_HITS_ON.
+ */
+void l2_cache_heatmap_hit(
+    const unsigned fill_addr);
+#endif // L2_CACHE_HEATMAP_ON
+
+#endif /* L2_CACHE_INTERNAL_H_ */
@@ -0,0 +1,126 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_PARTITION_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+// Keeps the compiler from publishing a map before it's been written, or from reading a map
+// before saying it's being read
+#define COMPILER_BARRIER()  asm volatile("" ::: "memory")
+
+typedef struct {
+    unsigned count;
+    unsigned other_way;
+    struct {
+        unsigned start;
+        unsigned len;
+        unsigned way;
+    } partition[L2_CACHE_MAX_PARTITIONS];
+} partition_map_t;
+
+/*
+  The cache thread reads whichever map is active on each miss, while new partitions are
+  written into the other one and then made active with a single store. A miss served while
+  the partitions change follows either the old ones or the new ones.
+
+  The map which isn't active may still be being read by a miss which started before it
+  stopped being active, so before writing into it, l2_cache_two_way_set_partitions() waits
+  until the cache thread isn't reading it. The cache thread says which map it's reading in
+  reading_map, then checks that map is still the active one, so a map seen as not being read
+  after it stopped being active can't be read again until it's made active once more.
+*/
+static partition_map_t maps[2];
+
+// NULL when there are no partitions
+static partition_map_t* volatile active_map = NULL;
+
+// The map the cache thread is reading, or NULL
+static const partition_map_t* volatile reading_map = NULL;
+
+
+unsigned l2_cache_partition_way(
+    const unsigned addr,
+    const unsigned lru_way)
+{
+    const partition_map_t* map;
+
+    do {
+        map = active_map;
+        reading_map = map;
+        COMPILER_BARRIER();
+    } while(map != active_map);
+
+    if(map == NULL)
+        return lru_way;
+
+    unsigned way = map->other_way;
+
+    for(int k = 0; k < map->count; k++) {
+        if(addr - map->partition[k].start < map->partition[k].len) {
+            way = map->partition[k].way;
+            break;
+        }
+    }
+
+    COMPILER_BARRIER();
+    reading_map = NULL;
+
+    return (way == L2_CACHE_WAY_ANY)? lru_way : way;
+}
+
+
+void l2_cache_two_way_set_partitions(
+    const l2_cache_partition_t partitions[],
+    const unsigned count,
+    const unsigned other_way)
+{
+    DEBUG_ASSERT( count <= L2_CACHE_MAX_PARTITIONS );
+    DEBUG_ASSERT( other_way <= L2_CACHE_WAY_ANY );
+
+    if(count == 0 && other_way == L2_CACHE_WAY_ANY) {
+        active_map = NULL;
+        DEBUG_PRINT("%s", "Partitions: none\n");
+        return;
+    }
+
+    partition_map_t* map = (active_map == &maps[0])? &maps[1] : &maps[0];
+
+    // A miss which started before it stopped being active may still be reading it (this
+    // takes no longer than that miss takes to look through it)
+    while(reading_map == map)
+        ;
+
+    COMPILER_BARRIER();
+
+    for(int k = 0; k < count; k++) {
+        DEBUG_ASSERT( partitions[k].way <= L2_CACHE_WAY_ANY );
+
+        map->partition[k].start = (unsigned) partitions[k].start;
+        map->partition[k].len = partitions[k].len;
+        map->partition[k].way = partitions[k].way;
+
+        DEBUG_PRINT("Partition %d: 0x%08X - 0x%08X, way %u\n", k, (unsigned) partitions[k].start,
+                    (unsigned) partitions[k].start + partitions[k].len - 1, partitions[k].way);
+    }
+
+    map->count = count;
+    map->other_way = other_way;
+
+    DEBUG_PRINT("Partitions: everything else in way %u\n", other_way);
+
+    COMPILER_BARRIER();
+
+    active_map = map;
+}
+
+#endif // L2_CACHE_PARTITION_ON
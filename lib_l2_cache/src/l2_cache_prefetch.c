@@ -0,0 +1,203 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_PREFETCH_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+/*
+
+Reference prediction table
+
+  Region | Last Addr | Stride | Confidence | Last Seen
+  ----------------------------------------------------
+   ...   |    ...    |  ...   |    ...     |    ...
+
+  Region: Fill address >> L2_CACHE_PREFETCH_REGION_BITS. Each stream lives in one region.
+  Last Addr: The most recent fill address seen in the region
+  Stride: Difference between the last two (different) fill addresses seen in the region
+  Confidence: Number of times in a row Stride has repeated (saturates)
+  Last Seen: When the region last had a fill; the least recently seen entry is replaced
+             by a new region
+
+  Fill addresses are always 32-byte aligned, so strides under 32 bytes look like 32
+  bytes, which is exactly what the cache thread sees of them anyway.
+
+*/
+
+#define MAX_CONFIDENCE  (L2_CACHE_PREFETCH_CONFIDENCE + 1)
+
+typedef struct {
+    unsigned region;
+    unsigned last_addr;
+    int stride;
+    unsigned confidence;
+    unsigned last_seen;
+} stream_t;
+
+static struct {
+    stream_t stream[L2_CACHE_PREFETCH_STREAMS];
+    unsigned tick;        /// fills observed, wrapping (harmlessly) after 2^32
+    unsigned distance;
+
+    /// Ring of recently prefetched lines, for counting how many get used
+    unsigned tracked[L2_CACHE_PREFETCH_TRACKED_LINES];
+    unsigned tracked_next;
+} prefetch = {
+    .distance = L2_CACHE_PREFETCH_DISTANCE,
+};
+
+__typeof__(l2_cache_prefetch_stats) l2_cache_prefetch_stats;
+
+
+void l2_cache_prefetch_set_distance(
+    const unsigned distance)
+{
+    prefetch.distance = distance;
+}
+
+
+void l2_cache_prefetch_reset(void)
+{
+    for(int k = 0; k < L2_CACHE_PREFETCH_STREAMS; k++)
+        prefetch.stream[k].last_seen = 0;
+
+    for(int k = 0; k < L2_CACHE_PREFETCH_TRACKED_LINES; k++)
+        prefetch.tracked[k] = 0;
+
+    prefetch.tick = 0;
+    prefetch.tracked_next = 0;
+}
+
+
+static stream_t* find_stream(
+    const unsigned region)
+{
+    stream_t* oldest = &prefetch.stream[0];
+
+    prefetch.tick++;
+
+    for(int k = 0; k < L2_CACHE_PREFETCH_STREAMS; k++) {
+        stream_t* s = &prefetch.stream[k];
+
+        if(s->last_seen != 0 && s->region == region) {
+            s->last_seen = prefetch.tick;
+            return s;
+        }
+
+        if(s->last_seen < oldest->last_seen)
+            oldest = s;
+    }
+
+    // Unused entries were last seen at 0, so they're always picked first
+    oldest->region = region;
+    oldest->last_addr = 0;
+    oldest->stride = 0;
+    oldest->confidence = 0;
+    oldest->last_seen = prefetch.tick;
+    return oldest;
+}
+
+
+// Counts the fill as useful if it's the first one from a prefetched line
+static void check_tracked(
+    const unsigned line_addr)
+{
+    for(int k = 0; k < L2_CACHE_PREFETCH_TRACKED_LINES; k++) {
+        if(prefetch.tracked[k] == line_addr) {
+            prefetch.tracked[k] = 0;
+            l2_cache_prefetch_stats.useful_count++;
+            return;
+        }
+    }
+}
+
+
+static void issue(
+    const unsigned line_addr)
+{
+    if(line_addr < XS1_SWMEM_BASE || line_addr >= SWMEM_END)
+        return;
+
+    const unsigned outer = l2_cache_fill_begin();
+    void* dst = l2_cache_engine.claim(line_addr);
+
+    // Already cached
+    if(dst == NULL) {
+        l2_cache_fill_end(outer);
+        return;
+    }
+
+    l2_cache_fetch_lines(line_addr, 1, dst);
+    l2_cache_fill_end(outer);
+
+    l2_cache_prefetch_stats.issued_count++;
+    prefetch.tracked[prefetch.tracked_next] = line_addr;
+    prefetch.tracked_next = (prefetch.tracked_next + 1) % L2_CACHE_PREFETCH_TRACKED_LINES;
+}
+
+
+/**
+ * Called by the cache thread once each fill has been served.
+ *
+ * Any prefetch is read here, before the cache thread takes the next fill request, so a fill
+ * requested meanwhile waits for it as it would behind a miss.
+ */
+void l2_cache_prefetch_observe(
+    const unsigned fill_addr)
+{
+    // Nothing has been filled yet
+    if(fill_addr == 0)
+        return;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned line_addr = (fill_addr >> line_bits) << line_bits;
+
+    check_tracked(line_addr);
+
+    stream_t* s = find_stream(fill_addr >> L2_CACHE_PREFETCH_REGION_BITS);
+
+    const int stride = fill_addr - s->last_addr;
+    const unsigned first = (s->last_addr == 0);
+    s->last_addr = fill_addr;
+
+    if(first || stride == 0)
+        return;
+
+    if(stride == s->stride) {
+        if(s->confidence < MAX_CONFIDENCE)
+            s->confidence++;
+    } else {
+        s->stride = stride;
+        s->confidence = 0;
+    }
+
+    if(s->confidence < L2_CACHE_PREFETCH_CONFIDENCE || prefetch.distance == 0)
+        return;
+
+    // Always look at least a line ahead, or short strides would never leave this line
+    int ahead = stride * (int) prefetch.distance;
+    const int line_bytes = 1 << line_bits;
+
+    if(ahead > -line_bytes && ahead < line_bytes)
+        ahead = (stride > 0)? line_bytes : -line_bytes;
+
+    const unsigned target = fill_addr + ahead;
+
+    issue((target >> line_bits) << line_bits);
+}
+
+#endif // L2_CACHE_PREFETCH_ON
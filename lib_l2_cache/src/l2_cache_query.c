@@ -0,0 +1,88 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_QUERY_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+// Keeps the compiler from moving table reads across reads of l2_cache_fill_seq
+#define COMPILER_BARRIER()  asm volatile("" ::: "memory")
+
+#define BITMAP_BITS  (32)
+
+
+// Residency of `line_count` (at most 32) consecutive lines from `line_addr`, all looked up
+// while the cache thread wasn't replacing lines
+static uint32_t query_lines(
+    const unsigned line_addr,
+    const unsigned line_count,
+    const unsigned line_bytes)
+{
+    while(1) {
+        const unsigned seq = l2_cache_fill_seq;
+
+        // The tables are part way through changing; this doesn't last longer than a miss
+        if(seq & 1)
+            continue;
+
+        COMPILER_BARRIER();
+
+        uint32_t bits = 0;
+        unsigned addr = line_addr;
+
+        for(int k = 0; k < line_count; k++, addr += line_bytes) {
+            if(addr >= XS1_SWMEM_BASE && addr < SWMEM_END && l2_cache_engine.lookup(addr) != NULL)
+                bits |= 1u << k;
+        }
+
+        COMPILER_BARRIER();
+
+        if(l2_cache_fill_seq == seq)
+            return bits;
+    }
+}
+
+
+unsigned l2_cache_query_range(
+    const void* address,
+    const size_t len,
+    uint32_t* bitmap_out)
+{
+    // No single engine (e.g. a region cache) to look in
+    if(l2_cache_engine.lookup == NULL || len == 0)
+        return 0;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    const unsigned line_bytes = 1 << line_bits;
+
+    const unsigned first = ((unsigned) address) & ~(line_bytes - 1);
+    const unsigned last = (((unsigned) address) + len - 1) & ~(line_bytes - 1);
+    const unsigned line_count = ((last - first) >> line_bits) + 1;
+
+    unsigned resident = 0;
+
+    for(int k = 0; k < line_count; k += BITMAP_BITS) {
+        const unsigned count = (line_count - k < BITMAP_BITS)? line_count - k : BITMAP_BITS;
+        const uint32_t bits = query_lines(first + (k << line_bits), count, line_bytes);
+
+        bitmap_out[k / BITMAP_BITS] = bits;
+        resident += __builtin_popcount(bits);
+    }
+
+    return resident;
+}
+
+#endif // L2_CACHE_QUERY_ON
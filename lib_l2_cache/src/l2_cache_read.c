@@ -0,0 +1,124 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_BULK_READ_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+// Keeps the compiler from moving table or slot reads across reads of l2_cache_fill_seq
+#define COMPILER_BARRIER()  asm volatile("" ::: "memory")
+
+
+// Copy part of one line out of the cache buffer. Returns 0 (and the copy must be redone from
+// flash) if the line isn't cached, or the cache thread replaced lines at any point meanwhile.
+static unsigned copy_if_cached(
+    uint8_t* dst,
+    const unsigned src,
+    const unsigned bytes,
+    const unsigned line_addr)
+{
+    const unsigned seq = l2_cache_fill_seq;
+
+    if(seq & 1)
+        return 0;
+
+    COMPILER_BARRIER();
+
+    const uint8_t* slot = l2_cache_engine.lookup(line_addr);
+
+    if(slot == NULL)
+        return 0;
+
+    memcpy(dst, &slot[src - line_addr], bytes);
+
+    COMPILER_BARRIER();
+
+    return l2_cache_fill_seq == seq;
+}
+
+
+static void read_uncached(
+    uint8_t* dst,
+    unsigned src,
+    size_t bytes)
+{
+    while(bytes != 0) {
+        const size_t chunk = (bytes < L2_CACHE_BULK_READ_CHUNK_BYTES)?
+                                    bytes : L2_CACHE_BULK_READ_CHUNK_BYTES;
+
+        l2_cache_flash_read(dst, (const void*) src, chunk);
+
+        dst += chunk;
+        src += chunk;
+        bytes -= chunk;
+    }
+}
+
+
+void l2_cache_read(
+    void* dst,
+    const void* src,
+    const size_t len)
+{
+    unsigned addr = (unsigned) src;
+
+    // Not backed by flash, so an ordinary copy is all that's needed. Nor is there a single
+    // engine's lines to copy from with a region or compressed cache, so that's copied through
+    // the SwMem fills as well.
+    if(addr < XS1_SWMEM_BASE || addr >= SWMEM_END || l2_cache_engine.claim == NULL) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    DEBUG_ASSERT( addr + len <= SWMEM_END );
+
+    const unsigned line_bytes = 1 << l2_cache_engine.line_bits;
+
+    uint8_t* out = dst;
+    size_t left = len;
+
+    // Uncached bytes seen but not yet read, which are read as a single run
+    uint8_t* pending_dst = out;
+    unsigned pending_src = addr;
+    size_t pending = 0;
+
+    while(left != 0) {
+        const unsigned line_addr = addr & ~(line_bytes - 1);
+        unsigned bytes = line_addr + line_bytes - addr;
+        if(bytes > left)
+            bytes = left;
+
+        if(copy_if_cached(out, addr, bytes, line_addr)) {
+            read_uncached(pending_dst, pending_src, pending);
+            pending = 0;
+        } else {
+            if(pending == 0) {
+                pending_dst = out;
+                pending_src = addr;
+            }
+            pending += bytes;
+        }
+
+        out += bytes;
+        addr += bytes;
+        left -= bytes;
+    }
+
+    read_uncached(pending_dst, pending_src, pending);
+}
+
+#endif // L2_CACHE_BULK_READ_ON
@@ -0,0 +1,75 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+#include <xcore/swmem_fill.h>
+
+#include "l2_cache.h"
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_DEBUG_ON && !defined(__XS3A__)
+// There's no l2_cache_misc.S off-target
+__typeof__(l2_cache_debug_stats) l2_cache_debug_stats;
+#endif // L2_CACHE_DEBUG_ON && !defined(__XS3A__)
+
+
+void l2_cache_ref_run(
+    l2_cache_fill_source_t* source,
+    l2_cache_ref_fill_fn fill)
+{
+    l2_cache_engine_start();
+
+    unsigned fill_addr = 0;
+
+    while(1) {
+#if L2_CACHE_PREFETCH_ON
+        l2_cache_prefetch_observe(fill_addr);
+#endif // L2_CACHE_PREFETCH_ON
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+        l2_cache_adaptive_observe(fill_addr);
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+
+        fill_addr = source->next(source);
+
+        if(fill_addr == 0)
+            return;
+
+        source->complete(source, fill_addr, fill(fill_addr));
+    }
+}
+
+
+#if defined(__XS3A__)
+
+L2_CACHE_FILL_NEXT_FN
+static unsigned swmem_next(
+    l2_cache_fill_source_t* source)
+{
+    return swmem_fill_in((swmem_fill_t) source->context);
+}
+
+L2_CACHE_FILL_COMPLETE_FN
+static void swmem_complete(
+    l2_cache_fill_source_t* source,
+    const unsigned fill_addr,
+    const void* data)
+{
+    swmem_fill_populate_from_buffer((swmem_fill_t) source->context, (fill_slot_t) fill_addr,
+                                    (const uint32_t*) data);
+}
+
+void l2_cache_ref_swmem_source(
+    l2_cache_fill_source_t* source,
+    swmem_fill_t swmem)
+{
+    source->next = swmem_next;
+    source->complete = swmem_complete;
+    source->context = (void*) swmem;
+}
+
+#endif // defined(__XS3A__)
@@ -0,0 +1,187 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+#include <xclib.h>
+#include <xcore/swmem_fill.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define FILL_BYTES  (32)
+
+typedef struct {
+    unsigned start;
+    unsigned bytes;     /// ~0 for a region with len 0, which contains everything
+    l2_cache_region_type_t type;
+#if L2_CACHE_TRANSFORM_ON
+    L2_CACHE_TRANSFORM_FN
+    l2_cache_transform_fn transform;
+    unsigned encoded;
+    unsigned encoded_line_bytes;
+    unsigned line_bits;
+#endif // L2_CACHE_TRANSFORM_ON
+    union {
+        l2_cache_direct_map_config_t direct_map;
+        l2_cache_two_way_config_t two_way;
+    } config;
+} region_t;
+
+static struct {
+    swmem_fill_t swmem_fill_handle;
+    L2_CACHE_SWMEM_READ_FN
+    l2_cache_swmem_read_fn read_func;
+    unsigned count;
+    region_t region[L2_CACHE_MAX_REGIONS];
+#if L2_CACHE_TRANSFORM_ON
+    const region_t* filling;  /// region whose cache is serving the current fill
+#endif // L2_CACHE_TRANSFORM_ON
+} regions;
+
+#if L2_CACHE_TRANSFORM_ON
+// Encoded line, on its way to being decoded into the cache
+static uint32_t transform_buffer[L2_CACHE_TRANSFORM_MAX_BYTES / sizeof(uint32_t)];
+
+
+// Read function of the caches of regions with a transform. Reads the encoded line instead,
+// and decodes it into the cache. Only a region's cache calls it, from within
+// l2_cache_regions_fill(), which has already found the region.
+L2_CACHE_SWMEM_READ_FN
+static void transform_read(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    const region_t* r = regions.filling;
+
+    DEBUG_ASSERT( r->transform != NULL );
+    DEBUG_ASSERT( ((unsigned) src) - r->start < r->bytes );
+
+    const unsigned line = (((unsigned) src) - r->start) >> r->line_bits;
+    const void* encoded = (const void*) (r->encoded + line * r->encoded_line_bytes);
+
+    regions.read_func(transform_buffer, encoded, r->encoded_line_bytes);
+    r->transform(dst, transform_buffer, r->encoded_line_bytes, bytes);
+}
+#endif // L2_CACHE_TRANSFORM_ON
+
+
+const void* l2_cache_regions_fill(
+    const unsigned fill_addr)
+{
+    for(int k = 0; k < regions.count; k++) {
+        region_t* r = &regions.region[k];
+
+        // Addresses below start wrap round to large offsets
+        if(fill_addr - r->start >= r->bytes)
+            continue;
+
+#if L2_CACHE_TRANSFORM_ON
+        regions.filling = r;
+#endif // L2_CACHE_TRANSFORM_ON
+
+        if(r->type == L2_CACHE_REGION_TWO_WAY)
+            return l2_cache_two_way_fill(&r->config.two_way, fill_addr);
+        else
+            return l2_cache_direct_map_fill(&r->config.direct_map, fill_addr);
+    }
+
+    // In no region, so not cached at all
+    static uint32_t uncached[FILL_BYTES / sizeof(uint32_t)];
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.fill_request_count++;
+    l2_cache_debug_stats.miss_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+    regions.read_func(uncached, (const void*) fill_addr, FILL_BYTES);
+    return uncached;
+}
+
+
+void l2_cache_regions(void* unused)
+{
+#if defined(__XS3A__)
+    const swmem_fill_t swmem = regions.swmem_fill_handle;
+
+    while(1) {
+        const fill_slot_t fill_addr = swmem_fill_in(swmem);
+        swmem_fill_populate_from_buffer(swmem, fill_addr,
+                                        (const uint32_t*) l2_cache_regions_fill(fill_addr));
+    }
+#endif // defined(__XS3A__)
+}
+
+
+L2_CACHE_SETUP_FN_ATTR
+int l2_cache_setup_regions(
+    const l2_cache_region_t region_list[],
+    const unsigned region_count,
+    l2_cache_swmem_read_fn read_func)
+{
+    DEBUG_ASSERT( region_count <= L2_CACHE_MAX_REGIONS );
+
+    regions.read_func = read_func;
+    regions.count = 0;
+
+    for(int k = 0; k < region_count; k++) {
+        const l2_cache_region_t* from = &region_list[k];
+        region_t* r = &regions.region[k];
+
+        r->start = (unsigned) from->start;
+        r->bytes = (from->len == 0)? ~0u : from->len;
+        r->type = from->type;
+
+        if(from->len == 0)
+            r->start = 0;
+
+        L2_CACHE_SWMEM_READ_FN
+        l2_cache_swmem_read_fn region_read_func = read_func;
+
+#if L2_CACHE_TRANSFORM_ON
+        r->transform = from->transform;
+        r->encoded = (unsigned) from->encoded;
+        r->encoded_line_bytes = from->encoded_line_bytes;
+        r->line_bits = 31 - clz(from->line_size_bytes);
+
+        if(r->transform != NULL) {
+            DEBUG_ASSERT( (r->start & (from->line_size_bytes - 1)) == 0 ); // start is line-aligned
+            DEBUG_ASSERT( r->encoded_line_bytes <= L2_CACHE_TRANSFORM_MAX_BYTES );
+
+            region_read_func = transform_read;
+        }
+#endif // L2_CACHE_TRANSFORM_ON
+
+        const int status = (r->type == L2_CACHE_REGION_TWO_WAY)?
+            l2_cache_two_way_config_init(&r->config.two_way, from->line_count,
+                                         from->line_size_bytes, from->cache_buffer,
+                                         region_read_func) :
+            l2_cache_direct_map_config_init(&r->config.direct_map, from->line_count,
+                                            from->line_size_bytes, from->cache_buffer,
+                                            region_read_func);
+        if(status < 0)
+            return -1;
+
+        DEBUG_PRINT("Region %d: 0x%08X + %u: %s, %u x %u bytes\n", k, r->start, from->len,
+                    (r->type == L2_CACHE_REGION_TWO_WAY)? "two-way" : "direct-map",
+                    from->line_count, from->line_size_bytes);
+    }
+
+    regions.swmem_fill_handle = swmem_fill_get();
+    regions.count = region_count;
+
+    // Preload and the like need a single cache. With debug on, they check for these.
+    l2_cache_engine.claim = NULL;
+    l2_cache_engine.lookup = NULL;
+    l2_cache_engine.line_at = NULL;
+
+    return 0;
+}
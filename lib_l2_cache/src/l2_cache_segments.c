@@ -0,0 +1,65 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_SEGMENTS_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+
+// Fill the table with groups of `group_bytes`, taking each segment in turn. Returns the
+// number of groups placed, at most `group_count`.
+static unsigned place_groups(
+    void* table[],
+    const unsigned group_count,
+    const unsigned group_bytes,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count)
+{
+    unsigned placed = 0;
+
+    for(int k = 0; k < segment_count && placed < group_count; k++) {
+        const unsigned end = ((unsigned) segments[k].buffer) + segments[k].bytes;
+        unsigned start = (((unsigned) segments[k].buffer) + 3) & ~3;
+
+        while(placed < group_count && start <= end && end - start >= group_bytes) {
+            table[placed++] = (void*) start;
+            start += group_bytes;
+        }
+    }
+
+    return placed;
+}
+
+
+int l2_cache_segments_assign(
+    void* table[],
+    const unsigned set_count,
+    const unsigned set_bytes,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count)
+{
+    for(int bits = 0; bits <= L2_CACHE_SEGMENT_TABLE_BITS && (1 << bits) <= set_count; bits++) {
+        const unsigned group_count = 1 << bits;
+        const unsigned group_bytes = (set_count >> bits) * set_bytes;
+
+        if(place_groups(table, group_count, group_bytes, segments, segment_count) == group_count) {
+            DEBUG_PRINT("Segments: %u groups of %u sets (%u bytes)\n", group_count,
+                        set_count >> bits, group_bytes);
+            return bits;
+        }
+    }
+
+    DEBUG_PRINT("Segments: %u sets of %u bytes don't fit\n", set_count, set_bytes);
+    return -1;
+}
+
+#endif // L2_CACHE_SEGMENTS_ON
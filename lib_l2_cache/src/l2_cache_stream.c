@@ -0,0 +1,173 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xcore/hwtimer.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_STREAM_ON
+
+#if defined(__XS3A__)
+#include <xcore/chanend.h>
+#endif // defined(__XS3A__)
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+/*
+
+Protocol
+
+  The two chanends are a streaming channel, left open until the stream is freed:
+
+    fetch thread -> application:   i (tile i is in buffer i % 2)
+    application -> fetch thread:   i (tile i is released)
+
+  The fetch thread reads tile i once tile i-2 is released, so neither side has more than two
+  words waiting. Once the fetch thread has had the last release, each side sends an END and
+  checks for the other's, which closes the channel before its chanends are freed.
+
+  There's no fetch thread on the host, where l2_cache_stream_acquire() reads each tile itself.
+
+*/
+
+
+static void fetch_tile(
+    const l2_cache_stream_t* stream,
+    const unsigned k)
+{
+    const l2_cache_stream_tile_t* tile = &stream->tile[k];
+
+    l2_cache_flash_read(stream->buffer[k & 1], tile->src, tile->bytes);
+}
+
+
+void l2_cache_stream_init(
+    l2_cache_stream_t* stream,
+    const l2_cache_stream_tile_t tiles[],
+    const unsigned count,
+    void* buffer_a,
+    void* buffer_b)
+{
+    DEBUG_ASSERT( l2_cache_engine.claim != NULL ); // cache has been set up
+
+    stream->tile = tiles;
+    stream->count = count;
+    stream->buffer[0] = buffer_a;
+    stream->buffer[1] = buffer_b;
+    stream->acquired = 0;
+    stream->released = 0;
+    stream->wait_ticks = 0;
+
+#if defined(__XS3A__)
+    stream->app_end = chanend_alloc();
+    stream->fetch_end = chanend_alloc();
+    DEBUG_ASSERT( stream->app_end != 0 && stream->fetch_end != 0 );
+
+    chanend_set_dest(stream->app_end, stream->fetch_end);
+    chanend_set_dest(stream->fetch_end, stream->app_end);
+#endif // defined(__XS3A__)
+
+    DEBUG_PRINT("Stream: %u tiles\n", count);
+}
+
+
+const void* l2_cache_stream_acquire(
+    l2_cache_stream_t* stream)
+{
+    if(stream->acquired == stream->count)
+        return NULL;
+
+    DEBUG_ASSERT( stream->acquired == stream->released ); // one tile held at a time
+
+    const unsigned k = stream->acquired++;
+
+#if defined(__XS3A__)
+    const unsigned t0 = get_reference_time();
+    const unsigned ready = chanend_in_word(stream->app_end);
+    stream->wait_ticks += get_reference_time() - t0;
+
+    DEBUG_ASSERT( ready == k );
+#else
+    fetch_tile(stream, k);
+#endif // defined(__XS3A__)
+
+    return stream->buffer[k & 1];
+}
+
+
+void l2_cache_stream_release(
+    l2_cache_stream_t* stream)
+{
+    DEBUG_ASSERT( stream->released + 1 == stream->acquired ); // a tile is held
+
+    const unsigned k = stream->released++;
+
+#if defined(__XS3A__)
+    chanend_out_word(stream->app_end, k);
+#else
+    (void) k;
+#endif // defined(__XS3A__)
+}
+
+
+#if defined(__XS3A__)
+
+void l2_cache_stream_thread(
+    void* arg)
+{
+    l2_cache_stream_t* stream = arg;
+    const chanend_t c = stream->fetch_end;
+    const unsigned count = stream->count;
+
+    for(unsigned k = 0; k < count; k++) {
+        // Tile k goes where tile k-2 was
+        if(k >= 2) {
+            const unsigned released = chanend_in_word(c);
+            DEBUG_ASSERT( released == k - 2 );
+        }
+
+        fetch_tile(stream, k);
+        chanend_out_word(c, k);
+    }
+
+    // The releases not yet taken
+    for(unsigned k = (count > 2)? count - 2 : 0; k < count; k++)
+        chanend_in_word(c);
+
+    chanend_out_end_token(c);
+    chanend_check_end_token(c);
+}
+
+
+void l2_cache_stream_free(
+    l2_cache_stream_t* stream)
+{
+    DEBUG_ASSERT( stream->released == stream->count ); // every tile has been released
+
+    chanend_check_end_token(stream->app_end);
+    chanend_out_end_token(stream->app_end);
+
+    chanend_free(stream->app_end);
+    chanend_free(stream->fetch_end);
+
+    DEBUG_PRINT("Stream: waited %u ticks\n", stream->wait_ticks);
+}
+
+#else
+
+void l2_cache_stream_free(
+    l2_cache_stream_t* stream)
+{
+    DEBUG_ASSERT( stream->released == stream->count ); // every tile has been released
+}
+
+#endif // defined(__XS3A__)
+
+#endif // L2_CACHE_STREAM_ON
@@ -0,0 +1,76 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xclib.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+#if L2_CACHE_TRANSFORM_ON
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_int4(
+    void* line,
+    const void* encoded,
+    const size_t encoded_bytes,
+    const size_t line_bytes)
+{
+    const uint8_t* src = encoded;
+    int8_t* dst = line;
+
+    DEBUG_ASSERT( 2 * encoded_bytes == line_bytes );
+
+    for(int k = 0; k < encoded_bytes; k++) {
+        // Shift each nibble to the top, then back down to sign-extend it
+        dst[2 * k] = ((int8_t) (src[k] << 4)) >> 4;
+        dst[2 * k + 1] = ((int8_t) src[k]) >> 4;
+    }
+}
+
+
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_delta8(
+    void* line,
+    const void* encoded,
+    const size_t encoded_bytes,
+    const size_t line_bytes)
+{
+    const uint8_t* src = encoded;
+    uint8_t* dst = line;
+    uint8_t sum = 0;
+
+    DEBUG_ASSERT( encoded_bytes == line_bytes );
+
+    for(int k = 0; k < line_bytes; k++) {
+        sum += src[k];
+        dst[k] = sum;
+    }
+}
+
+
+L2_CACHE_TRANSFORM_FN
+void l2_cache_transform_byteswap32(
+    void* line,
+    const void* encoded,
+    const size_t encoded_bytes,
+    const size_t line_bytes)
+{
+    const uint32_t* src = encoded;
+    uint32_t* dst = line;
+
+    DEBUG_ASSERT( encoded_bytes == line_bytes );
+
+    for(int k = 0; k < line_bytes / sizeof(uint32_t); k++)
+        dst[k] = byterev(src[k]);
+}
+
+#endif // L2_CACHE_TRANSFORM_ON
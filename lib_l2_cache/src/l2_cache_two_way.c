@@ -10,6 +10,7 @@
 #include <xcore/hwtimer.h>
 
 #include "l2_cache.h"
+#include "l2_cache_internal.h"
 #include "xcore_utils.h"
 
 
@@ -23,7 +24,10 @@
 // =============== Misc =============== //
 
 // Tag table initialized to this to signal that the tag is dirty
-#define DIRTY_TAG_VALUE  (0xFFFFFFFF)
+#define DIRTY_TAG_VALUE  (0xFFFF)
+
+// Only the bottom TAG_BITS bits of a tag are kept in the tag table
+#define TAG_BITS         (16)
 
 // This N-way associative cache has N fixed at 2.
 #define N_WAY     (2)
@@ -36,25 +40,29 @@ static inline unsigned zext(const unsigned value, const unsigned bits)
 
 /*
 
-Memory layout is a table:
+Memory layout is three tables:
 
-  Index || Tag[0] | Tag[1] | Last | Dummy | Data[0] | Data[1]
-  -----------------------------------------------------------
-     0  ||  ...   |  ...   | ...  |  ...  |   ...   |   ...
-     1  ||  ...   |  ...   | ...  |  ...  |   ...   |   ...
-    ... ||  ...   |  ...   | ...  |  ...  |   ...   |   ...
+  Index || Tag[0] | Tag[1] || Last ||  Index || Data[0]     Index || Data[1]
+  ---------------------------------------------------------------------------
+     0  ||  ...   |  ...   ||  ... ||     0  ||   ...         0  ||   ...
+     1  ||  ...   |  ...   ||  ... ||     1  ||   ...         1  ||   ...
+    ... ||  ...   |  ...   ||  ... ||    ... ||   ...        ... ||   ...
 
-  Index: Row of the table above (see fill address bits below)
-         (Note: this isn't actually *in* the table)
-  Tag[X]: The tag associated with Data[X]  (1 word each)
-  Last: Indicates whether 0/1 had the most recent hit (1 word)
-  Dummy: [does nothing, but required to ensure 8-byte alignment] (1 word)
+  Index: Row of the tables above (see fill address bits below)
+         (Note: this isn't actually *in* the tables)
+  Tag[X]: The bottom 16 bits of the tag associated with Data[X]  (1 short each)
+  Last: Indicates whether 0/1 had the most recent hit (1 byte)
   Data[X]: The actual cached data (256 bytes)
 
   Notes:
-    - Tag[0] and Tag[1] are next to each other so that `ldd` can be used when checking for a hit
-      - This is also why the dummy field exists, and why the buffer must be 8-byte-aligned
-      - If I find that the `ldd` instruction doesn't actually speed anything up, those can be removed
+    - Tag[0] and Tag[1] are next to each other so that a single `ldw` fetches both when
+      checking for a hit
+    - The Last table is padded to a whole number of words so that the data is word-aligned
+    - Data[0] for every index comes first, then Data[1] for every index. The way 0 slot
+      is then found exactly as in the direct-mapped cache, and the way 1 slot is always
+      way_bytes after it.
+    - Compared with a full word for each tag, a word for Last and a dummy word for
+      alignment, this saves 11 bytes per set.
 
 ==============================================
 
@@ -76,7 +84,10 @@ Memory layout is a table:
  L:  Fill line index (indicates the 32-byte group within a 256-byte L2 cache line)
 
  Notes:
-  - The actual tag in a cache entry will be the tag bits above (T) zero-extended to 32 bits
+  - The tag kept in a cache entry is the bottom 16 bits of the tag bits above (T). Only
+    L2_CACHE_SWMEM_ADDRESS_BITS of the SwMem address are backed by flash, so as long as
+    the tag that leaves is at most 15 bits, two different lines can never share a tag,
+    and no line ever has the dirty tag 0xFFFF.
   - Minimum number of index bits (C) is 1.
     - There's no theoretical problem with 0 index bits, which would basically mean that the
       L2 cache is a thin layer over the minicache; however, where the `zext(reg, bits)`
@@ -92,44 +103,186 @@ Memory layout is a table:
 */
 
 
-// =============== Types =============== //
+extern l2_cache_two_way_config_t l2_cache_config_two_way;
+
+#define cache_config l2_cache_config_two_way
 
-typedef uint32_t tag_t;
+#if !defined(__XS3A__)
+// There's no l2_cache_two_way.S off-target, so the config lives here for the reference engine
+__typeof__(l2_cache_config_two_way) l2_cache_config_two_way;
+#endif // !defined(__XS3A__)
 
-typedef union {
-    uint8_t u8[32];
-    uint32_t u32[8];
-} l1_cache_line_t;
+// The way a miss at `addr` fills: the one which didn't have the last hit, unless the
+// partitions say otherwise
+static inline unsigned miss_way(
+    const unsigned addr,
+    const unsigned last_hit)
+{
+#if L2_CACHE_PARTITION_ON
+    return l2_cache_partition_way(addr, 1 - last_hit);
+#else
+    return 1 - last_hit;
+#endif // L2_CACHE_PARTITION_ON
+}
 
-typedef union {
-    l1_cache_line_t line[(L2_CACHE_LINE_SIZE_BYTES)/32];
-} l2_cache_line_t;
+// Where the way 0 data for a fill address is (or goes): its offset into the data table, or
+// with segments into its group's segment. The way 1 data is way_bytes after it.
+static inline uint8_t* data_at(
+    const l2_cache_two_way_config_t* config,
+    const unsigned addr)
+{
+#if L2_CACHE_SEGMENTS_ON
+    void* base = config->segment[(addr >> config->segment_shift) & config->segment_mask];
+#else
+    void* base = config->data_table;
+#endif // L2_CACHE_SEGMENTS_ON
 
-typedef struct {
-    tag_t tag[N_WAY];
-    uint32_t last_hit;
-    uint32_t dummy;
-    l2_cache_line_t slot[N_WAY];
-} l2_cache_entry_t;
+    return ((uint8_t*) base) + (addr & config->offset_mask);
+}
 
+// Does exactly what a miss does in l2_cache_two_way.S
+L2_CACHE_CLAIM_FN
+static void* l2_cache_two_way_claim(
+    const unsigned line_addr)
+{
+    unsigned addr = line_addr >> cache_config.line_size.bits;
+    const unsigned index = zext(addr, cache_config.index_bits);
+    const unsigned tag = zext(addr >> cache_config.index_bits, TAG_BITS);
 
-extern struct {
-    swmem_fill_t swmem_fill_handle; /// resource handle for SwMem fills
-    l2_cache_entry_t* entries;
-    unsigned index_bits;      /// log2() of the number of L2 cache entries
-    L2_CACHE_SWMEM_READ_FN
-    l2_cache_swmem_read_fn read_func;  /// function which populates the data table on a cache miss
-    struct {
-        unsigned bytes; /// Size of an L2 cache line in bytes
-        unsigned bits;  /// log2() of line_size.bytes
-    } line_size;
-    unsigned entry_bytes;
-} l2_cache_config_two_way;
+    l2_cache_tags_t* tags = &cache_config.tag_table[index];
 
-#define cache_config l2_cache_config_two_way
+    if(tags->tag[0] == tag || tags->tag[1] == tag)
+        return NULL;
 
-L2_CACHE_SETUP_FN_ATTR
-void l2_cache_setup_two_way(
+    const unsigned slot = miss_way(line_addr, cache_config.last_hit[index]);
+
+    cache_config.last_hit[index] = slot;
+    tags->tag[slot] = tag;
+
+    return data_at(&cache_config, index << cache_config.line_size.bits)
+                + slot * cache_config.way_bytes;
+}
+
+L2_CACHE_LOOKUP_FN
+static const void* l2_cache_two_way_lookup(
+    const unsigned line_addr)
+{
+    unsigned addr = line_addr >> cache_config.line_size.bits;
+    const unsigned index = zext(addr, cache_config.index_bits);
+    const unsigned tag = zext(addr >> cache_config.index_bits, TAG_BITS);
+
+    const l2_cache_tags_t* tags = &cache_config.tag_table[index];
+
+    for(int slot = 0; slot < N_WAY; slot++) {
+        if(tags->tag[slot] == tag)
+            return data_at(&cache_config, index << cache_config.line_size.bits)
+                        + slot * cache_config.way_bytes;
+    }
+
+    return NULL;
+}
+
+// Slots are numbered way-major, the same as the data table
+L2_CACHE_LINE_AT_FN
+static unsigned l2_cache_two_way_line_at(
+    const unsigned slot)
+{
+    const unsigned way = slot >> cache_config.index_bits;
+    const unsigned index = zext(slot, cache_config.index_bits);
+    const unsigned tag = cache_config.tag_table[index].tag[way];
+
+    if(tag == DIRTY_TAG_VALUE)
+        return 0;
+
+    return l2_cache_line_address(tag, index, cache_config.index_bits, cache_config.line_size.bits);
+}
+
+// Does exactly what l2_cache_two_way.S does for a single fill
+const void* l2_cache_two_way_fill(
+    l2_cache_two_way_config_t* config,
+    const unsigned fill_addr)
+{
+    unsigned addr = fill_addr >> config->line_size.bits;
+    const unsigned index = zext(addr, config->index_bits);
+    const unsigned tag = zext(addr >> config->index_bits, TAG_BITS);
+
+    // Way 0 slot; the way 1 slot is way_bytes after it
+    uint8_t* fill_data = data_at(config, fill_addr);
+    l2_cache_tags_t* tags = &config->tag_table[index];
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.fill_request_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+    // Way 1 is checked first
+    int way = (tags->tag[1] == tag)? 1 : (tags->tag[0] == tag)? 0 : -1;
+
+    if(way >= 0) {
+#if L2_CACHE_DEBUG_ON
+        l2_cache_debug_stats.hit_count++;
+#endif // L2_CACHE_DEBUG_ON
+#if L2_CACHE_HEATMAP_HITS_ON
+        l2_cache_heatmap_hit(fill_addr);
+#endif // L2_CACHE_HEATMAP_HITS_ON
+        config->last_hit[index] = way;
+        return fill_data + way * config->way_bytes;
+    }
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats.miss_count++;
+#endif // L2_CACHE_DEBUG_ON
+
+#if L2_CACHE_CONST_MAP_ON
+    const void* const_data = l2_cache_const_fill(fill_addr);
+    if(const_data != NULL)
+        return const_data;
+#endif // L2_CACHE_CONST_MAP_ON
+
+#if L2_CACHE_HEATMAP_ON
+    l2_cache_heatmap_miss(fill_addr);
+#endif // L2_CACHE_HEATMAP_ON
+
+    const unsigned outer = l2_cache_fill_begin();
+    const unsigned line_offset = zext(fill_addr, config->line_size.bits);
+
+    // Fill the way which didn't have the last hit (or the partition's way)
+    way = miss_way(fill_addr, config->last_hit[index]);
+    config->last_hit[index] = way;
+    tags->tag[way] = tag;
+    fill_data += way * config->way_bytes;
+
+    config->read_func(fill_data - line_offset, (void*) (fill_addr - line_offset),
+                      config->line_size.bytes);
+
+    l2_cache_fill_end(outer);
+
+    return fill_data;
+}
+
+L2_CACHE_REF_FILL_FN
+const void* l2_cache_two_way_ref_fill(
+    const unsigned fill_addr)
+{
+    return l2_cache_two_way_fill(&cache_config, fill_addr);
+}
+
+void l2_cache_two_way_ref(
+    l2_cache_fill_source_t* source)
+{
+    l2_cache_ref_run(source, l2_cache_two_way_ref_fill);
+}
+
+#if defined(__XS3A__)
+void l2_cache_two_way_ref_swmem(void* unused)
+{
+    l2_cache_fill_source_t source;
+    l2_cache_ref_swmem_source(&source, cache_config.swmem_fill_handle);
+    l2_cache_two_way_ref(&source);
+}
+#endif // defined(__XS3A__)
+
+int l2_cache_two_way_config_init(
+    l2_cache_two_way_config_t* config,
     const unsigned line_count,
     const unsigned line_size_bytes,
     void* cache_buffer,
@@ -138,49 +291,120 @@ void l2_cache_setup_two_way(
     const unsigned cache_index_bits = 31 - clz(line_count);
     const unsigned line_bits = 31 - clz(line_size_bytes);
 
-    // bytes
-    const unsigned entry_size = N_WAY * (line_size_bytes + sizeof(tag_t) + sizeof(uint32_t));
+    if(!l2_cache_tags_fit(line_bits, cache_index_bits, TAG_BITS))
+        return -1;
+
+    l2_cache_tags_t* tag_table = cache_buffer;
+    uint8_t* last_hit = (uint8_t*) &tag_table[line_count];
+    void* data_table = &last_hit[(line_count + sizeof(int) - 1) & ~(sizeof(int) - 1)];
 
     DEBUG_ASSERT( line_size_bytes >= 32 ); // minimum line size is 32 bytes
     DEBUG_ASSERT( (1<<line_bits) == line_size_bytes); // line_size_bytes is a power of 2
     DEBUG_ASSERT( (1<<cache_index_bits) == line_count ); // line_count is a power of 2
-    DEBUG_ASSERT( (((unsigned)cache_buffer) & 0x7) == 0); // buffer is 8-byte-aligned
+    DEBUG_ASSERT( (((unsigned)cache_buffer) & 0x3) == 0); // buffer is word-aligned
+
+    config->tag_table = tag_table;
+    config->last_hit = last_hit;
+    config->data_table = data_table;
+
+    config->index_bits = cache_index_bits;
+    config->read_func = read_func;
+    config->line_size.bytes = line_size_bytes;
+    config->line_size.bits = line_bits;
+    config->way_bytes = line_count * line_size_bytes;
+    config->offset_mask = (1 << (line_bits + cache_index_bits)) - 1;
+
+#if L2_CACHE_SEGMENTS_ON
+    // One segment, the data table
+    config->segment_shift = 0;
+    config->segment_mask = 0;
+    config->segment[0] = data_table;
+#endif // L2_CACHE_SEGMENTS_ON
 
-    cache_config.swmem_fill_handle = swmem_fill_get();
-    cache_config.entries = (l2_cache_entry_t*) cache_buffer;
+    for(int k = 0; k < line_count; k++){
+        for(int a = 0; a < N_WAY; a++) {
+            config->tag_table[k].tag[a] = DIRTY_TAG_VALUE;
+        }
 
-    cache_config.index_bits = cache_index_bits;
-    cache_config.read_func = read_func;
-    cache_config.line_size.bytes = line_size_bytes;
-    cache_config.line_size.bits = line_bits;
-    cache_config.entry_bytes = entry_size;
+        config->last_hit[k] = 0;
+    }
+
+    return 0;
+}
+
+L2_CACHE_SETUP_FN_ATTR
+int l2_cache_setup_two_way(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* cache_buffer,
+    l2_cache_swmem_read_fn read_func)
+{
+    if(l2_cache_two_way_config_init(&cache_config, line_count, line_size_bytes,
+                                    cache_buffer, read_func) < 0)
+        return -1;
+
+    cache_config.swmem_fill_handle = swmem_fill_get();
 
     #if L2_CACHE_DEBUG_ON
         // bytes
-        const unsigned cache_size = entry_size * line_count;
+        const unsigned cache_size = N_WAY * cache_config.way_bytes;
 
-        const unsigned buffer_end = ((unsigned)cache_buffer) + cache_size - 1;
+        const unsigned buffer_end = ((unsigned)cache_config.data_table) + cache_size - 1;
 
         DEBUG_PRINT("%s","Cache Type: 2-Way Set Associative (read-only)\n");
         DEBUG_PRINT("SwMem Fill Handle: %u\n", cache_config.swmem_fill_handle);
         DEBUG_PRINT("Line Size:   %u bytes (%u LSb's)\n", cache_config.line_size.bytes,
                                                           cache_config.line_size.bits);
         DEBUG_PRINT("Index Bits:  %u\n", cache_config.index_bits);
-        DEBUG_PRINT("Buffer:      0x%08X - 0x%08X\n", (unsigned) cache_config.entries, buffer_end);
+        DEBUG_PRINT("Buffer:      0x%08X - 0x%08X\n", (unsigned) cache_buffer, buffer_end);
+        DEBUG_PRINT("Data Table:  0x%08X\n", (unsigned) cache_config.data_table);
         DEBUG_PRINT("Read Func:   0x%08X\n", (unsigned) read_func);
-        DEBUG_PRINT("Cache Size: %u B\n", line_count * 2*line_size_bytes);
-        DEBUG_PRINT("Cache Entry Size: %u B\n", cache_config.entry_bytes);
+        DEBUG_PRINT("Cache Size: %u B\n", cache_size);
+        DEBUG_PRINT("Tag Table Size: %u B\n", ((unsigned) cache_config.data_table) - ((unsigned) cache_buffer));
     #endif // L2_CACHE_DEBUG_ON
 
-    for(int k = 0; k < line_count; k++){
-        for(int a = 0; a < N_WAY; a++) {
-            cache_config.entries[k].tag[a] = DIRTY_TAG_VALUE;
-        }
+    l2_cache_engine_init(l2_cache_two_way_claim, l2_cache_two_way_lookup,
+                         l2_cache_two_way_line_at,
+                         &cache_config.read_func, read_func,
+                         cache_config.line_size.bits, line_count, N_WAY * line_count);
 
-        cache_config.entries[k].dummy = 0;
-        cache_config.entries[k].last_hit = 0;
-    }
+    return 0;
+}
+
+#if L2_CACHE_SEGMENTS_ON
+int l2_cache_setup_two_way_segments(
+    const unsigned line_count,
+    const unsigned line_size_bytes,
+    void* tag_buffer,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count,
+    l2_cache_swmem_read_fn read_func)
+{
+    void* table[1 << L2_CACHE_SEGMENT_TABLE_BITS];
+
+    const int group_bits = l2_cache_segments_assign(table, line_count, N_WAY * line_size_bytes,
+                                                    segments, segment_count);
+    if(group_bits < 0)
+        return -1;
+
+    // Only the tags and last hits are in tag_buffer; the data table it implies is never used
+    if(l2_cache_setup_two_way(line_count, line_size_bytes, tag_buffer, read_func) < 0)
+        return -1;
+
+    // A group is the sets with the same top group_bits index bits, laid out in its segment
+    // as the whole cache is in a single buffer
+    cache_config.segment_shift = cache_config.line_size.bits + cache_config.index_bits - group_bits;
+    cache_config.segment_mask = (1 << group_bits) - 1;
+    cache_config.offset_mask = (1 << cache_config.segment_shift) - 1;
+    cache_config.way_bytes = (line_count >> group_bits) * line_size_bytes;
+    cache_config.data_table = table[0];
+
+    for(int k = 0; k < (1 << group_bits); k++)
+        cache_config.segment[k] = table[k];
+
+    return 0;
 }
+#endif // L2_CACHE_SEGMENTS_ON
 
 
 // Really for debugging purposes, but can't be hidden by L2_CACHE_DEBUG_ON because it's needed
@@ -199,19 +423,20 @@ l2_cache_two_way_addr_dbg_t l2_cache_two_way_get_addr_info(
     addr >>= cache_config.line_size.bits;
     x.entry_index = zext(addr, cache_config.index_bits);
     addr >>= cache_config.index_bits;
-    x.tag = addr;
+    x.tag = zext(addr, TAG_BITS);
     x.is_hit = 0;
 
     unsigned slot;
 
-    l2_cache_entry_t* entry = &cache_config.entries[x.entry_index];
-    x.entry.last_hit = entry->last_hit;
+    l2_cache_tags_t* tags = &cache_config.tag_table[x.entry_index];
+    x.entry.last_hit = cache_config.last_hit[x.entry_index];
 
     for(int k = 0; k < 2; k++) {
-        x.entry.tag[k] = entry->tag[k];
-        x.entry.slot[k] = (int*) &entry->slot[k];
+        x.entry.tag[k] = tags->tag[k];
+        x.entry.slot[k] = (int*) (data_at(&cache_config, x.entry_index << cache_config.line_size.bits)
+                                    + k * cache_config.way_bytes);
 
-        if(x.tag == entry->tag[k]) {
+        if(x.tag == tags->tag[k]) {
             x.hit.slot = k;
             x.is_hit = 1;
             slot = x.hit.slot;
@@ -219,14 +444,14 @@ l2_cache_two_way_addr_dbg_t l2_cache_two_way_get_addr_info(
     }
 
     if( !x.is_hit ) {
-        x.miss.evict_slot = 1 - entry->last_hit;
+        x.miss.evict_slot = miss_way((unsigned) address, x.entry.last_hit);
         x.miss.flash_src = (void*) (((unsigned)address) & ~(cache_config.line_size.bytes-1));
         x.miss.cache_dst = (void*) ((unsigned)x.entry.slot[x.miss.evict_slot]);
         x.miss.bytes = cache_config.line_size.bytes;
         slot = x.miss.evict_slot;
     }
 
-    x.cache_address = (void*) (((unsigned) &x.entry.slot[slot]) + x.slot_offset);
+    x.cache_address = (void*) (((unsigned) x.entry.slot[slot]) + x.slot_offset);
 
     return x;
 }
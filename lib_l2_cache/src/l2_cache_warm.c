@@ -0,0 +1,151 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache.h"
+#include "l2_cache_internal.h"
+#include "xcore_utils.h"
+
+// =============== Debugging Stuff =============== //
+#define DEBUG_PRINT(FMT, ...) do { if(L2_CACHE_DEBUG_ON) debug_printf( "[L2 Cache] "FMT, __VA_ARGS__); } while(0)
+#define DEBUG_ASSERT( CONDITION ) do{ if(L2_CACHE_DEBUG_ON) assert( CONDITION ); } while(0)
+
+#define SWMEM_END   (XS1_SWMEM_BASE + (1 << L2_CACHE_SWMEM_ADDRESS_BITS))
+
+// Runs read from the list at a time
+#define RUN_CHUNK   16
+
+static const l2_cache_warm_list_t* pending_list = NULL;
+
+
+static int compare_lines(
+    const void* a,
+    const void* b)
+{
+    const uint32_t x = *(const uint32_t*) a;
+    const uint32_t y = *(const uint32_t*) b;
+    return (x > y) - (x < y);
+}
+
+
+size_t l2_cache_warm_list_export(
+    l2_cache_warm_list_t* list,
+    const unsigned max_lines)
+{
+    // No single engine (e.g. a region cache) to list the lines of
+    if(l2_cache_engine.line_at == NULL)
+        return 0;
+
+    const unsigned line_bits = l2_cache_engine.line_bits;
+    unsigned count = 0;
+
+    for(int slot = 0; slot < l2_cache_engine.slot_count && count < max_lines; slot++) {
+        const unsigned addr = l2_cache_engine.line_at(slot);
+        if(addr != 0)
+            list->run[count++] = (addr - XS1_SWMEM_BASE) >> line_bits;
+    }
+
+    qsort(list->run, count, sizeof(uint32_t), compare_lines);
+
+    // Merge into runs in place; there are never more runs than lines
+    unsigned runs = 0;
+
+    for(int k = 0; k < count; k++) {
+        const unsigned line = list->run[k];
+
+        if(runs != 0) {
+            const unsigned first = L2_CACHE_WARM_RUN_FIRST(list->run[runs-1]);
+            const unsigned lines = L2_CACHE_WARM_RUN_LINES(list->run[runs-1]);
+
+            // A line seen twice (only possible in a snapshot of a running cache)
+            if(line < first + lines)
+                continue;
+
+            if(line == first + lines && lines < L2_CACHE_WARM_RUN_MAX_LINES) {
+                list->run[runs-1] = L2_CACHE_WARM_RUN(first, lines + 1);
+                continue;
+            }
+        }
+
+        list->run[runs++] = L2_CACHE_WARM_RUN(line, 1);
+    }
+
+    list->magic = L2_CACHE_WARM_LIST_MAGIC;
+    list->line_bytes = 1 << line_bits;
+    list->run_count = runs;
+
+    DEBUG_PRINT("Warm list: %u lines in %u runs\n", count, runs);
+
+    return L2_CACHE_WARM_LIST_BYTES(runs);
+}
+
+
+void l2_cache_warm_from_list(
+    const l2_cache_warm_list_t* list)
+{
+    // No single engine (e.g. a region cache) to load it into
+    if(l2_cache_engine.claim == NULL)
+        return;
+
+    pending_list = list;
+}
+
+
+// The cache isn't running yet, so a list in SwMem has to be read around it
+static void read_list(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    const unsigned addr = (unsigned) src;
+
+    if(addr >= XS1_SWMEM_BASE && addr < SWMEM_END)
+        l2_cache_flash_read(dst, src, bytes);
+    else
+        memcpy(dst, src, bytes);
+}
+
+
+void l2_cache_warm_pending(void)
+{
+    const l2_cache_warm_list_t* list = pending_list;
+    pending_list = NULL;
+
+    if(list == NULL)
+        return;
+
+    l2_cache_warm_list_t header;
+    read_list(&header, list, sizeof(header));
+
+    if(header.magic != L2_CACHE_WARM_LIST_MAGIC) {
+        DEBUG_PRINT("Warm list at 0x%08X is not valid\n", (unsigned) list);
+        return;
+    }
+
+    uint32_t run[RUN_CHUNK];
+
+    for(unsigned k = 0; k < header.run_count; k += RUN_CHUNK) {
+        unsigned count = header.run_count - k;
+        if(count > RUN_CHUNK)
+            count = RUN_CHUNK;
+
+        read_list(run, &list->run[k], count * sizeof(uint32_t));
+
+        // Each run is a single flash transaction (or as few as the cache's sets allow)
+        for(int j = 0; j < count; j++) {
+            const unsigned first = L2_CACHE_WARM_RUN_FIRST(run[j]);
+            const unsigned lines = L2_CACHE_WARM_RUN_LINES(run[j]);
+
+            l2_cache_preload((void*)(XS1_SWMEM_BASE + first * header.line_bytes),
+                             lines * header.line_bytes);
+        }
+    }
+
+    DEBUG_PRINT("Warm list: loaded %u runs\n", header.run_count);
+}
@@ -0,0 +1,12 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef BENCH_DATA_H_
+#define BENCH_DATA_H_
+
+// 256 KiB, with each element holding its own index
+#define BENCH_DATA_LEN (64 * 1024)
+
+extern const int bench_data[];
+
+#endif // BENCH_DATA_H_
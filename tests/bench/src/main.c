@@ -0,0 +1,290 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Fill latency benchmark, for tools/l2_cache_bench.py. Each workload reads BENCH_ACCESSES
+ * words of SwMem data, one per fill. The first BENCH_ACCESSES reads warm the cache and are
+ * thrown away; the next BENCH_ACCESSES are reported, on one line per workload:
+ *
+ *   BENCH {"engine": ..., "workload": ..., "cycles_per_fill": ..., ...}
+ *
+ * All the figures are integers, in core cycles. A read is counted as a miss if it took longer
+ * than a quarter of a line's flash read, as in the other test apps.
+ *
+ * The reference timer ticks every 6 core cycles, about a fifth of a hit, so single hits can't
+ * be timed. Instead the timer is read once between each read and the next, and the means are
+ * taken over spans of many reads: "cycles_per_fill" over the whole pass, and "hit_cycles" over
+ * each run of hits in turn, so a tick is lost or gained once a run rather than once a fill.
+ * Misses are long enough to time one by one, for the percentiles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <platform.h> // for PLATFORM_REFERENCE_MHZ
+#include <xcore/hwtimer.h>
+#include <xcore/thread.h>
+#include <xscope.h>
+
+#include "app_common.h"
+#include "bench_data.h"
+#include "flash_handler.h"
+#include "l2_cache.h"
+#include "debug_print.h"
+
+#define L2_CACHE_STACK_WORDS    (1000)
+
+#if BENCH_TWO_WAY
+#define ENGINE_NAME            "two_way"
+#define L2_CACHE_SETUP         l2_cache_setup_two_way
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_TWO_WAY
+#define SWMEM_THREAD           l2_cache_two_way
+#else
+#define ENGINE_NAME            "direct_map"
+#define L2_CACHE_SETUP         l2_cache_setup_direct_map
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
+#define SWMEM_THREAD           l2_cache_direct_map
+#endif // BENCH_TWO_WAY
+
+#define SWMEM_STACK_WORDS      L2_CACHE_STACK_WORDS
+
+#define L2_CACHE_BUFFER_ELMS L2_CACHE_BUFFER_SIZE(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+
+// SystemFrequency in XCORE-AI-EXPLORER.xn
+#define BENCH_CORE_MHZ        (600)
+
+#define TICKS_TO_CYCLES(T)    ((unsigned) (((uint64_t) (T) * BENCH_CORE_MHZ) / PLATFORM_REFERENCE_MHZ))
+
+// Reads per workload, warming up and then timed
+#define BENCH_ACCESSES        (4096)
+
+#define FILL_WORDS            (32 / sizeof(int))
+#define LINE_WORDS            (L2_CACHE_LINE_SIZE_BYTES / sizeof(int))
+
+// The hot workload's hot set, in words: half the cache
+#define HOT_WORDS             ((L2_CACHE_LINE_COUNT / 2) * LINE_WORDS)
+
+DWORD_ALIGNED
+static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
+
+DWORD_ALIGNED
+static int swmem_stack[SWMEM_STACK_WORDS];
+
+// Timer reads between the timed reads: stamp[k] before read k, stamp[k + 1] after it
+static unsigned stamp[BENCH_ACCESSES + 1];
+static unsigned miss_latency[BENCH_ACCESSES];
+
+typedef struct {
+    const char* name;
+    unsigned next;
+    uint32_t seed;
+} workload_t;
+
+static workload_t workloads[] = {
+    { "seq" },          // every fill in turn
+    { "line_stride" },  // the first fill of every line in turn
+    { "random" },       // any fill
+    { "hot" },          // nine in ten from a set half the size of the cache, the rest anywhere
+};
+
+#define WORKLOAD_COUNT  (sizeof(workloads) / sizeof(workloads[0]))
+
+
+static uint32_t xorshift(
+    workload_t* w)
+{
+    w->seed ^= w->seed << 13;
+    w->seed ^= w->seed >> 17;
+    w->seed ^= w->seed << 5;
+    return w->seed;
+}
+
+
+// Index into bench_data[] of the next word read, always the first of a fill
+static unsigned next_index(
+    workload_t* w)
+{
+    unsigned index;
+
+    switch(w - workloads) {
+        case 0:
+            index = w->next;
+            w->next += FILL_WORDS;
+            break;
+        case 1:
+            index = w->next;
+            w->next += LINE_WORDS;
+            break;
+        case 2:
+            index = xorshift(w);
+            break;
+        default:
+            index = xorshift(w);
+            if(index % 10 != 0)
+                index %= HOT_WORDS;
+            break;
+    }
+
+    return (index % BENCH_DATA_LEN) & ~(FILL_WORDS - 1);
+}
+
+
+static int compare_unsigned(
+    const void* a,
+    const void* b)
+{
+    const unsigned x = *(const unsigned*) a;
+    const unsigned y = *(const unsigned*) b;
+    return (x > y) - (x < y);
+}
+
+
+// The p-th permille of `count` sorted values
+static unsigned permille(
+    const unsigned sorted[],
+    const unsigned count,
+    const unsigned p)
+{
+    if(count == 0)
+        return 0;
+    return sorted[((count - 1) * p) / 1000];
+}
+
+
+// Reads of the timer per timer_overhead() batch
+#define OVERHEAD_BATCH        (64)
+
+// Fewest ticks a batch of OVERHEAD_BATCH back to back reads of the timer takes, so that every
+// span of N timed reads has (N * overhead) / OVERHEAD_BATCH ticks taken off
+static unsigned timer_overhead(void)
+{
+    unsigned best = ~0u;
+
+    for(int k = 0; k < 16; k++) {
+        const unsigned t0 = get_reference_time();
+        for(int j = 0; j < OVERHEAD_BATCH; j++)
+            (void) get_reference_time();
+        const unsigned t1 = get_reference_time();
+        if(t1 - t0 < best)
+            best = t1 - t0;
+    }
+
+    return best;
+}
+
+
+// Ticks taken by `reads` timed reads, which started at `t0` and ended at `t1`
+static unsigned span_ticks(
+    const unsigned t0,
+    const unsigned t1,
+    const unsigned reads,
+    const unsigned overhead)
+{
+    const unsigned taken = (reads * overhead) / OVERHEAD_BATCH;
+    const unsigned ticks = t1 - t0;
+    return (ticks > taken)? ticks - taken : 0;
+}
+
+
+static void run_workload(
+    workload_t* w,
+    const unsigned overhead,
+    const unsigned miss_threshold)
+{
+    w->next = 0;
+    w->seed = 0x12345678;
+
+    for(int k = 0; k < BENCH_ACCESSES; k++) {
+        const unsigned index = next_index(w);
+        const int value = ((volatile const int*) bench_data)[index];
+        assert( value == index );
+    }
+
+    stamp[0] = get_reference_time();
+
+    for(int k = 0; k < BENCH_ACCESSES; k++) {
+        const unsigned index = next_index(w);
+        const int value = ((volatile const int*) bench_data)[index];
+        stamp[k + 1] = get_reference_time();
+
+        assert( value == index );
+    }
+
+    uint64_t hit_total = 0;
+    unsigned misses = 0;
+    unsigned run_start = 0;
+
+    // Each miss on its own, each run of hits as one span
+    for(int k = 0; k <= BENCH_ACCESSES; k++) {
+        const unsigned is_miss = (k < BENCH_ACCESSES) &&
+            (span_ticks(stamp[k], stamp[k + 1], 1, overhead) > miss_threshold);
+
+        if(is_miss || k == BENCH_ACCESSES) {
+            hit_total += span_ticks(stamp[run_start], stamp[k], k - run_start, overhead);
+            run_start = k + 1;
+        }
+
+        if(is_miss)
+            miss_latency[misses++] = span_ticks(stamp[k], stamp[k + 1], 1, overhead);
+    }
+
+    const unsigned hits = BENCH_ACCESSES - misses;
+    const unsigned total = span_ticks(stamp[0], stamp[BENCH_ACCESSES], BENCH_ACCESSES, overhead);
+
+    qsort(miss_latency, misses, sizeof(miss_latency[0]), compare_unsigned);
+
+    debug_printf("BENCH {\"engine\": \"%s\", \"line_bytes\": %u, \"line_count\": %u, "
+                 "\"workload\": \"%s\", \"accesses\": %u, \"cycles_per_fill\": %u, "
+                 "\"hit_permille\": %u, \"hit_cycles\": %u, \"miss_p50\": %u, "
+                 "\"miss_p90\": %u, \"miss_p99\": %u, \"miss_max\": %u}\n",
+                 ENGINE_NAME, L2_CACHE_LINE_SIZE_BYTES, L2_CACHE_LINE_COUNT,
+                 w->name, BENCH_ACCESSES,
+                 TICKS_TO_CYCLES(total) / BENCH_ACCESSES,
+                 (hits * 1000) / BENCH_ACCESSES,
+                 hits? TICKS_TO_CYCLES(hit_total) / hits : 0,
+                 TICKS_TO_CYCLES(permille(miss_latency, misses, 500)),
+                 TICKS_TO_CYCLES(permille(miss_latency, misses, 900)),
+                 TICKS_TO_CYCLES(permille(miss_latency, misses, 990)),
+                 TICKS_TO_CYCLES(permille(miss_latency, misses, 1000)));
+}
+
+
+int main(int argc, char *argv[]) {
+
+  // Without xScope enabled, the debug_printf()'s below can interfere with the flash reads
+  xscope_config_io(XSCOPE_IO_BASIC);
+
+  // Initialize flash driver
+  flash_setup();
+
+  // A quarter of a line's flash read, as the other test apps use to tell misses from hits
+  char line[L2_CACHE_LINE_SIZE_BYTES];
+  unsigned miss_threshold = get_reference_time();
+  flash_read_bytes(line, (void*) XS1_SWMEM_BASE, L2_CACHE_LINE_SIZE_BYTES);
+  miss_threshold = (get_reference_time() - miss_threshold) >> 2;
+
+  // Initialize L2 cache
+  L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
+                  L2_CACHE_LINE_SIZE_BYTES,
+                  l2_cache_buffer,
+                  flash_read_bytes  );
+
+  // Start SwMem thread
+  run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
+
+  debug_printf("\n\nFill latency benchmark, %s cache, %u x %u byte lines\n",
+               ENGINE_NAME, L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES);
+
+#if L2_CACHE_DEBUG_ON
+  debug_printf("(L2 cache debug is on, so timings are pessimistic)\n");
+#endif // L2_CACHE_DEBUG_ON
+
+  const unsigned overhead = timer_overhead();
+
+  for(int k = 0; k < WORKLOAD_COUNT; k++) {
+    run_workload(&workloads[k], overhead, miss_threshold);
+  }
+
+  debug_printf("\nSUCCESS\n\n");
+}
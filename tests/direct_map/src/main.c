@@ -7,6 +7,7 @@
 
 #include <platform.h> // for PLATFORM_REFERENCE_MHZ
 #include <xcore/hwtimer.h>
+#include <xcore/chanend.h>
 #include <xcore/thread.h>
 #include <xscope.h>
 
@@ -16,7 +17,7 @@
 #include "l2_cache.h"
 #include "debug_print.h"
 
-#define L2_CACHE_STACK_WORDS_DIRECT_MAP    (32)
+#define L2_CACHE_STACK_WORDS_DIRECT_MAP    (1000)
 
 #define L2_CACHE_SETUP         l2_cache_setup_direct_map
 #define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
@@ -31,6 +32,25 @@ static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
 DWORD_ALIGNED
 static int swmem_stack[SWMEM_STACK_WORDS];
 
+#if USE_FLASH_SERVER
+// The cache reads flash through a flash server thread rather than directly
+#define FLASH_SERVER_STACK_WORDS   (1000)
+
+DWORD_ALIGNED
+static int flash_server_stack[FLASH_SERVER_STACK_WORDS];
+
+static void flash_server_thread(void* arg)
+{
+  l2_cache_flash_server((chanend_t) arg, flash_read_bytes);
+}
+
+#define CACHE_READ_FUNC    l2_cache_flash_server_read
+#define CACHE_READV_FUNC   NULL
+#else
+#define CACHE_READ_FUNC    flash_read_bytes
+#define CACHE_READV_FUNC   flash_readv_bytes
+#endif // USE_FLASH_SERVER
+
 
 // Used for verifying whether hits/misses are treated correctly.
 // This will be set to one quarter of the time it takes to read
@@ -145,11 +165,43 @@ int main(int argc, char *argv[]) {
   verify_flashed_data();
 
 
+#if USE_FLASH_SERVER
+  const chanend_t flash_server = chanend_alloc();
+  run_async(flash_server_thread, (void*) flash_server,
+            STACK_BASE(flash_server_stack, FLASH_SERVER_STACK_WORDS));
+  l2_cache_flash_server_connect(flash_server);
+#endif // USE_FLASH_SERVER
+
   // Initialize L2 cache
   L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
                   L2_CACHE_LINE_SIZE_BYTES,
                   l2_cache_buffer,
-                  flash_read_bytes  );
+                  CACHE_READ_FUNC  );
+
+  // Preload a few lines either side of where the line index wraps around. They're
+  // contiguous in flash but not in the cache, so this exercises the vectored read.
+  l2_cache_set_readv(CACHE_READV_FUNC, 1);
+
+  const unsigned preload_index = (L2_CACHE_LINE_COUNT - 2) * (L2_CACHE_LINE_SIZE_BYTES / sizeof(int));
+  l2_cache_preload(&data_array[preload_index], 4 * L2_CACHE_LINE_SIZE_BYTES);
+
+  for(int k = 0; k < 4 * L2_CACHE_LINE_SIZE_BYTES / sizeof(int); k++) {
+    assert( l2_cache_direct_map_get_addr_info(&data_array[preload_index + k]).is_hit );
+  }
+
+  // Nothing else is cached yet, so the warm list is just the preloaded lines (5 if they
+  // aren't line-aligned), as one run
+  static uint32_t warm_words[L2_CACHE_WARM_LIST_BYTES(5) / sizeof(uint32_t)];
+  l2_cache_warm_list_t* warm_list = (l2_cache_warm_list_t*) warm_words;
+  const unsigned preload_line =
+      ((unsigned) &data_array[preload_index] - XS1_SWMEM_BASE) / L2_CACHE_LINE_SIZE_BYTES;
+
+  assert( l2_cache_warm_list_export(warm_list, 5) == L2_CACHE_WARM_LIST_BYTES(1) );
+  assert( L2_CACHE_WARM_RUN_FIRST(warm_list->run[0]) == preload_line );
+  assert( L2_CACHE_WARM_RUN_LINES(warm_list->run[0]) >= 4 );
+
+  // Those lines are all cached, so this makes no flash reads when the cache thread starts
+  l2_cache_warm_from_list(warm_list);
 
   // Start SwMem thread
   run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
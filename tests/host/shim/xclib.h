@@ -0,0 +1,18 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for the parts of <xclib.h> the L2 cache uses
+#ifndef XCLIB_H_
+#define XCLIB_H_
+
+static inline unsigned clz(unsigned x)
+{
+    return x? __builtin_clz(x) : 32;
+}
+
+static inline unsigned byterev(unsigned x)
+{
+    return __builtin_bswap32(x);
+}
+
+#endif // XCLIB_H_
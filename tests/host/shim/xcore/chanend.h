@@ -0,0 +1,11 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for <xcore/chanend.h>. Only the type is needed; nothing on the host talks
+// over channels.
+#ifndef XCORE_CHANEND_H_
+#define XCORE_CHANEND_H_
+
+typedef unsigned chanend_t;
+
+#endif // XCORE_CHANEND_H_
@@ -0,0 +1,13 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for <xcore/hwtimer.h>
+#ifndef XCORE_HWTIMER_H_
+#define XCORE_HWTIMER_H_
+
+static inline unsigned get_reference_time(void)
+{
+    return 0;
+}
+
+#endif // XCORE_HWTIMER_H_
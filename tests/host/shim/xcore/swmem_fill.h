@@ -0,0 +1,19 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for <xcore/swmem_fill.h>. There is no SwMem fill resource on the host;
+// fills come from an l2_cache_fill_source_t instead.
+#ifndef XCORE_SWMEM_FILL_H_
+#define XCORE_SWMEM_FILL_H_
+
+#include <stdint.h>
+
+typedef unsigned swmem_fill_t;
+typedef uint32_t fill_slot_t;
+
+static inline swmem_fill_t swmem_fill_get(void)
+{
+    return 1;
+}
+
+#endif // XCORE_SWMEM_FILL_H_
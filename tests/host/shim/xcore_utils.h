@@ -0,0 +1,12 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for xcore_utils.h
+#ifndef XCORE_UTILS_H_
+#define XCORE_UTILS_H_
+
+#include <stdio.h>
+
+#define debug_printf  printf
+
+#endif // XCORE_UTILS_H_
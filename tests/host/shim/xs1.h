@@ -0,0 +1,10 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Host stand-in for the parts of <xs1.h> the L2 cache uses
+#ifndef XS1_H_
+#define XS1_H_
+
+#define XS1_SWMEM_BASE  0x40000000
+
+#endif // XS1_H_
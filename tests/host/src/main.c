@@ -0,0 +1,31 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <stdio.h>
+
+#include "ram_flash.h"
+#include "test_common.h"
+
+int main(void)
+{
+    ram_flash_init();
+
+    test_ref_engines();
+    test_prefetch();
+    test_flash_server();
+    test_regions();
+    test_typed_config();
+    test_query();
+    test_bulk_read();
+    test_partition();
+    test_adaptive();
+    test_const_map();
+    test_stream();
+    test_heatmap();
+    test_segments();
+    test_compressed();
+    test_transform();
+
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "ram_flash.h"
+
+static uint32_t ram_flash[RAM_FLASH_BYTES / sizeof(uint32_t)];
+
+ram_flash_stats_t ram_flash_stats;
+
+
+void ram_flash_init(void)
+{
+    for(int k = 0; k < RAM_FLASH_BYTES / sizeof(uint32_t); k++)
+        ram_flash[k] = (k * 0x9E3779B1u) ^ XS1_SWMEM_BASE;
+
+    memset(&ram_flash_stats, 0, sizeof(ram_flash_stats));
+}
+
+
+void ram_flash_init_sparse(
+    const unsigned keep_one_in)
+{
+    ram_flash_init();
+
+    uint8_t* bytes = (uint8_t*) ram_flash;
+
+    for(int k = 0; k < RAM_FLASH_BYTES; k++) {
+        if(((k * 0x9E3779B1u) >> 16) % keep_one_in != 0)
+            bytes[k] = 0;
+    }
+}
+
+
+const void* ram_flash_at(
+    const unsigned swmem_addr)
+{
+    assert( swmem_addr >= XS1_SWMEM_BASE );
+    assert( swmem_addr - XS1_SWMEM_BASE < RAM_FLASH_BYTES );
+
+    return &((const uint8_t*) ram_flash)[swmem_addr - XS1_SWMEM_BASE];
+}
+
+
+L2_CACHE_SWMEM_READ_FN
+void ram_flash_read(
+    void* dst,
+    const void* src,
+    const size_t bytes)
+{
+    assert( ((unsigned) src) - XS1_SWMEM_BASE + bytes <= RAM_FLASH_BYTES );
+
+    memcpy(dst, ram_flash_at((unsigned) src), bytes);
+
+    ram_flash_stats.read_count++;
+    ram_flash_stats.bytes += bytes;
+    ram_flash_stats.last_dst = dst;
+    ram_flash_stats.last_src = src;
+    ram_flash_stats.last_bytes = bytes;
+}
+
+
+L2_CACHE_SWMEM_READV_FN
+void ram_flash_readv(
+    const l2_cache_read_seg_t* segs,
+    const unsigned seg_count)
+{
+    for(int k = 0; k < seg_count; k++) {
+        // Segments come in ascending flash address order
+        if(k != 0)
+            assert( (unsigned) segs[k].src >= ((unsigned) segs[k-1].src) + segs[k-1].bytes );
+
+        assert( ((unsigned) segs[k].src) - XS1_SWMEM_BASE + segs[k].bytes <= RAM_FLASH_BYTES );
+        memcpy(segs[k].dst, ram_flash_at((unsigned) segs[k].src), segs[k].bytes);
+        ram_flash_stats.bytes += segs[k].bytes;
+    }
+
+    ram_flash_stats.readv_count++;
+}
@@ -0,0 +1,65 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef RAM_FLASH_H_
+#define RAM_FLASH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "l2_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The whole flash-backed part of the SwMem window
+#define RAM_FLASH_BYTES   (1 << L2_CACHE_SWMEM_ADDRESS_BITS)
+
+typedef struct {
+    unsigned read_count;    /// calls to ram_flash_read()
+    unsigned readv_count;   /// calls to ram_flash_readv()
+    unsigned bytes;         /// total bytes read
+
+    /// Arguments of the most recent ram_flash_read()
+    void* last_dst;
+    const void* last_src;
+    size_t last_bytes;
+} ram_flash_stats_t;
+
+extern ram_flash_stats_t ram_flash_stats;
+
+/**
+ * Fill the RAM flash with a pattern in which every word is different, and reset the stats.
+ */
+void ram_flash_init(void);
+
+/**
+ * Fill the RAM flash as ram_flash_init() does, then zero all but about one byte in
+ * `keep_one_in`, as in sparse weights.
+ */
+void ram_flash_init_sparse(
+    const unsigned keep_one_in);
+
+/**
+ * Pointer to the RAM flash contents at a SwMem address.
+ */
+const void* ram_flash_at(
+    const unsigned swmem_addr);
+
+L2_CACHE_SWMEM_READ_FN
+void ram_flash_read(
+    void* dst,
+    const void* src,
+    const size_t bytes);
+
+L2_CACHE_SWMEM_READV_FN
+void ram_flash_readv(
+    const l2_cache_read_seg_t* segs,
+    const unsigned seg_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RAM_FLASH_H_
@@ -0,0 +1,264 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that adaptive fetch grows the fetch size where misses run on from each other and
+// shrinks it where most of each fetch goes unused, with the data still right on every fill.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+
+#define FILL_BYTES      32
+
+#define LINE_BYTES      256
+#define LINE_COUNT      64
+
+#define REGION_BYTES    (1 << L2_CACHE_ADAPTIVE_REGION_BITS)
+
+// Read straight through, every fill of every line
+#define STREAM_ADDR     (0x40000000)
+
+// Grown by reading it straight through once, then read one fill per line at random
+#define SCATTER_ADDR    (0x40100000)
+#define SCATTER_FILLS   (4096)
+
+// Every other line touched, then read in full, then evicted
+#define SPARSE_ADDR     (0x40200000)
+
+
+// Fill source reading either straight through a region or at random within it
+typedef struct {
+    unsigned start;
+    unsigned remaining;
+    unsigned scatter;
+    unsigned next;
+    uint32_t seed;
+} pattern_t;
+
+L2_CACHE_FILL_NEXT_FN
+static unsigned pattern_next(
+    l2_cache_fill_source_t* source)
+{
+    pattern_t* p = source->context;
+
+    if(p->remaining == 0)
+        return 0;
+
+    p->remaining--;
+
+    if(!p->scatter) {
+        const unsigned addr = p->start + p->next;
+        p->next += FILL_BYTES;
+        return addr;
+    }
+
+    // xorshift32
+    p->seed ^= p->seed << 13;
+    p->seed ^= p->seed >> 17;
+    p->seed ^= p->seed << 5;
+
+    return p->start + ((p->seed % REGION_BYTES) & ~(FILL_BYTES - 1));
+}
+
+L2_CACHE_FILL_COMPLETE_FN
+static void pattern_complete(
+    l2_cache_fill_source_t* source,
+    const unsigned fill_addr,
+    const void* data)
+{
+    assert( memcmp(data, ram_flash_at(fill_addr), FILL_BYTES) == 0 );
+}
+
+
+static void run_pattern(
+    const unsigned two_way,
+    const unsigned start,
+    const unsigned fills,
+    const unsigned scatter)
+{
+    pattern_t pattern = {
+        .start = start,
+        .remaining = fills,
+        .scatter = scatter,
+        .seed = 0x12345678,
+    };
+
+    l2_cache_fill_source_t source = {
+        .next = pattern_next,
+        .complete = pattern_complete,
+        .context = &pattern,
+    };
+
+    if(two_way)
+        l2_cache_two_way_ref(&source);
+    else
+        l2_cache_direct_map_ref(&source);
+}
+
+
+// Fill source reading every fill of each of a list of lines
+typedef struct {
+    const unsigned* line;
+    unsigned count;
+    unsigned fills;         /// fills read from each line
+    unsigned next;
+} lines_t;
+
+L2_CACHE_FILL_NEXT_FN
+static unsigned lines_next(
+    l2_cache_fill_source_t* source)
+{
+    lines_t* l = source->context;
+
+    if(l->next == l->count * l->fills)
+        return 0;
+
+    const unsigned addr = l->line[l->next / l->fills] + (l->next % l->fills) * FILL_BYTES;
+    l->next++;
+    return addr;
+}
+
+
+static void run_lines(
+    const unsigned two_way,
+    const unsigned* line,
+    const unsigned count,
+    const unsigned fills)
+{
+    lines_t lines = { .line = line, .count = count, .fills = fills };
+
+    l2_cache_fill_source_t source = {
+        .next = lines_next,
+        .complete = pattern_complete,
+        .context = &lines,
+    };
+
+    if(two_way)
+        l2_cache_two_way_ref(&source);
+    else
+        l2_cache_direct_map_ref(&source);
+}
+
+
+// Lines are counted once they're evicted, however many misses there have been since they
+// were fetched
+static void check_retire(
+    const unsigned two_way)
+{
+    static unsigned line[LINE_COUNT / 2];
+    const unsigned count = LINE_COUNT / 2;
+
+    for(int k = 0; k < count; k++)
+        line[k] = SPARSE_ADDR + 2 * k * LINE_BYTES;
+
+    l2_cache_adaptive_stats_reset();
+
+    // One fill of each misses (evicting lines of earlier patterns), then all of each hits
+    run_lines(two_way, line, count, 1);
+    assert( l2_cache_adaptive_stats.miss_count == count );
+
+    const unsigned tracked = l2_cache_adaptive_stats.tracked_bytes;
+    const unsigned used = l2_cache_adaptive_stats.used_bytes;
+
+    run_lines(two_way, line, count, LINE_BYTES / FILL_BYTES);
+    assert( l2_cache_adaptive_stats.miss_count == count );
+    assert( l2_cache_adaptive_stats.tracked_bytes == tracked );
+
+    // Lines in the same sets evict them (from both ways of a two-way cache)
+    for(int pass = 1; pass <= 1 + two_way; pass++) {
+        for(int k = 0; k < count; k++)
+            line[k] = SPARSE_ADDR + pass * LINE_COUNT * LINE_BYTES + 2 * k * LINE_BYTES;
+
+        run_lines(two_way, line, count, 1);
+    }
+
+    // ...and only then are they counted, as used in full
+    assert( l2_cache_adaptive_stats.tracked_bytes - tracked >= count * LINE_BYTES );
+    assert( l2_cache_adaptive_stats.used_bytes - used >= count * LINE_BYTES );
+}
+
+
+static void run_engine(
+    const unsigned two_way)
+{
+    if(two_way)
+        l2_cache_setup_two_way(LINE_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+    else
+        l2_cache_setup_direct_map(LINE_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+
+    l2_cache_set_readv(ram_flash_readv, 1);
+    l2_cache_adaptive_stats_reset();
+
+    // Nothing learnt yet: the fetch size given to l2_cache_set_readv()
+    assert( l2_cache_adaptive_fetch_lines((void*) STREAM_ADDR) == 1 );
+
+    // Read straight through, every miss carries on from the last one...
+    run_pattern(two_way, STREAM_ADDR, REGION_BYTES / FILL_BYTES, 0);
+
+    assert( l2_cache_adaptive_fetch_lines((void*) STREAM_ADDR) == L2_CACHE_ADAPTIVE_MAX_LINES );
+
+    // ...so once the fetch size has grown, there are far fewer misses than lines
+    const unsigned stream_lines = REGION_BYTES / LINE_BYTES;
+    assert( l2_cache_adaptive_stats.miss_count < stream_lines / 2 );
+    assert( l2_cache_adaptive_stats.fetched_bytes == REGION_BYTES );
+    assert( l2_cache_adaptive_efficiency() == 100 );
+
+    printf("Adaptive: stream of %u lines in %u misses\n", stream_lines,
+           l2_cache_adaptive_stats.miss_count);
+
+    // Grow the scattered region too, then read it one fill here and there
+    run_pattern(two_way, SCATTER_ADDR, REGION_BYTES / FILL_BYTES, 0);
+    assert( l2_cache_adaptive_fetch_lines((void*) SCATTER_ADDR) == L2_CACHE_ADAPTIVE_MAX_LINES );
+
+    l2_cache_adaptive_stats_reset();
+    run_pattern(two_way, SCATTER_ADDR, SCATTER_FILLS, 1);
+
+    // Most of each run went unused, so only the line which missed is fetched now
+    assert( l2_cache_adaptive_fetch_lines((void*) SCATTER_ADDR) == 1 );
+    assert( l2_cache_adaptive_efficiency() < 50 );
+
+    // ...and the flash reads are one line each from then on
+    const unsigned misses = l2_cache_adaptive_stats.miss_count;
+    const unsigned bytes = l2_cache_adaptive_stats.fetched_bytes;
+    run_pattern(two_way, SCATTER_ADDR, SCATTER_FILLS, 1);
+
+    assert( l2_cache_adaptive_stats.fetched_bytes - bytes
+                == (l2_cache_adaptive_stats.miss_count - misses) * LINE_BYTES );
+
+    printf("Adaptive: scattered reads use %u%% of what they fetch\n",
+           l2_cache_adaptive_efficiency());
+
+    // Other regions are left alone
+    assert( l2_cache_adaptive_fetch_lines((void*) STREAM_ADDR) == L2_CACHE_ADAPTIVE_MAX_LINES );
+
+    check_retire(two_way);
+
+    // Setting up again forgets them all
+    if(two_way)
+        l2_cache_setup_two_way(LINE_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+    else
+        l2_cache_setup_direct_map(LINE_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+
+    assert( l2_cache_adaptive_fetch_lines((void*) STREAM_ADDR) == 1 );
+}
+
+
+void test_adaptive(void)
+{
+    run_engine(0);
+    run_engine(1);
+}
+
+#else
+
+void test_adaptive(void)
+{
+}
+
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
@@ -0,0 +1,156 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that l2_cache_read() copies resident lines out of the cache, reads the rest from
+// flash in as few chunks as it can without caching them, and redoes a line's copy from flash
+// when the cache thread replaces lines while it's being copied.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_BULK_READ_ON
+
+#define BASE_ADDR   (XS1_SWMEM_BASE + 0x10000)
+
+static uint8_t out[64 * 1024];
+
+
+// Copies [addr, addr + len) with l2_cache_read(), checks it, and returns the flash reads it took
+static unsigned check_read(
+    const unsigned addr,
+    const size_t len)
+{
+    const unsigned reads = ram_flash_stats.read_count;
+
+    memset(out, 0xA5, len + 1);
+    l2_cache_read(out, (const void*) addr, len);
+
+    assert( memcmp(out, ram_flash_at(addr), len) == 0 );
+    assert( out[len] == 0xA5 );
+
+    return ram_flash_stats.read_count - reads;
+}
+
+
+/*
+  Stands in for the engine's lookup. When armed for a line, it finds the line as usual, then
+  has the cache thread replace it (as it could between the lookup and the copy on the device)
+  before handing back where it was.
+*/
+static l2_cache_lookup_fn engine_lookup;
+static unsigned replace_line;
+static unsigned replace_two_way;
+static unsigned replace_stride;
+
+L2_CACHE_LOOKUP_FN
+static const void* replacing_lookup(
+    const unsigned line_addr)
+{
+    const void* slot = engine_lookup(line_addr);
+
+    if(line_addr != replace_line)
+        return slot;
+
+    replace_line = 0;
+    assert( slot != NULL );
+
+    // Two lines of the same set, so that the second evicts it from either engine
+    test_ref_fill(replace_two_way, line_addr + replace_stride);
+    test_ref_fill(replace_two_way, line_addr + 2 * replace_stride);
+
+    assert( !test_is_cached(replace_two_way, line_addr) );
+
+    return slot;
+}
+
+
+static void check_geometry(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    const unsigned line_bytes = geometry->line_bytes;
+    const unsigned lines = geometry->line_count;   // consecutive lines either engine holds
+    const unsigned range = lines * line_bytes;
+
+    // Resident lines only: copied from the cache, at any alignment
+    test_setup(two_way, geometry);
+    l2_cache_preload((void*) BASE_ADDR, range);
+
+    assert( check_read(BASE_ADDR, range) == 0 );
+    assert( check_read(BASE_ADDR + 3, range - 8) == 0 );
+    assert( check_read(BASE_ADDR + line_bytes - 1, 2) == 0 );
+
+    // Non-resident lines only: one read a chunk, and nothing is cached by them
+    test_setup(two_way, geometry);
+
+    const size_t uncached = sizeof(out) - 100;
+    const unsigned chunks = (uncached + L2_CACHE_BULK_READ_CHUNK_BYTES - 1)
+                                / L2_CACHE_BULK_READ_CHUNK_BYTES;
+
+    assert( check_read(BASE_ADDR + 5, uncached) == chunks );
+    assert( ram_flash_stats.last_bytes == uncached - (chunks - 1) * L2_CACHE_BULK_READ_CHUNK_BYTES );
+
+    for(unsigned addr = BASE_ADDR; addr < BASE_ADDR + uncached; addr += line_bytes)
+        assert( !test_is_cached(two_way, addr) );
+
+    // A mix: every other line resident, so one read for each line that isn't
+    test_setup(two_way, geometry);
+
+    for(int k = 0; k < lines; k += 2)
+        l2_cache_preload((void*) (BASE_ADDR + k * line_bytes), 1);
+
+    assert( check_read(BASE_ADDR + 1, range - 2) == lines / 2 );
+    assert( check_read(BASE_ADDR, line_bytes) == 0 );
+    assert( check_read(BASE_ADDR + line_bytes, line_bytes) == 1 );
+
+    // A fill in progress (l2_cache_fill_seq odd) sends every line to flash
+    l2_cache_fill_seq++;
+    assert( check_read(BASE_ADDR, line_bytes) == 1 );
+    l2_cache_fill_seq++;
+
+    // Lines replaced while one is being copied: that line is copied again, from flash
+    test_setup(two_way, geometry);
+    l2_cache_preload((void*) BASE_ADDR, range);
+
+    const unsigned victim = BASE_ADDR + (lines / 2) * line_bytes;
+
+    engine_lookup = l2_cache_engine.lookup;
+    l2_cache_engine.lookup = replacing_lookup;
+    replace_line = victim;
+    replace_two_way = two_way;
+    replace_stride = range;
+
+    const unsigned seq = l2_cache_fill_seq;
+
+    // (two reads are the replacing fills')
+    assert( check_read(BASE_ADDR + 7, range - 7) == 2 + 1 );
+    assert( (unsigned) ram_flash_stats.last_src == victim );
+    assert( ram_flash_stats.last_bytes == line_bytes );
+
+    assert( replace_line == 0 );
+    assert( l2_cache_fill_seq != seq );
+
+    l2_cache_engine.lookup = engine_lookup;
+}
+
+
+void test_bulk_read(void)
+{
+    test_each_geometry("Bulk read", check_geometry);
+}
+
+#else
+
+void test_bulk_read(void)
+{
+}
+
+#endif // L2_CACHE_BULK_READ_ON
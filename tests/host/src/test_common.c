@@ -0,0 +1,153 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+uint32_t test_cache_buffer[TEST_CACHE_BUFFER_WORDS];
+
+// Each leaves at most 15 tag bits (see L2_CACHE_SWMEM_ADDRESS_BITS)
+const test_geometry_t test_geometries[] = {
+    { 256,  64 },
+    { 64,   128 },
+    { 32,   512 },
+    { 1024, 16 },
+    { 256,  2 },   // exactly 15 tag bits
+};
+
+const unsigned test_geometry_count = sizeof(test_geometries) / sizeof(test_geometries[0]);
+
+
+void test_setup(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    if(two_way) {
+        assert( L2_CACHE_BUFFER_WORDS_TWO_WAY(geometry->line_count, geometry->line_bytes)
+                    <= TEST_CACHE_BUFFER_WORDS );
+        l2_cache_setup_two_way(geometry->line_count, geometry->line_bytes,
+                               test_cache_buffer, ram_flash_read);
+    } else {
+        assert( L2_CACHE_BUFFER_WORDS_DIRECT_MAP(geometry->line_count, geometry->line_bytes)
+                    <= TEST_CACHE_BUFFER_WORDS );
+        l2_cache_setup_direct_map(geometry->line_count, geometry->line_bytes,
+                                  test_cache_buffer, ram_flash_read);
+    }
+}
+
+
+unsigned test_is_cached(
+    const unsigned two_way,
+    const unsigned addr)
+{
+    if(two_way)
+        return l2_cache_two_way_get_addr_info((void*) addr).is_hit;
+    return l2_cache_direct_map_get_addr_info((void*) addr).is_hit;
+}
+
+
+const void* test_ref_fill(
+    const unsigned two_way,
+    const unsigned addr)
+{
+    if(two_way)
+        return l2_cache_two_way_ref_fill(addr);
+    return l2_cache_direct_map_ref_fill(addr);
+}
+
+
+void test_each_geometry(
+    const char* name,
+    test_geometry_fn run)
+{
+    static const char* const engine[] = { "direct-map", "two-way" };
+
+    for(int two_way = 0; two_way < 2; two_way++) {
+        for(int g = 0; g < test_geometry_count; g++) {
+            printf("%s: %s, %u x %u byte lines\n", name, engine[two_way],
+                   test_geometries[g].line_count, test_geometries[g].line_bytes);
+            run(two_way, &test_geometries[g]);
+        }
+    }
+}
+
+#define FILL_BYTES  32
+
+enum {
+    MODE_SEQUENTIAL,
+    MODE_STRIDED,
+    MODE_HOT,
+    MODE_RANDOM,
+    MODE_COUNT
+};
+
+
+static uint32_t rand_next(
+    test_trace_t* trace)
+{
+    // xorshift32
+    uint32_t x = trace->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    trace->seed = x;
+    return x;
+}
+
+
+static unsigned random_addr(
+    test_trace_t* trace)
+{
+    return XS1_SWMEM_BASE + (rand_next(trace) % RAM_FLASH_BYTES) / FILL_BYTES * FILL_BYTES;
+}
+
+
+void test_trace_init(
+    test_trace_t* trace,
+    const uint32_t seed)
+{
+    trace->seed = seed? seed : 1;
+    trace->mode = MODE_RANDOM;
+    trace->left = 0;
+    trace->stride = 0;
+    trace->addr = random_addr(trace);
+
+    for(int k = 0; k < 8; k++)
+        trace->hot[k] = random_addr(trace);
+}
+
+
+unsigned test_trace_next(
+    test_trace_t* trace)
+{
+    if(trace->left == 0) {
+        trace->mode = rand_next(trace) % MODE_COUNT;
+        trace->left = 1 + rand_next(trace) % 200;
+        trace->stride = FILL_BYTES * (1 + rand_next(trace) % 40);
+        if(rand_next(trace) & 1)
+            trace->stride = -trace->stride;
+    }
+
+    trace->left--;
+
+    unsigned addr;
+
+    switch(trace->mode) {
+        case MODE_SEQUENTIAL: addr = trace->addr + FILL_BYTES; break;
+        case MODE_STRIDED:    addr = trace->addr + trace->stride; break;
+        case MODE_HOT:        addr = trace->hot[rand_next(trace) % 8]; break;
+        default:              addr = random_addr(trace); break;
+    }
+
+    // Wrap around rather than leave the flash
+    addr = XS1_SWMEM_BASE + ((addr - XS1_SWMEM_BASE) % RAM_FLASH_BYTES);
+
+    trace->addr = addr;
+    return addr;
+}
@@ -0,0 +1,111 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef TEST_COMMON_H_
+#define TEST_COMMON_H_
+
+#include <stdint.h>
+
+#include "l2_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Big enough for either engine with any of the geometries tested
+#define TEST_CACHE_BUFFER_WORDS   (1 << 15)
+
+extern uint32_t test_cache_buffer[TEST_CACHE_BUFFER_WORDS];
+
+/// A cache geometry to test with
+typedef struct {
+    unsigned line_bytes;
+    unsigned line_count;
+} test_geometry_t;
+
+extern const test_geometry_t test_geometries[];
+extern const unsigned test_geometry_count;
+
+/**
+ * Fill address trace: a deterministic mix of sequential runs, strided runs, a small hot set
+ * and random addresses anywhere in the RAM flash.
+ */
+typedef struct {
+    uint32_t seed;
+    unsigned addr;      /// last address produced
+    unsigned mode;      /// which kind of access is being produced
+    unsigned left;      /// accesses left in this mode
+    int stride;
+    unsigned hot[8];
+} test_trace_t;
+
+void test_trace_init(
+    test_trace_t* trace,
+    const uint32_t seed);
+
+/// The next (32-byte aligned) fill address
+unsigned test_trace_next(
+    test_trace_t* trace);
+
+/**
+ * Set up the two-way (or direct-mapped) cache with `geometry` in test_cache_buffer, reading
+ * the RAM flash.
+ */
+void test_setup(
+    const unsigned two_way,
+    const test_geometry_t* geometry);
+
+/// Whether the line holding `addr` is in the cache test_setup() set up
+unsigned test_is_cached(
+    const unsigned two_way,
+    const unsigned addr);
+
+/// Serve the fill at `addr` with the reference engine for the cache test_setup() set up
+const void* test_ref_fill(
+    const unsigned two_way,
+    const unsigned addr);
+
+typedef void (*test_geometry_fn)(
+    const unsigned two_way,
+    const test_geometry_t* geometry);
+
+/// Run `run` for each engine with each of test_geometries, printing `name` and the geometry
+void test_each_geometry(
+    const char* name,
+    test_geometry_fn run);
+
+void test_ref_engines(void);
+
+void test_prefetch(void);
+
+void test_flash_server(void);
+
+void test_regions(void);
+
+void test_typed_config(void);
+
+void test_query(void);
+
+void test_bulk_read(void);
+
+void test_partition(void);
+
+void test_adaptive(void);
+
+void test_const_map(void);
+
+void test_stream(void);
+
+void test_heatmap(void);
+
+void test_segments(void);
+
+void test_compressed(void);
+
+void test_transform(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_COMMON_H_
@@ -0,0 +1,156 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks the compressed cache serves the right data from sparse and dense flash as its pool
+// wraps round, and that on sparse data it holds a working set the two-way cache can't in the
+// same buffer.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (50000)
+
+// Swept over and over
+#define SWEEP_BYTES     (48 * 1024)
+#define SWEEPS          (10)
+
+// Buffer of a two-way cache with 64 sets of 256-byte lines
+#define BUDGET_WORDS    L2_CACHE_BUFFER_WORDS_TWO_WAY(64, 256)
+
+
+static void check_trace(
+    const unsigned line_bytes,
+    const unsigned line_count,
+    const unsigned pool_bytes)
+{
+    assert( L2_CACHE_BUFFER_WORDS_COMPRESSED(line_count, line_bytes, pool_bytes)
+                <= TEST_CACHE_BUFFER_WORDS );
+
+    assert( l2_cache_setup_compressed(line_count, line_bytes, pool_bytes,
+                                      test_cache_buffer, ram_flash_read) == 0 );
+
+    test_trace_t trace;
+    test_trace_init(&trace, 97531);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+        const unsigned reads = ram_flash_stats.read_count;
+
+        assert( memcmp(l2_cache_compressed_fill(addr), ram_flash_at(addr), FILL_BYTES) == 0 );
+
+        // Straight after a miss, the line is held
+        if(ram_flash_stats.read_count != reads) {
+            assert( ram_flash_stats.last_bytes == line_bytes );
+            assert( memcmp(l2_cache_compressed_fill(addr), ram_flash_at(addr), FILL_BYTES) == 0 );
+            assert( ram_flash_stats.read_count == reads + 1 );
+        }
+
+        assert( l2_cache_compressed_lines_held() <= line_count );
+    }
+}
+
+
+static unsigned sweep_flash_bytes(
+    const l2_cache_ref_fill_fn fill)
+{
+    const unsigned bytes = ram_flash_stats.bytes;
+
+    for(int s = 0; s < SWEEPS; s++) {
+        for(unsigned addr = XS1_SWMEM_BASE; addr < XS1_SWMEM_BASE + SWEEP_BYTES; addr += FILL_BYTES)
+            assert( memcmp(fill(addr), ram_flash_at(addr), FILL_BYTES) == 0 );
+    }
+
+    return ram_flash_stats.bytes - bytes;
+}
+
+
+// Pools the 16-bit index can't address, or which can't hold a line, are turned away
+static void check_pool_limits(void)
+{
+    assert( l2_cache_setup_compressed(256, 256, 256 * 1024, test_cache_buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_compressed(256, 256, 1024 * 1024, test_cache_buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_compressed(256, 256, 256, test_cache_buffer, ram_flash_read) == -1 );
+
+    // The largest pool there is room for in the 16-bit offsets
+    static uint32_t largest[L2_CACHE_BUFFER_WORDS_COMPRESSED(256, 256, 256 * 1024 - 8)];
+    assert( l2_cache_setup_compressed(256, 256, 256 * 1024 - 8, largest, ram_flash_read) == 0 );
+}
+
+
+// Helpers needing a single engine's lines leave the compressed cache alone
+static void check_no_single_engine(void)
+{
+    assert( l2_cache_setup_compressed(256, 256, 8 * 1024, test_cache_buffer, ram_flash_read) == 0 );
+
+    const unsigned reads = ram_flash_stats.read_count;
+
+    l2_cache_preload((void*) XS1_SWMEM_BASE, 4096);
+    assert( ram_flash_stats.read_count == reads );
+    assert( l2_cache_compressed_lines_held() == 0 );
+
+    static uint32_t list[64];
+    assert( l2_cache_warm_list_export((l2_cache_warm_list_t*) list, 32) == 0 );
+    l2_cache_warm_from_list((l2_cache_warm_list_t*) list);
+    l2_cache_engine_start();
+    assert( ram_flash_stats.read_count == reads );
+
+#if L2_CACHE_QUERY_ON
+    uint32_t bitmap[2] = { 0xA5A5A5A5, 0xA5A5A5A5 };
+    assert( l2_cache_query_range((void*) XS1_SWMEM_BASE, 4096, bitmap) == 0 );
+    assert( bitmap[0] == 0xA5A5A5A5 );
+#endif // L2_CACHE_QUERY_ON
+}
+
+
+void test_compressed(void)
+{
+    check_pool_limits();
+    check_no_single_engine();
+
+    // Small pools, so that they wrap round many times
+    ram_flash_init_sparse(8);
+    check_trace(256, 256, 8 * 1024);
+    check_trace(32, 1024, 2 * 1024);
+    check_trace(1024, 64, 16 * 1024);
+
+    // Every mix of zero and non-zero bytes in a word, and packed bytes straddling words
+    ram_flash_init_sparse(2);
+    check_trace(256, 256, 8 * 1024);
+
+    // Nothing to compress
+    ram_flash_init();
+    check_trace(256, 64, 4 * 1024);
+    check_trace(64, 256, 1024);
+
+    // Compressible, and too big for the two-way cache
+    ram_flash_init_sparse(8);
+
+    l2_cache_setup_two_way(64, 256, test_cache_buffer, ram_flash_read);
+    const unsigned two_way_bytes = sweep_flash_bytes(l2_cache_two_way_ref_fill);
+
+    // The same buffer, less a line as read from flash and 1024 line indexes
+    const unsigned pool_bytes = (BUDGET_WORDS - 256 / sizeof(int) - 1024 * sizeof(uint16_t) / sizeof(int)) * sizeof(int);
+    assert( L2_CACHE_BUFFER_WORDS_COMPRESSED(1024, 256, pool_bytes) <= BUDGET_WORDS );
+
+    assert( l2_cache_setup_compressed(1024, 256, pool_bytes, test_cache_buffer, ram_flash_read) == 0 );
+    const unsigned compressed_bytes = sweep_flash_bytes(l2_cache_compressed_fill);
+
+    printf("test_compressed: %u KiB swept %u times, flash KiB read: two-way %u, compressed %u (%u lines held)\n",
+           SWEEP_BYTES / 1024, SWEEPS, two_way_bytes / 1024, compressed_bytes / 1024,
+           l2_cache_compressed_lines_held());
+
+    // Only the first sweep misses
+    assert( compressed_bytes == SWEEP_BYTES );
+    assert( two_way_bytes > 4 * compressed_bytes );
+
+    printf("test_compressed: passed\n");
+}
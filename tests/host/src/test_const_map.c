@@ -0,0 +1,123 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that fills in constant runs are served with the run's value, without a flash read
+// and without touching the cache, while every other fill is served as before.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_CONST_MAP_ON
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (20000)
+
+// Sorted, and each ends where the next starts in places, with a different value
+static const l2_cache_const_run_t runs[] = {
+    { 0x00000400, 0x00000020, 0x00000000 },   // one fill, less than a line
+    { 0x00001000, 0x00002000, 0x00000000 },
+    { 0x00003000, 0x00000100, 0xFFFFFFFF },
+    { 0x00010000, 0x00010000, 0xFFFFFFFF },
+    { 0x00020000, 0x00000060, 0x12345678 },
+};
+
+#define RUN_COUNT   (sizeof(runs) / sizeof(runs[0]))
+
+
+static const l2_cache_const_run_t* find_run(
+    const unsigned addr)
+{
+    for(int k = 0; k < RUN_COUNT; k++) {
+        if(addr - XS1_SWMEM_BASE - runs[k].start < runs[k].bytes)
+            return &runs[k];
+    }
+    return NULL;
+}
+
+
+static void check_fill(
+    const unsigned two_way,
+    const unsigned addr)
+{
+    const l2_cache_const_run_t* run = find_run(addr);
+    const unsigned reads = ram_flash_stats.read_count;
+    const unsigned const_fills = l2_cache_const_fill_count;
+    const unsigned was_cached = test_is_cached(two_way, addr);
+
+    const uint32_t* data = test_ref_fill(two_way, addr);
+
+    if(run == NULL || was_cached) {
+        assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+        assert( test_is_cached(two_way, addr) );
+        return;
+    }
+
+    // Served from the run's value, with no flash read and nothing cached
+    for(int k = 0; k < FILL_BYTES / sizeof(uint32_t); k++)
+        assert( data[k] == run->value );
+
+    assert( (((uintptr_t) data) & 0x7) == 0 ); // the engines fill from it with vldd
+    assert( ram_flash_stats.read_count == reads );
+    assert( l2_cache_const_fill_count == const_fills + 1 );
+    assert( !test_is_cached(two_way, addr) );
+}
+
+
+static void run_trace(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    test_setup(two_way, geometry);
+
+    l2_cache_set_const_map(runs, RUN_COUNT);
+
+    // Every fill of every run, and either side of each
+    for(int k = 0; k < RUN_COUNT; k++) {
+        const unsigned start = XS1_SWMEM_BASE + runs[k].start;
+
+        for(unsigned addr = start - FILL_BYTES; addr <= start + runs[k].bytes; addr += FILL_BYTES)
+            check_fill(two_way, addr);
+    }
+
+    // Then a trace over the bottom of SwMem, where the runs are
+    test_trace_t trace;
+    test_trace_init(&trace, 4321);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+        check_fill(two_way, XS1_SWMEM_BASE + (addr & 0x3FFFF));
+    }
+
+    // Whole lines in a run are skipped by batched fetches too
+    const unsigned line_bytes = geometry->line_bytes;
+    const unsigned first = XS1_SWMEM_BASE + 0x00010000;
+
+    l2_cache_preload((void*) (first - line_bytes), 3 * line_bytes);
+
+    assert( test_is_cached(two_way, first - line_bytes) );
+    assert( !test_is_cached(two_way, first) );
+    assert( !test_is_cached(two_way, first + line_bytes) );
+
+    l2_cache_set_const_map(NULL, 0);
+}
+
+
+void test_const_map(void)
+{
+    test_each_geometry("Constant map", run_trace);
+}
+
+#else
+
+void test_const_map(void)
+{
+}
+
+#endif // L2_CACHE_CONST_MAP_ON
@@ -0,0 +1,141 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks how the flash server orders and batches the requests it has queued. The channel
+// side of the server is XS3-only.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_internal.h"
+#include "test_common.h"
+
+#if L2_CACHE_FLASH_SERVER_ON
+
+#define BASE    (0x40000000)
+#define MISS    L2_CACHE_FLASH_PRIORITY_MISS
+#define APP     L2_CACHE_FLASH_PRIORITY_APP
+
+static l2_cache_flash_request_t queue[L2_CACHE_FLASH_SERVER_QUEUE];
+static unsigned count;
+
+
+static void add(
+    const unsigned offset,
+    const unsigned bytes,
+    const unsigned priority)
+{
+    assert( count < L2_CACHE_FLASH_SERVER_QUEUE );
+    queue[count++] = (l2_cache_flash_request_t) {
+        .client = count, .src = BASE + offset, .bytes = bytes, .priority = priority };
+}
+
+
+static unsigned in_batch(
+    const l2_cache_flash_batch_t* batch,
+    const unsigned index)
+{
+    for(int k = 0; k < batch->count; k++) {
+        if(batch->request[k] == index)
+            return 1;
+    }
+    return 0;
+}
+
+
+// Takes the batch's requests out of the queue, as the server does
+static void serve(
+    const l2_cache_flash_batch_t* batch)
+{
+    unsigned left = 0;
+    for(int k = 0; k < count; k++) {
+        if(!in_batch(batch, k))
+            queue[left++] = queue[k];
+    }
+    count = left;
+}
+
+
+static void check_batch(
+    const l2_cache_flash_batch_t* batch)
+{
+    // Every request in the batch lies within what's read, which fits the buffer
+    assert( batch->bytes <= L2_CACHE_FLASH_SERVER_BUFFER_BYTES );
+    for(int k = 0; k < batch->count; k++) {
+        const l2_cache_flash_request_t* r = &queue[batch->request[k]];
+        assert( r->src >= batch->src );
+        assert( r->src + r->bytes <= batch->src + batch->bytes );
+    }
+}
+
+
+void test_flash_server(void)
+{
+    l2_cache_flash_batch_t batch;
+
+    // A miss goes ahead of an older application read
+    count = 0;
+    add(0x10000, 256, APP);
+    add(0x20000, 256, MISS);
+    l2_cache_flash_server_plan(queue, count, &batch);
+    check_batch(&batch);
+    assert( batch.count == 1 && batch.request[0] == 1 );
+    assert( queue[0].skips == 1 );
+
+    // Adjacent and overlapping requests are read together; the rest wait
+    count = 0;
+    add(0x1000, 256, MISS);
+    add(0x1100, 256, APP);
+    add(0x8000, 256, MISS);
+    add(0x1080, 64, APP);
+    l2_cache_flash_server_plan(queue, count, &batch);
+    check_batch(&batch);
+    assert( batch.request[0] == 0 && batch.count == 3 );
+    assert( batch.src == BASE + 0x1000 && batch.bytes == 512 );
+    assert( queue[2].skips == 1 );
+
+    // Requests can join the batch through one added after them
+    count = 0;
+    add(0x2000, 256, MISS);
+    add(0x2200, 256, MISS);
+    add(0x2100, 256, MISS);
+    l2_cache_flash_server_plan(queue, count, &batch);
+    check_batch(&batch);
+    assert( batch.count == 3 );
+    assert( batch.src == BASE + 0x2000 && batch.bytes == 768 );
+
+    // ... but only while they fit in the buffer
+    count = 0;
+    add(0x3000, L2_CACHE_FLASH_SERVER_BUFFER_BYTES, MISS);
+    add(0x3000 + L2_CACHE_FLASH_SERVER_BUFFER_BYTES, 256, MISS);
+    l2_cache_flash_server_plan(queue, count, &batch);
+    check_batch(&batch);
+    assert( batch.count == 1 && batch.bytes == L2_CACHE_FLASH_SERVER_BUFFER_BYTES );
+
+    // An application read passed over often enough is served before newer misses
+    count = 0;
+    add(0x40000, 256, APP);
+    unsigned rounds = 0;
+    while(1) {
+        add(0x50000 + 0x1000 * rounds, 256, MISS);
+        l2_cache_flash_server_plan(queue, count, &batch);
+        check_batch(&batch);
+        rounds++;
+        if(queue[batch.request[0]].priority == APP)
+            break;
+        serve(&batch);
+        assert( rounds <= L2_CACHE_FLASH_SERVER_APP_SKIPS );
+    }
+    assert( rounds == L2_CACHE_FLASH_SERVER_APP_SKIPS + 1 );
+
+    printf("Flash server: OK\n");
+}
+
+#else
+
+void test_flash_server(void)
+{
+}
+
+#endif // L2_CACHE_FLASH_SERVER_ON
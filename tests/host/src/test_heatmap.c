@@ -0,0 +1,152 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that the heatmap counts every miss and hit against the right page, and every miss
+// against the right set, with refetches where a set's line was evicted soon after it was read.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_HEATMAP_ON
+
+#define TRACE_LENGTH    (20000)
+
+#define PAGE_BYTES      (1 << L2_CACHE_HEATMAP_PAGE_BITS)
+
+
+typedef struct {
+    unsigned misses;
+    unsigned hits;
+} count_t;
+
+static count_t page_count[L2_CACHE_HEATMAP_PAGES + 1];
+static count_t set_count[L2_CACHE_HEATMAP_SETS];    // hits here are refetches
+
+
+static unsigned saturated(
+    const unsigned count)
+{
+    return (count > UINT16_MAX)? UINT16_MAX : count;
+}
+
+
+static void run_trace(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    const unsigned line_bytes = geometry->line_bytes;
+    const unsigned sets = geometry->line_count;    // lines per way for the two-way cache
+
+    test_setup(two_way, geometry);
+
+    l2_cache_heatmap_reset();
+    memset(page_count, 0, sizeof(page_count));
+    memset(set_count, 0, sizeof(set_count));
+
+    // Line addresses of each set's recent misses (newest first), worked out independently
+    static unsigned recent[1 << 15][L2_CACHE_HEATMAP_RECENT];
+    memset(recent, 0, sizeof(recent));
+
+    test_trace_t trace;
+    test_trace_init(&trace, 2468);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+        const unsigned line = addr & ~(line_bytes - 1);
+        const unsigned set = (addr / line_bytes) % sets;
+
+        unsigned page = (addr - XS1_SWMEM_BASE) / PAGE_BYTES;
+        if(page >= L2_CACHE_HEATMAP_PAGES)
+            page = L2_CACHE_HEATMAP_PAGES;
+
+        if(test_is_cached(two_way, addr)) {
+            page_count[page].hits++;
+        } else {
+            page_count[page].misses++;
+            set_count[set % L2_CACHE_HEATMAP_SETS].misses++;
+
+            unsigned found = L2_CACHE_HEATMAP_RECENT - 1;
+
+            for(int r = 0; r < L2_CACHE_HEATMAP_RECENT; r++) {
+                if(recent[set][r] == line) {
+                    set_count[set % L2_CACHE_HEATMAP_SETS].hits++;
+                    found = r;
+                    break;
+                }
+            }
+
+            memmove(&recent[set][1], &recent[set][0], found * sizeof(unsigned));
+            recent[set][0] = line;
+        }
+
+        test_ref_fill(two_way, addr);
+    }
+
+    for(int k = 0; k < L2_CACHE_HEATMAP_PAGES; k++) {
+        assert( l2_cache_heatmap.page[k].misses == saturated(page_count[k].misses) );
+        assert( l2_cache_heatmap.page[k].hits
+                    == (L2_CACHE_HEATMAP_HITS_ON? saturated(page_count[k].hits) : 0) );
+    }
+
+    assert( l2_cache_heatmap.beyond.misses == saturated(page_count[L2_CACHE_HEATMAP_PAGES].misses) );
+
+    // Only checked where a heatmap entry is for one set (the engines' sets aren't all
+    // counted by the test's sets' history otherwise)
+    if(sets <= L2_CACHE_HEATMAP_SETS) {
+        for(int k = 0; k < sets; k++) {
+            assert( l2_cache_heatmap.set[k].misses == saturated(set_count[k].misses) );
+            assert( l2_cache_heatmap.set[k].refetches == saturated(set_count[k].hits) );
+        }
+    }
+}
+
+
+// Lines taking turns in one set, one more than it holds
+static void run_thrash(
+    const unsigned two_way)
+{
+    const test_geometry_t geometry = { .line_bytes = 256, .line_count = 64 };
+    const unsigned way_bytes = geometry.line_bytes * geometry.line_count;
+
+    test_setup(two_way, &geometry);
+
+    l2_cache_heatmap_reset();
+
+    const unsigned lines = two_way? 3 : 2;
+
+    for(int k = 0; k < 10 * lines; k++) {
+        const unsigned addr = XS1_SWMEM_BASE + 0x20 + (k % lines) * way_bytes;
+
+        test_ref_fill(two_way, addr);
+    }
+
+    assert( l2_cache_heatmap.set[0].misses == 10 * lines );
+    assert( l2_cache_heatmap.set[0].refetches == 10 * lines - lines );
+    assert( l2_cache_heatmap.set[1].misses == 0 );
+}
+
+
+void test_heatmap(void)
+{
+    test_each_geometry("Heatmap", run_trace);
+
+    for(int two_way = 0; two_way < 2; two_way++)
+        run_thrash(two_way);
+
+    l2_cache_heatmap_dump();
+}
+
+#else
+
+void test_heatmap(void)
+{
+}
+
+#endif // L2_CACHE_HEATMAP_ON
@@ -0,0 +1,175 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that way partitions keep code in the two-way cache while data streams through it,
+// and that they can be changed while the cache is in use.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_PARTITION_ON
+
+#define FILL_BYTES      32
+
+#define LINE_BYTES      256
+#define SET_COUNT       64
+
+// A loop which fills a whole way, so every set holds one of its lines
+#define CODE_ADDR       (0x40000000)
+#define CODE_BYTES      (SET_COUNT * LINE_BYTES)
+
+// Streamed through, three fills for each code fill
+#define DATA_ADDR       (0x40100000)
+#define DATA_BYTES      (1024 * 1024)
+#define DATA_PER_CODE   (3)
+
+#define PASSES          (8)
+
+
+static unsigned in_code(
+    const unsigned addr)
+{
+    return addr - CODE_ADDR < CODE_BYTES;
+}
+
+
+// Every line cached is in the way its partition was given
+static void check_ways(void)
+{
+    for(int slot = 0; slot < l2_cache_engine.slot_count; slot++) {
+        const unsigned line_addr = l2_cache_engine.line_at(slot);
+        const unsigned way = slot / SET_COUNT;
+
+        if(line_addr != 0)
+            assert( in_code(line_addr) == (way == 0) );
+    }
+}
+
+
+static void fill(
+    const unsigned addr,
+    const unsigned checked)
+{
+    const l2_cache_two_way_addr_dbg_t before = l2_cache_two_way_get_addr_info((void*) addr);
+
+    assert( memcmp(l2_cache_two_way_ref_fill(addr), ram_flash_at(addr), FILL_BYTES) == 0 );
+
+    if(!before.is_hit) {
+        const l2_cache_two_way_addr_dbg_t after = l2_cache_two_way_get_addr_info((void*) addr);
+        assert( after.hit.slot == before.miss.evict_slot );
+
+        if(checked)
+            assert( after.hit.slot == (in_code(addr)? 0 : 1) );
+    }
+}
+
+
+// Code misses over the last PASSES - 1 passes of the code loop
+static unsigned run_loop(
+    const unsigned checked)
+{
+    unsigned data_offset = 0;
+    unsigned code_misses = 0;
+
+    for(int pass = 0; pass < PASSES; pass++) {
+        for(unsigned offset = 0; offset < CODE_BYTES; offset += FILL_BYTES) {
+            const unsigned addr = CODE_ADDR + offset;
+
+            if(pass > 0 && !l2_cache_two_way_get_addr_info((void*) addr).is_hit)
+                code_misses++;
+
+            fill(addr, checked);
+
+            for(int k = 0; k < DATA_PER_CODE; k++) {
+                fill(DATA_ADDR + data_offset, checked);
+                data_offset = (data_offset + FILL_BYTES) % DATA_BYTES;
+            }
+        }
+
+        if(checked)
+            check_ways();
+    }
+
+    return code_misses;
+}
+
+
+void test_partition(void)
+{
+    const l2_cache_partition_t code_partition[] = {
+        { .start = (void*) CODE_ADDR, .len = CODE_BYTES, .way = 0 },
+    };
+
+    // Shared ways: the data stream keeps evicting the code
+    l2_cache_setup_two_way(SET_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+    const unsigned shared_misses = run_loop(0);
+
+    // Code in way 0, everything else in way 1: once loaded, the code always hits
+    l2_cache_setup_two_way(SET_COUNT, LINE_BYTES, test_cache_buffer, ram_flash_read);
+    l2_cache_two_way_set_partitions(code_partition, 1, 1);
+    const unsigned partitioned_misses = run_loop(1);
+
+    printf("Partition: %u code misses with shared ways, %u with a way for the code\n",
+           shared_misses, partitioned_misses);
+
+    assert( shared_misses > 0 );
+    assert( partitioned_misses == 0 );
+
+    // Lines claimed outside the fill path (e.g. by a preload) go in their partition's way too
+    l2_cache_preload((void*) (DATA_ADDR + DATA_BYTES), 16 * LINE_BYTES);
+    l2_cache_preload((void*) CODE_ADDR, CODE_BYTES);
+    check_ways();
+
+    // Changed while in use: with the ways shared again, the code starts missing again
+    l2_cache_two_way_set_partitions(NULL, 0, L2_CACHE_WAY_ANY);
+    assert( run_loop(0) > 0 );
+
+    // ...and giving the code its way back protects it from then on
+    l2_cache_two_way_set_partitions(code_partition, 1, 1);
+    run_loop(0);
+    assert( run_loop(1) == 0 );
+
+    // A partition with either way, for everything but the code
+    const l2_cache_partition_t any_partition[] = {
+        { .start = (void*) DATA_ADDR, .len = DATA_BYTES, .way = L2_CACHE_WAY_ANY },
+    };
+    l2_cache_two_way_set_partitions(any_partition, 1, 0);
+    assert( l2_cache_partition_way(DATA_ADDR, 1) == 1 );
+    assert( l2_cache_partition_way(DATA_ADDR, 0) == 0 );
+    assert( l2_cache_partition_way(CODE_ADDR, 1) == 0 );
+
+    // Changed over and over (each change reuses the map the last but one made active), and
+    // after going back to no partitions
+    for(int k = 0; k < 9; k++) {
+        if(k % 3 == 2) {
+            l2_cache_two_way_set_partitions(NULL, 0, L2_CACHE_WAY_ANY);
+            assert( l2_cache_partition_way(CODE_ADDR, 1) == 1 );
+            continue;
+        }
+
+        const unsigned code_way = k & 1;
+        const l2_cache_partition_t partition[] = {
+            { .start = (void*) CODE_ADDR, .len = CODE_BYTES, .way = code_way },
+        };
+
+        l2_cache_two_way_set_partitions(partition, 1, 1 - code_way);
+        assert( l2_cache_partition_way(CODE_ADDR, 1 - code_way) == code_way );
+        assert( l2_cache_partition_way(DATA_ADDR, code_way) == 1 - code_way );
+    }
+
+    l2_cache_two_way_set_partitions(NULL, 0, L2_CACHE_WAY_ANY);
+}
+
+#else
+
+void test_partition(void)
+{
+}
+
+#endif // L2_CACHE_PARTITION_ON
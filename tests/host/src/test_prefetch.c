@@ -0,0 +1,255 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that the prefetcher picks out interleaved constant-stride streams, fetches ahead of
+// each only once its stride has repeated often enough, and counts what it issued and what
+// was used exactly, by replaying the streams through the reference engines.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_prefetch.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_PREFETCH_ON
+
+#define REGION_BYTES    (1 << L2_CACHE_PREFETCH_REGION_BITS)
+
+#define MAX_FILLS       (512)
+
+typedef struct {
+    unsigned start;
+    int stride[2];      /// taken in turn, so a stream with two different ones never repeats
+    unsigned count;
+} stream_spec_t;
+
+// Each in a region of its own, and short enough to stay in it
+static const stream_spec_t specs[] = {
+    { XS1_SWMEM_BASE + 16 * REGION_BYTES,               {  64,   64 }, 100 },
+    { XS1_SWMEM_BASE + 18 * REGION_BYTES,               { 256,  256 }, 50 },
+    { XS1_SWMEM_BASE + 20 * REGION_BYTES + 0x3FE0,      { -96,  -96 }, 100 },
+    { XS1_SWMEM_BASE + 22 * REGION_BYTES,               {  64,  160 }, 60 },
+};
+
+#define STREAM_COUNT    (sizeof(specs) / sizeof(specs[0]))
+
+
+typedef struct {
+    unsigned two_way;
+    unsigned line_bytes;
+    unsigned distance;
+
+    // The streams, round robin
+    unsigned fill[MAX_FILLS];
+    unsigned stream[MAX_FILLS];
+    unsigned fill_count;
+    unsigned next;
+
+    unsigned reads;         /// ram_flash_stats.read_count when the last fill was served
+    unsigned expect_issue;  /// line the prefetcher should fetch after the last fill, or 0
+
+    // What the counters should say, worked out independently
+    unsigned issued;
+    unsigned useful;
+    unsigned misses;
+    unsigned tracked[L2_CACHE_PREFETCH_TRACKED_LINES];
+    unsigned tracked_next;
+
+    unsigned repeats[STREAM_COUNT];     /// times in a row each stream's stride has repeated
+} replay_t;
+
+
+static void make_fills(
+    replay_t* replay)
+{
+    unsigned addr[STREAM_COUNT];
+    unsigned left = 0;
+
+    for(int s = 0; s < STREAM_COUNT; s++) {
+        addr[s] = specs[s].start;
+        left += specs[s].count;
+    }
+
+    replay->fill_count = 0;
+
+    for(int k = 0; left != 0; k++) {
+        for(int s = 0; s < STREAM_COUNT; s++) {
+            if(k >= specs[s].count)
+                continue;
+
+            replay->fill[replay->fill_count] = addr[s];
+            replay->stream[replay->fill_count] = s;
+            replay->fill_count++;
+            left--;
+
+            addr[s] += specs[s].stride[k & 1];
+        }
+    }
+
+    assert( replay->fill_count <= MAX_FILLS );
+}
+
+
+// The line the prefetcher should look at after the k'th fill, or 0 if none
+static unsigned prefetch_target(
+    replay_t* replay,
+    const unsigned k)
+{
+    const unsigned s = replay->stream[k];
+    const int line_bytes = replay->line_bytes;
+
+    // Each stream's first fill sets no stride, and its second sets one without repeating it
+    unsigned nth = 0;
+    for(int j = 0; j < k; j++)
+        nth += (replay->stream[j] == s);
+
+    if(nth >= 2 && specs[s].stride[0] == specs[s].stride[1])
+        replay->repeats[s]++;
+
+    if(replay->repeats[s] < L2_CACHE_PREFETCH_CONFIDENCE || replay->distance == 0)
+        return 0;
+
+    const int stride = specs[s].stride[0];
+    int ahead = stride * (int) replay->distance;
+
+    if(ahead > -line_bytes && ahead < line_bytes)
+        ahead = (stride > 0)? line_bytes : -line_bytes;
+
+    return (replay->fill[k] + ahead) & ~(line_bytes - 1);
+}
+
+
+L2_CACHE_FILL_NEXT_FN
+static unsigned replay_next(
+    l2_cache_fill_source_t* source)
+{
+    replay_t* replay = source->context;
+
+    // The prefetcher has just seen the last fill: first a fill from a line it fetched...
+    if(replay->next != 0) {
+        const unsigned line = replay->fill[replay->next - 1] & ~(replay->line_bytes - 1);
+
+        for(int k = 0; k < L2_CACHE_PREFETCH_TRACKED_LINES; k++) {
+            if(replay->tracked[k] == line) {
+                replay->tracked[k] = 0;
+                replay->useful++;
+                break;
+            }
+        }
+    }
+
+    // ...then exactly the read predicted
+    if(replay->expect_issue != 0) {
+        assert( ram_flash_stats.read_count == replay->reads + 1 );
+        assert( (unsigned) ram_flash_stats.last_src == replay->expect_issue );
+        assert( ram_flash_stats.last_bytes == replay->line_bytes );
+
+        replay->issued++;
+        replay->tracked[replay->tracked_next] = replay->expect_issue;
+        replay->tracked_next = (replay->tracked_next + 1) % L2_CACHE_PREFETCH_TRACKED_LINES;
+    } else {
+        assert( ram_flash_stats.read_count == replay->reads );
+    }
+
+    if(replay->next == replay->fill_count)
+        return 0;
+
+    replay->reads = ram_flash_stats.read_count;
+    return replay->fill[replay->next++];
+}
+
+
+L2_CACHE_FILL_COMPLETE_FN
+static void replay_complete(
+    l2_cache_fill_source_t* source,
+    const unsigned fill_addr,
+    const void* data)
+{
+    replay_t* replay = source->context;
+
+    assert( memcmp(data, ram_flash_at(fill_addr), 32) == 0 );
+
+    replay->misses += (ram_flash_stats.read_count != replay->reads);
+    replay->reads = ram_flash_stats.read_count;
+
+    // Only fetched if it isn't already cached
+    const unsigned target = prefetch_target(replay, replay->next - 1);
+
+    replay->expect_issue = (target != 0 && !test_is_cached(replay->two_way, target))? target : 0;
+}
+
+
+static void run_streams(
+    const unsigned two_way,
+    const unsigned distance)
+{
+    const test_geometry_t geometry = { .line_bytes = 256, .line_count = 64 };
+
+    static replay_t replay;
+    memset(&replay, 0, sizeof(replay));
+
+    replay.two_way = two_way;
+    replay.line_bytes = geometry.line_bytes;
+    replay.distance = distance;
+    make_fills(&replay);
+
+    test_setup(two_way, &geometry);
+    l2_cache_prefetch_set_distance(distance);
+    l2_cache_prefetch_stats_reset();
+
+    replay.reads = ram_flash_stats.read_count;
+
+    l2_cache_fill_source_t source = {
+        .next = replay_next,
+        .complete = replay_complete,
+        .context = &replay,
+    };
+
+    if(two_way)
+        l2_cache_two_way_ref(&source);
+    else
+        l2_cache_direct_map_ref(&source);
+
+    assert( l2_cache_prefetch_stats.issued_count == replay.issued );
+    assert( l2_cache_prefetch_stats.useful_count == replay.useful );
+    assert( l2_cache_prefetch_stats.miss_count == replay.misses );
+
+    printf("Prefetch: %s, distance %u: %u issued, %u useful, %u misses, coverage %u%%\n",
+           two_way? "two-way" : "direct-map", distance, replay.issued, replay.useful,
+           replay.misses, (unsigned) l2_cache_prefetch_coverage());
+
+    if(distance == 0) {
+        assert( replay.issued == 0 );
+        return;
+    }
+
+    // Most of the strided streams' lines after the first few are fetched ahead of them
+    assert( l2_cache_prefetch_accuracy() >= 75 );
+    assert( l2_cache_prefetch_coverage() >= 50 );
+}
+
+
+void test_prefetch(void)
+{
+    ram_flash_init();
+
+    for(int two_way = 0; two_way < 2; two_way++) {
+        for(unsigned distance = 0; distance <= 4; distance++)
+            run_streams(two_way, distance);
+    }
+
+    l2_cache_prefetch_set_distance(L2_CACHE_PREFETCH_DISTANCE);
+}
+
+#else
+
+void test_prefetch(void)
+{
+}
+
+#endif // L2_CACHE_PREFETCH_ON
@@ -0,0 +1,113 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks l2_cache_query_range() against l2_cache_*_get_addr_info(), line by line, as a
+// trace runs through each engine.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_QUERY_ON
+
+#define TRACE_LENGTH    (20000)
+#define QUERY_EVERY     (97)
+
+// Longest range queried, in bytes
+#define QUERY_MAX_BYTES (16 * 1024)
+
+
+static void check_query(
+    const unsigned two_way,
+    const test_geometry_t* geometry,
+    const unsigned addr,
+    const size_t len)
+{
+    uint32_t bitmap[L2_CACHE_QUERY_BITMAP_WORDS(QUERY_MAX_BYTES, 32) + 1];
+
+    // Words past the end of the range must be left alone
+    memset(bitmap, 0xA5, sizeof(bitmap));
+
+    const unsigned resident = l2_cache_query_range((void*) addr, len, bitmap);
+
+    const unsigned line_bytes = geometry->line_bytes;
+    const unsigned first = addr & ~(line_bytes - 1);
+    const unsigned line_count = (((addr + len - 1) & ~(line_bytes - 1)) - first) / line_bytes + 1;
+
+    assert( line_count <= 32 * L2_CACHE_QUERY_BITMAP_WORDS(len, line_bytes) );
+
+    unsigned expected = 0;
+    for(int k = 0; k < line_count; k++) {
+        const unsigned line_addr = first + k * line_bytes;
+        const unsigned cached = (line_addr >= XS1_SWMEM_BASE) && test_is_cached(two_way, line_addr);
+
+        assert( ((bitmap[k / 32] >> (k % 32)) & 1) == cached );
+        expected += cached;
+    }
+
+    assert( resident == expected );
+    assert( bitmap[(line_count + 31) / 32] == 0xA5A5A5A5 );
+}
+
+
+static void run_trace(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    test_setup(two_way, geometry);
+
+    uint32_t bitmap[L2_CACHE_QUERY_BITMAP_WORDS(QUERY_MAX_BYTES, 32)];
+
+    // Nothing is cached straight after setup
+    assert( l2_cache_query_range((void*) XS1_SWMEM_BASE, QUERY_MAX_BYTES, bitmap) == 0 );
+    assert( l2_cache_query_range((void*) XS1_SWMEM_BASE, 0, bitmap) == 0 );
+
+    test_trace_t trace;
+    test_trace_init(&trace, geometry->line_count * 3 + geometry->line_bytes);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+
+        const unsigned seq = l2_cache_fill_seq;
+        const unsigned hit = test_is_cached(two_way, addr);
+
+        test_ref_fill(two_way, addr);
+
+        // Replacements are published (and finished) by the time the fill is served
+        assert( (l2_cache_fill_seq & 1) == 0 );
+        assert( hit == (l2_cache_fill_seq == seq) );
+
+        if(k % QUERY_EVERY == 0) {
+            // Ranges both side of the fill, at odd alignments, some longer than 32 lines
+            const size_t len = 1 + (k * 7919) % QUERY_MAX_BYTES;
+            const unsigned start = addr - (k % 3) * len / 2 + (k % 13);
+
+            check_query(two_way, geometry, start, len);
+            check_query(two_way, geometry, addr, 1);
+        }
+    }
+
+    // A range starting below SwMem only finds what's in SwMem
+    check_query(two_way, geometry, XS1_SWMEM_BASE - 100, 4096);
+}
+
+
+void test_query(void)
+{
+    test_each_geometry("Query", run_trace);
+}
+
+#else
+
+void test_query(void)
+{
+}
+
+#endif // L2_CACHE_QUERY_ON
@@ -0,0 +1,224 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks, fill by fill, that the reference engines do what l2_cache_*_get_addr_info() (the
+// model of the assembly engines used by the hardware tests) says the assembly would do.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (100000)
+
+
+static void check_direct_map_fill(
+    const unsigned addr,
+    const unsigned miss_fetch_lines)
+{
+    const l2_cache_direct_map_addr_dbg_t before = l2_cache_direct_map_get_addr_info((void*) addr);
+    const ram_flash_stats_t stats = ram_flash_stats;
+
+    const void* data = l2_cache_direct_map_ref_fill(addr);
+
+    assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+
+    const unsigned reads = (ram_flash_stats.read_count - stats.read_count)
+                            + (ram_flash_stats.readv_count - stats.readv_count);
+
+    if(before.is_hit) {
+        assert( reads == 0 );
+    } else if(miss_fetch_lines == 1 && !L2_CACHE_ADAPTIVE_FETCH_ON) {
+        assert( reads == 1 );
+        assert( ram_flash_stats.last_dst == before.miss.cache_dst );
+        assert( ram_flash_stats.last_src == before.miss.flash_src );
+        assert( ram_flash_stats.last_bytes == before.miss.bytes );
+    } else {
+        assert( reads >= 1 );
+    }
+
+    const l2_cache_direct_map_addr_dbg_t after = l2_cache_direct_map_get_addr_info((void*) addr);
+
+    assert( after.is_hit );
+    assert( after.cache_address == data );
+}
+
+
+static void check_two_way_fill(
+    const unsigned addr,
+    const unsigned miss_fetch_lines)
+{
+    const l2_cache_two_way_addr_dbg_t before = l2_cache_two_way_get_addr_info((void*) addr);
+    const ram_flash_stats_t stats = ram_flash_stats;
+
+    const void* data = l2_cache_two_way_ref_fill(addr);
+
+    assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+
+    const unsigned reads = (ram_flash_stats.read_count - stats.read_count)
+                            + (ram_flash_stats.readv_count - stats.readv_count);
+
+    if(before.is_hit) {
+        assert( reads == 0 );
+    } else if(miss_fetch_lines == 1 && !L2_CACHE_ADAPTIVE_FETCH_ON) {
+        assert( reads == 1 );
+        assert( ram_flash_stats.last_dst == before.miss.cache_dst );
+        assert( ram_flash_stats.last_src == before.miss.flash_src );
+        assert( ram_flash_stats.last_bytes == before.miss.bytes );
+    } else {
+        assert( reads >= 1 );
+    }
+
+    // A hit refreshes the way it hit in; a miss fills the way which didn't have the last hit
+    const unsigned way = before.is_hit? before.hit.slot : before.miss.evict_slot;
+
+    const l2_cache_two_way_addr_dbg_t after = l2_cache_two_way_get_addr_info((void*) addr);
+
+    assert( after.is_hit );
+    assert( after.hit.slot == way );
+    assert( after.entry.last_hit == way );
+    assert( after.entry.tag[1 - way] == before.entry.tag[1 - way] );
+    assert( after.cache_address == data );
+}
+
+
+static void run_trace(
+    const unsigned two_way,
+    const test_geometry_t* geometry,
+    const unsigned miss_fetch_lines)
+{
+    test_setup(two_way, geometry);
+
+    if(miss_fetch_lines != 1)
+        l2_cache_set_readv(ram_flash_readv, miss_fetch_lines);
+
+    test_trace_t trace;
+    test_trace_init(&trace, geometry->line_bytes * geometry->line_count + miss_fetch_lines);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+
+        if(two_way)
+            check_two_way_fill(addr, miss_fetch_lines);
+        else
+            check_direct_map_fill(addr, miss_fetch_lines);
+    }
+}
+
+
+// Fill source which replays a trace, checking the data handed back for each fill
+typedef struct {
+    test_trace_t trace;
+    unsigned remaining;
+    unsigned completed;
+} replay_t;
+
+L2_CACHE_FILL_NEXT_FN
+static unsigned replay_next(
+    l2_cache_fill_source_t* source)
+{
+    replay_t* replay = source->context;
+
+    if(replay->remaining == 0)
+        return 0;
+
+    replay->remaining--;
+    return test_trace_next(&replay->trace);
+}
+
+L2_CACHE_FILL_COMPLETE_FN
+static void replay_complete(
+    l2_cache_fill_source_t* source,
+    const unsigned fill_addr,
+    const void* data)
+{
+    replay_t* replay = source->context;
+
+    assert( memcmp(data, ram_flash_at(fill_addr), FILL_BYTES) == 0 );
+    replay->completed++;
+}
+
+
+static void run_source(
+    const unsigned two_way)
+{
+    test_setup(two_way, &test_geometries[0]);
+
+    replay_t replay = { .remaining = TRACE_LENGTH };
+    test_trace_init(&replay.trace, 1234);
+
+    l2_cache_fill_source_t source = {
+        .next = replay_next,
+        .complete = replay_complete,
+        .context = &replay,
+    };
+
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats_reset();
+#endif // L2_CACHE_DEBUG_ON
+
+    if(two_way)
+        l2_cache_two_way_ref(&source);
+    else
+        l2_cache_direct_map_ref(&source);
+
+    assert( replay.completed == TRACE_LENGTH );
+
+#if L2_CACHE_DEBUG_ON
+    assert( l2_cache_debug_stats.fill_request_count == TRACE_LENGTH );
+    assert( l2_cache_debug_stats.hit_count + l2_cache_debug_stats.miss_count == TRACE_LENGTH );
+#endif // L2_CACHE_DEBUG_ON
+}
+
+
+// Geometries whose tags don't fit in 15 bits are turned away, in every build, without the
+// buffer being touched
+static void check_tag_limits(void)
+{
+    static uint32_t buffer[64];
+    memset(buffer, 0xA5, sizeof(buffer));
+
+    // 17 and 16 tag bits
+    assert( l2_cache_setup_direct_map(4, 32, buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_direct_map(8, 32, buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_two_way(4, 32, buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_two_way(8, 32, buffer, ram_flash_read) == -1 );
+
+    // As big as the flash-backed part of SwMem, so no tag at all
+    const unsigned all_lines = 1u << (L2_CACHE_SWMEM_ADDRESS_BITS - 8);
+    assert( l2_cache_setup_direct_map(all_lines, 256, buffer, ram_flash_read) == -1 );
+    assert( l2_cache_setup_two_way(all_lines, 256, buffer, ram_flash_read) == -1 );
+
+    for(int k = 0; k < 64; k++)
+        assert( buffer[k] == 0xA5A5A5A5 );
+
+    // Exactly 15 tag bits
+    assert( l2_cache_setup_direct_map(16, 32, test_cache_buffer, ram_flash_read) == 0 );
+    assert( l2_cache_setup_two_way(16, 32, test_cache_buffer, ram_flash_read) == 0 );
+}
+
+
+void test_ref_engines(void)
+{
+    static const char* const name[] = { "direct-map", "two-way" };
+
+    check_tag_limits();
+
+    for(int two_way = 0; two_way < 2; two_way++) {
+        for(int g = 0; g < test_geometry_count; g++) {
+            const test_geometry_t* geometry = &test_geometries[g];
+
+            printf("%s %u x %u bytes\n", name[two_way], geometry->line_count, geometry->line_bytes);
+
+            run_trace(two_way, geometry, 1);
+            run_trace(two_way, geometry, 4);
+        }
+
+        printf("%s fill source\n", name[two_way]);
+        run_source(two_way);
+    }
+}
@@ -0,0 +1,134 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks the region engine serves the right data, and that on a mixed workload it beats
+// every single geometry given at least as much buffer.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (200000)
+
+// Cache data for each single geometry; the regions get 18 KiB between them
+#define BUDGET_BYTES    (32 * 1024)
+
+// Read straight through, over and over
+#define BLOB_ADDR       (0x40100000)
+#define BLOB_BYTES      (256 * 1024)
+
+// Records scattered over a table, read at random, as when chasing pointers
+#define TABLE_ADDR      (0x40010000)
+#define TABLE_BYTES     (64 * 1024)
+#define RECORDS         (128)
+
+static unsigned record[RECORDS];
+
+
+static unsigned mixed_next(
+    uint32_t* seed,
+    unsigned* blob_offset)
+{
+    *seed = *seed * 1664525 + 1013904223;
+
+    if(*seed & 0x80000000) {
+        const unsigned addr = BLOB_ADDR + *blob_offset;
+        *blob_offset = (*blob_offset + FILL_BYTES) % BLOB_BYTES;
+        return addr;
+    }
+
+    return record[(*seed >> 8) % RECORDS];
+}
+
+
+// Misses per thousand fills
+static unsigned run_mixed(
+    l2_cache_ref_fill_fn fill)
+{
+    uint32_t seed = 1;
+    unsigned blob_offset = 0;
+
+    ram_flash_init();
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = mixed_next(&seed, &blob_offset);
+        assert( memcmp(fill(addr), ram_flash_at(addr), FILL_BYTES) == 0 );
+    }
+
+    return (unsigned) (((uint64_t) ram_flash_stats.read_count * 1000) / TRACE_LENGTH);
+}
+
+
+void test_regions(void)
+{
+    uint32_t seed = 12345;
+    for(int k = 0; k < RECORDS; k++) {
+        seed = seed * 1664525 + 1013904223;
+        record[k] = TABLE_ADDR + ((seed >> 8) % (TABLE_BYTES / FILL_BYTES)) * FILL_BYTES;
+    }
+
+    // A couple of big lines for the blob, and plenty of small ones for the records
+    const l2_cache_region_t regions[] = {
+        {
+            .start = (void*) BLOB_ADDR, .len = BLOB_BYTES, .type = L2_CACHE_REGION_DIRECT_MAP,
+            .line_count = 2, .line_size_bytes = 1024, .cache_buffer = &test_cache_buffer[0],
+        },
+        {
+            .start = (void*) TABLE_ADDR, .len = TABLE_BYTES, .type = L2_CACHE_REGION_TWO_WAY,
+            .line_count = 128, .line_size_bytes = 64,
+            .cache_buffer = &test_cache_buffer[TEST_CACHE_BUFFER_WORDS / 2],
+        },
+    };
+
+    l2_cache_setup_regions(regions, 2, ram_flash_read);
+    const unsigned region_misses = run_mixed(l2_cache_regions_fill);
+
+    printf("regions: %u misses per 1000 fills\n", region_misses);
+
+    for(unsigned line_bytes = 64; line_bytes <= 1024; line_bytes <<= 1) {
+        const unsigned line_count = BUDGET_BYTES / line_bytes;
+
+        l2_cache_setup_direct_map(line_count, line_bytes, test_cache_buffer, ram_flash_read);
+        const unsigned direct_map_misses = run_mixed(l2_cache_direct_map_ref_fill);
+
+        l2_cache_setup_two_way(line_count / 2, line_bytes, test_cache_buffer, ram_flash_read);
+        const unsigned two_way_misses = run_mixed(l2_cache_two_way_ref_fill);
+
+        printf("%4u byte lines: direct-map %u, two-way %u misses per 1000 fills\n",
+               line_bytes, direct_map_misses, two_way_misses);
+
+        assert( region_misses < direct_map_misses );
+        assert( region_misses < two_way_misses );
+    }
+
+    // Fills in no region still get the right data (checked in run_mixed()), straight from flash
+    l2_cache_setup_regions(regions, 1, ram_flash_read);
+    ram_flash_init();
+    l2_cache_regions_fill(TABLE_ADDR);
+    l2_cache_regions_fill(TABLE_ADDR);
+    assert( ram_flash_stats.read_count == 2 );
+
+    // A catch-all region caches everything else
+    const l2_cache_region_t catch_all[] = {
+        regions[0],
+        { .len = 0, .type = L2_CACHE_REGION_TWO_WAY, .line_count = 128, .line_size_bytes = 64,
+          .cache_buffer = &test_cache_buffer[TEST_CACHE_BUFFER_WORDS / 2] },
+    };
+    assert( l2_cache_setup_regions(catch_all, 2, ram_flash_read) == 0 );
+    const unsigned catch_all_misses = run_mixed(l2_cache_regions_fill);
+    assert( catch_all_misses == region_misses );
+
+    // A region whose tags don't fit turns the whole setup away
+    const l2_cache_region_t too_small[] = {
+        regions[0],
+        { .len = 0, .type = L2_CACHE_REGION_TWO_WAY, .line_count = 4, .line_size_bytes = 32,
+          .cache_buffer = &test_cache_buffer[TEST_CACHE_BUFFER_WORDS / 2] },
+    };
+    assert( l2_cache_setup_regions(too_small, 2, ram_flash_read) == -1 );
+}
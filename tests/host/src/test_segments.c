@@ -0,0 +1,154 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that a cache with its lines spread over segments hits and misses exactly as the same
+// cache in one buffer does, serves the right data, and keeps its lines inside its segments.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_SEGMENTS_ON
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (20000)
+
+#define POOL_WORDS      (1 << 14)
+
+// Where the segments are cut from, and the tags of the segmented cache
+static uint32_t segment_pool[POOL_WORDS];
+static uint32_t tag_buffer[TEST_CACHE_BUFFER_WORDS / 4];
+
+
+static int setup_segments(
+    const unsigned two_way,
+    const test_geometry_t* geometry,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count)
+{
+    if(two_way)
+        return l2_cache_setup_two_way_segments(geometry->line_count, geometry->line_bytes,
+                                               tag_buffer, segments, segment_count, ram_flash_read);
+    return l2_cache_setup_direct_map_segments(geometry->line_count, geometry->line_bytes,
+                                              tag_buffer, segments, segment_count, ram_flash_read);
+}
+
+
+static unsigned in_segments(
+    const void* data,
+    const l2_cache_segment_t segments[],
+    const unsigned segment_count)
+{
+    for(int k = 0; k < segment_count; k++) {
+        const uint8_t* start = segments[k].buffer;
+        if((const uint8_t*) data >= start && (const uint8_t*) data + FILL_BYTES <= start + segments[k].bytes)
+            return 1;
+    }
+    return 0;
+}
+
+
+// Whether each fill of the trace hits, with the cache in one buffer
+static uint8_t expect_hit[TRACE_LENGTH];
+
+static void check_geometry(
+    const unsigned two_way,
+    const test_geometry_t* geometry)
+{
+    const unsigned data_bytes = (two_way? 2 : 1) * geometry->line_count * geometry->line_bytes;
+
+    if(data_bytes + data_bytes / 2 > sizeof(segment_pool))
+        return;
+
+    // The trace's hits and misses with the cache in one buffer
+    test_setup(two_way, geometry);
+
+    test_trace_t trace;
+    test_trace_init(&trace, 1357);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+        expect_hit[k] = test_is_cached(two_way, addr);
+        test_ref_fill(two_way, addr);
+    }
+
+    // Quarters of the data in four misaligned segments, out of order and with gaps between
+    // them, and in one segment which is a byte too small for all of it
+    uint8_t* pool = (uint8_t*) segment_pool;
+    const unsigned quarter = data_bytes / 4;
+
+    const l2_cache_segment_t split[] = {
+        { pool + 3 * (quarter + 40) + 1, quarter + 3 },
+        { pool + 2, quarter + 2 },
+        { pool + 2 * (quarter + 40) + 3, quarter + 1 },
+        { pool + (quarter + 40) + 4, quarter },
+        { pool + 4 * (quarter + 40), 100 },             // too small for anything
+    };
+    const unsigned split_count = sizeof(split) / sizeof(split[0]);
+
+    const l2_cache_segment_t short_one[] = {
+        { pool, data_bytes - 1 },
+    };
+
+    const l2_cache_segment_t whole[] = {
+        { pool, data_bytes },
+    };
+
+    const struct {
+        const l2_cache_segment_t* segments;
+        unsigned count;
+    } layouts[] = {
+        { whole, 1 },
+        { split, split_count },
+        { short_one, 1 },
+    };
+
+    for(int s = 0; s < sizeof(layouts) / sizeof(layouts[0]); s++) {
+        if(setup_segments(two_way, geometry, layouts[s].segments, layouts[s].count) != 0) {
+            // Only possible where a quarter of the cache is less than a set
+            assert( layouts[s].segments != whole );
+            assert( layouts[s].segments != split || geometry->line_count < 4 );
+            continue;
+        }
+
+        test_trace_init(&trace, 1357);
+
+        for(int k = 0; k < TRACE_LENGTH; k++) {
+            const unsigned addr = test_trace_next(&trace);
+
+            assert( test_is_cached(two_way, addr) == expect_hit[k] );
+
+            const void* data = test_ref_fill(two_way, addr);
+
+            assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+            assert( in_segments(data, layouts[s].segments, layouts[s].count) );
+        }
+    }
+
+    // Nothing fits in a segment smaller than a set
+    const l2_cache_segment_t tiny[] = {
+        { pool, (two_way? 2 : 1) * geometry->line_bytes - 1 },
+        { pool + 4096, 3 },
+    };
+    assert( setup_segments(two_way, geometry, tiny, 2) == -1 );
+}
+
+
+void test_segments(void)
+{
+    ram_flash_init();
+
+    test_each_geometry("Segments", check_geometry);
+
+    printf("test_segments: passed\n");
+}
+
+#else
+
+void test_segments(void) {}
+
+#endif // L2_CACHE_SEGMENTS_ON
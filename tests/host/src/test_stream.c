@@ -0,0 +1,82 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that a stream hands back its tiles in order, each read once from flash into the two
+// buffers in turn, without touching the cache. The fetch thread and its channel are XS3-only;
+// on the host each tile is read when it's acquired.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "l2_cache_ref.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_STREAM_ON
+
+#define BASE            (0x40000000)
+#define MAX_TILE_BYTES  (3000)
+
+static uint8_t buffer[2][MAX_TILE_BYTES];
+
+// Odd sizes and addresses, out of order, one repeated
+static const l2_cache_stream_tile_t tiles[] = {
+    { (const void*) (BASE + 0x00010000), 2048 },
+    { (const void*) (BASE + 0x00012003), 1000 },
+    { (const void*) (BASE + 0x00000100), 3000 },
+    { (const void*) (BASE + 0x00010000), 2048 },
+    { (const void*) (BASE + 0x000FFF00), 256 },
+    { (const void*) (BASE + 0x00030010), 17 },
+};
+
+#define TILE_COUNT  (sizeof(tiles) / sizeof(tiles[0]))
+
+
+static void run_stream(
+    const unsigned count)
+{
+    l2_cache_stream_t stream;
+    l2_cache_stream_init(&stream, tiles, count, buffer[0], buffer[1]);
+
+    const unsigned reads = ram_flash_stats.read_count;
+
+    for(int k = 0; k < count; k++) {
+        const void* tile = l2_cache_stream_acquire(&stream);
+
+        assert( tile == buffer[k % 2] );
+        assert( memcmp(tile, ram_flash_at((unsigned) tiles[k].src), tiles[k].bytes) == 0 );
+        assert( ram_flash_stats.read_count == reads + k + 1 );
+
+        // Read straight from flash, not through the cache
+        assert( !l2_cache_two_way_get_addr_info(tiles[k].src).is_hit );
+
+        l2_cache_stream_release(&stream);
+    }
+
+    assert( l2_cache_stream_acquire(&stream) == NULL );
+    assert( l2_cache_stream_acquire(&stream) == NULL );
+
+    l2_cache_stream_free(&stream);
+}
+
+
+void test_stream(void)
+{
+    l2_cache_setup_two_way(64, 256, test_cache_buffer, ram_flash_read);
+
+    // No tiles, fewer tiles than buffers, and more
+    for(int count = 0; count <= TILE_COUNT; count++) {
+        run_stream(count);
+    }
+
+    printf("Stream: %u tiles\n", (unsigned) TILE_COUNT);
+}
+
+#else
+
+void test_stream(void)
+{
+}
+
+#endif // L2_CACHE_STREAM_ON
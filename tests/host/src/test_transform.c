@@ -0,0 +1,138 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that regions with a transform serve their lines decoded, reading only the encoded
+// bytes on a miss, and that regions without one are left alone.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache_ref.h"
+#include "l2_cache_internal.h"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#if L2_CACHE_TRANSFORM_ON
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (50000)
+
+// Decoded views, and where their encoded data is
+#define INT4_ADDR       (0x40200000)
+#define INT4_BYTES      (64 * 1024)
+#define INT4_ENCODED    (0x40300000)
+
+#define DELTA_ADDR      (0x40400000)
+#define DELTA_BYTES     (16 * 1024)
+#define DELTA_ENCODED   (0x40500000)
+
+#define SWAP_ADDR       (0x40600000)
+#define SWAP_BYTES      (8 * 1024)
+#define SWAP_ENCODED    (0x40700000)
+
+
+// What a fill in a region with a transform should see, decoded independently
+static void expected(
+    const l2_cache_region_t* r,
+    const unsigned addr,
+    uint8_t out[FILL_BYTES])
+{
+    const unsigned offset = addr - (unsigned) r->start;
+    const unsigned line = offset / r->line_size_bytes;
+    const unsigned in_line = offset % r->line_size_bytes;
+    const uint8_t* encoded = ram_flash_at((unsigned) r->encoded + line * r->encoded_line_bytes);
+
+    for(int k = 0; k < FILL_BYTES; k++) {
+        const unsigned at = in_line + k;
+
+        if(r->transform == l2_cache_transform_int4) {
+            const int nibble = (encoded[at / 2] >> (4 * (at % 2))) & 0xF;
+            out[k] = (uint8_t) ((nibble & 0x8)? nibble - 16 : nibble);
+        } else if(r->transform == l2_cache_transform_delta8) {
+            uint8_t sum = 0;
+            for(int j = 0; j <= at; j++)
+                sum += encoded[j];
+            out[k] = sum;
+        } else {
+            out[k] = encoded[(at & ~3) + 3 - (at & 3)];
+        }
+    }
+}
+
+
+void test_transform(void)
+{
+    const l2_cache_region_t regions[] = {
+        {
+            .start = (void*) INT4_ADDR, .len = INT4_BYTES, .type = L2_CACHE_REGION_DIRECT_MAP,
+            .line_count = 32, .line_size_bytes = 256, .cache_buffer = &test_cache_buffer[0],
+            .transform = l2_cache_transform_int4, .encoded = (void*) INT4_ENCODED,
+            .encoded_line_bytes = 128,
+        },
+        {
+            .start = (void*) DELTA_ADDR, .len = DELTA_BYTES, .type = L2_CACHE_REGION_TWO_WAY,
+            .line_count = 16, .line_size_bytes = 128, .cache_buffer = &test_cache_buffer[4096],
+            .transform = l2_cache_transform_delta8, .encoded = (void*) DELTA_ENCODED,
+            .encoded_line_bytes = 128,
+        },
+        {
+            .start = (void*) SWAP_ADDR, .len = SWAP_BYTES, .type = L2_CACHE_REGION_DIRECT_MAP,
+            .line_count = 16, .line_size_bytes = 64, .cache_buffer = &test_cache_buffer[8192],
+            .transform = l2_cache_transform_byteswap32, .encoded = (void*) SWAP_ENCODED,
+            .encoded_line_bytes = 64,
+        },
+        {
+            .start = NULL, .len = 0, .type = L2_CACHE_REGION_DIRECT_MAP,
+            .line_count = 64, .line_size_bytes = 256, .cache_buffer = &test_cache_buffer[12288],
+        },
+    };
+    const unsigned region_count = sizeof(regions) / sizeof(regions[0]);
+
+    ram_flash_init();
+    l2_cache_setup_regions(regions, region_count, ram_flash_read);
+
+    uint32_t seed = 4242;
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        seed = seed * 1664525 + 1013904223;
+
+        const l2_cache_region_t* r = &regions[(seed >> 30) % region_count];
+        // (kept below the decoded views for the catch-all region)
+        const unsigned len = r->len? r->len : INT4_ADDR - XS1_SWMEM_BASE;
+        const unsigned base = r->len? (unsigned) r->start : XS1_SWMEM_BASE;
+        const unsigned addr = base + ((seed >> 4) % (len / FILL_BYTES)) * FILL_BYTES;
+
+        const ram_flash_stats_t stats = ram_flash_stats;
+        const void* data = l2_cache_regions_fill(addr);
+
+        if(r->transform == NULL) {
+            assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+            continue;
+        }
+
+        uint8_t want[FILL_BYTES];
+        expected(r, addr, want);
+        assert( memcmp(data, want, FILL_BYTES) == 0 );
+
+        // A miss reads the line's encoded bytes, and nothing else
+        if(ram_flash_stats.read_count != stats.read_count) {
+            const unsigned line = (addr - (unsigned) r->start) / r->line_size_bytes;
+
+            assert( ram_flash_stats.read_count == stats.read_count + 1 );
+            assert( ram_flash_stats.last_bytes == r->encoded_line_bytes );
+            assert( (unsigned) ram_flash_stats.last_src
+                        == (unsigned) r->encoded + line * r->encoded_line_bytes );
+        }
+    }
+
+    printf("test_transform: passed\n");
+}
+
+#else
+
+void test_transform(void) {}
+
+#endif // L2_CACHE_TRANSFORM_ON
@@ -0,0 +1,106 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// Checks that l2_cache.hpp works out the same geometry as the C library, at compile time
+// where it can, and that a cache set up through it behaves exactly like one set up in C.
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <xs1.h>
+
+#include "l2_cache.hpp"
+#include "ram_flash.h"
+#include "test_common.h"
+
+#define FILL_BYTES      32
+#define TRACE_LENGTH    (20000)
+
+typedef l2_cache<l2_cache_direct_map_engine, 64, 256> direct_map_cache_t;
+typedef l2_cache<l2_cache_two_way_engine, 256, 32> two_way_cache_t;
+
+static direct_map_cache_t direct_map_cache;
+static two_way_cache_t two_way_cache;
+
+static_assert( direct_map_cache_t::buffer_words == L2_CACHE_BUFFER_WORDS_DIRECT_MAP(256, 64), "" );
+static_assert( two_way_cache_t::buffer_words == L2_CACHE_BUFFER_WORDS_TWO_WAY(32, 256), "" );
+
+static_assert( direct_map_cache_t::capacity_bytes == 16 * 1024, "" );
+static_assert( two_way_cache_t::capacity_bytes == 16 * 1024, "" );
+
+static_assert( direct_map_cache_t::tag_bits == L2_CACHE_SWMEM_ADDRESS_BITS - 6 - 8, "" );
+static_assert( two_way_cache_t::tag_bits == L2_CACHE_SWMEM_ADDRESS_BITS - 8 - 5, "" );
+
+// Known at compile time, so no code at all
+static_assert( direct_map_cache_t::offset(XS1_SWMEM_BASE + 0x1234) == 0x34, "" );
+static_assert( direct_map_cache_t::index(XS1_SWMEM_BASE + 0x1234) == 0x48, "" );
+static_assert( direct_map_cache_t::line_address(XS1_SWMEM_BASE + 0x1234) == XS1_SWMEM_BASE + 0x1200, "" );
+static_assert( two_way_cache_t::index(XS1_SWMEM_BASE + 0x1234) == 0x12, "" );
+
+
+template <typename Cache>
+static void check_direct_map_geometry(
+    const unsigned addr)
+{
+    const typename Cache::addr_info_t info = Cache::addr_info((void*) addr);
+
+    assert( info.entry_offset == Cache::offset(addr) );
+    assert( info.entry_index == Cache::index(addr) );
+    assert( info.tag == Cache::tag(addr) );
+}
+
+
+template <typename Cache>
+static void check_two_way_geometry(
+    const unsigned addr)
+{
+    const typename Cache::addr_info_t info = Cache::addr_info((void*) addr);
+
+    assert( info.slot_offset == Cache::offset(addr) );
+    assert( info.entry_index == Cache::index(addr) );
+    assert( info.tag == Cache::tag(addr) );
+}
+
+
+template <typename Cache>
+static void run_trace(
+    Cache& cache,
+    void (*check_geometry)(const unsigned))
+{
+    // The buffer is owned by the cache object, and sized for it
+    assert( (((uintptr_t) cache.buffer()) & 0x7) == 0 );
+    assert( sizeof(cache) == Cache::buffer_words * sizeof(uint32_t) );
+
+    cache.setup(ram_flash_read);
+
+    const uint8_t* buffer_start = (const uint8_t*) cache.buffer();
+    const uint8_t* buffer_end = buffer_start + Cache::buffer_words * sizeof(uint32_t);
+
+    test_trace_t trace;
+    test_trace_init(&trace, Cache::line_bytes + Cache::line_count);
+
+    for(int k = 0; k < TRACE_LENGTH; k++) {
+        const unsigned addr = test_trace_next(&trace);
+
+        check_geometry(addr);
+
+        const uint8_t* data = (const uint8_t*) Cache::ref_fill(addr);
+
+        assert( memcmp(data, ram_flash_at(addr), FILL_BYTES) == 0 );
+        assert( data >= buffer_start && data + FILL_BYTES <= buffer_end );
+        assert( Cache::addr_info((void*) addr).is_hit );
+    }
+}
+
+
+void test_typed_config(void)
+{
+    printf("Typed config: direct-map, %u x %u byte lines\n",
+           direct_map_cache_t::line_count, direct_map_cache_t::line_bytes);
+    run_trace(direct_map_cache, check_direct_map_geometry<direct_map_cache_t>);
+
+    printf("Typed config: two-way, %u x %u byte lines\n",
+           two_way_cache_t::line_count, two_way_cache_t::line_bytes);
+    run_trace(two_way_cache, check_two_way_geometry<two_way_cache_t>);
+}
@@ -0,0 +1,56 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <math.h>
+
+#include "kernels.h"
+
+int32_t fir_coef[FIR_TAPS];
+int32_t fir_input[FIR_BLOCK + FIR_TAPS - 1];
+int32_t fft_cos[FFT_N / 2];
+int32_t fft_sin[FFT_N / 2];
+int32_t fft_input[2 * FFT_N];
+uint8_t sm_input[SM_INPUT_BYTES];
+
+#define KERNEL_ENTRY(NAME)  { #NAME, NAME##_sram, NAME##_swmem }
+
+const kernel_t kernels[] = {
+    KERNEL_ENTRY(fir),
+    KERNEL_ENTRY(fft),
+    KERNEL_ENTRY(state_machine),
+};
+
+const unsigned kernel_count = sizeof(kernels) / sizeof(kernels[0]);
+
+
+static uint32_t lcg_next(
+    uint32_t* seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed;
+}
+
+
+void kernels_init(void)
+{
+    uint32_t seed = 1;
+
+    // Low-pass, symmetric, summing to just under 1.0 in Q31
+    for(int k = 0; k < FIR_TAPS; k++)
+        fir_coef[k] = (int32_t) ((k + 1) * (FIR_TAPS - k)) * (0x7FFFFFFF / 46000);
+
+    for(int k = 0; k < FIR_BLOCK + FIR_TAPS - 1; k++)
+        fir_input[k] = ((int32_t) lcg_next(&seed)) >> 2;
+
+    for(int k = 0; k < FFT_N / 2; k++) {
+        const double theta = (2 * M_PI * k) / FFT_N;
+        fft_cos[k] = (int32_t) lround(cos(theta) * (1 << 30));
+        fft_sin[k] = (int32_t) lround(sin(theta) * (1 << 30));
+    }
+
+    for(int k = 0; k < 2 * FFT_N; k++)
+        fft_input[k] = ((int32_t) lcg_next(&seed)) >> 2;
+
+    for(int k = 0; k < SM_INPUT_BYTES; k++)
+        sm_input[k] = lcg_next(&seed) >> 24;
+}
@@ -0,0 +1,59 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <stdint.h>
+
+#define FIR_TAPS        (64)
+#define FIR_BLOCK       (256)
+
+#define FFT_LOG2_N      (8)
+#define FFT_N           (1 << FFT_LOG2_N)
+
+#define SM_STATES       (128)
+#define SM_INPUT_BYTES  (2048)
+
+#define KERNEL_FN  __attribute__((fptrgroup("kernel_fptr_grp")))
+typedef uint32_t (*kernel_fn)(void);
+
+/**
+ * A benchmark kernel, built twice: once in SRAM and once in SwMem. Each returns a checksum
+ * of its output so the two copies can be checked against each other.
+ */
+typedef struct {
+    const char* name;
+
+    KERNEL_FN
+    kernel_fn sram;
+
+    KERNEL_FN
+    kernel_fn swmem;
+} kernel_t;
+
+extern const kernel_t kernels[];
+extern const unsigned kernel_count;
+
+/**
+ * Inputs shared by both copies of the kernels. They live in SRAM, so that only the
+ * instruction fetches go through the cache.
+ */
+extern int32_t fir_coef[FIR_TAPS];
+extern int32_t fir_input[FIR_BLOCK + FIR_TAPS - 1];
+extern int32_t fft_cos[FFT_N / 2];
+extern int32_t fft_sin[FFT_N / 2];
+extern int32_t fft_input[2 * FFT_N];
+extern uint8_t sm_input[SM_INPUT_BYTES];
+
+void kernels_init(void);
+
+#define KERNEL_DECLARE(NAME) \
+    uint32_t NAME##_sram(void); \
+    uint32_t NAME##_swmem(void);
+
+KERNEL_DECLARE(fir)
+KERNEL_DECLARE(fft)
+KERNEL_DECLARE(state_machine)
+
+#endif // KERNELS_H_
@@ -0,0 +1,134 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * The kernel bodies. Included by kernels_sram.c and kernels_swmem.c with KERNEL_ATTR and
+ * KERNEL() defined, so that the same code is built into both places.
+ */
+
+#ifndef KERNEL_ATTR
+#error KERNEL_ATTR must be defined before including kernels_impl.h
+#endif
+
+#include <stdint.h>
+
+#include "kernels.h"
+
+KERNEL_ATTR
+static uint32_t KERNEL(checksum)(
+    const int32_t* data,
+    const unsigned count)
+{
+    uint32_t sum = 0;
+    for(int k = 0; k < count; k++)
+        sum = (sum << 5) + (sum >> 27) + (uint32_t) data[k];
+    return sum;
+}
+
+
+/*
+ * Block FIR filter, Q31 coefficients with a 64-bit accumulator
+ */
+KERNEL_FN
+KERNEL_ATTR
+uint32_t KERNEL(fir)(void)
+{
+    static int32_t output[FIR_BLOCK];
+
+    for(int n = 0; n < FIR_BLOCK; n++) {
+        const int32_t* x = &fir_input[n + FIR_TAPS - 1];
+        int64_t acc = 0;
+
+        for(int k = 0; k < FIR_TAPS; k++)
+            acc += (int64_t) fir_coef[k] * x[-k];
+
+        output[n] = (int32_t) (acc >> 31);
+    }
+
+    return KERNEL(checksum)(output, FIR_BLOCK);
+}
+
+
+/*
+ * In-place radix-2 decimation-in-time FFT of FFT_N complex Q30 values, halved at each stage
+ * so it can't overflow
+ */
+KERNEL_FN
+KERNEL_ATTR
+uint32_t KERNEL(fft)(void)
+{
+    static int32_t x[2 * FFT_N];
+
+    // Bit-reversed copy of the input
+    for(int k = 0; k < FFT_N; k++) {
+        unsigned r = 0;
+        for(int b = 0; b < FFT_LOG2_N; b++)
+            r |= ((k >> b) & 1) << (FFT_LOG2_N - 1 - b);
+        x[2*r]   = fft_input[2*k];
+        x[2*r+1] = fft_input[2*k+1];
+    }
+
+    for(int half = 1, step = FFT_N / 2; half < FFT_N; half <<= 1, step >>= 1) {
+        for(int j = 0; j < half; j++) {
+            const int64_t wr = fft_cos[j * step];
+            const int64_t wi = -fft_sin[j * step];
+
+            for(int a = j; a < FFT_N; a += 2 * half) {
+                const int b = a + half;
+                const int32_t tr = (int32_t) ((wr * x[2*b] - wi * x[2*b+1]) >> 30);
+                const int32_t ti = (int32_t) ((wr * x[2*b+1] + wi * x[2*b]) >> 30);
+
+                x[2*b]   = (x[2*a] - tr) >> 1;
+                x[2*b+1] = (x[2*a+1] - ti) >> 1;
+                x[2*a]   = (x[2*a] + tr) >> 1;
+                x[2*a+1] = (x[2*a+1] + ti) >> 1;
+            }
+        }
+    }
+
+    return KERNEL(checksum)(x, 2 * FFT_N);
+}
+
+
+/*
+ * A state machine with a lot of branches and little work in each, driven by a byte stream.
+ * Every state is different code, so the footprint is large and the path through it
+ * jumps about.
+ */
+#define SM_CASE(N) \
+    case (N): \
+        acc = (acc ^ (c * (2*(N)+1))) + ((acc >> (((N) % 7) + 1)) | (N)); \
+        state = (c + acc + (N)) & (SM_STATES - 1); \
+        break;
+
+#define SM_CASE_8(N)    SM_CASE((N)+0) SM_CASE((N)+1) SM_CASE((N)+2) SM_CASE((N)+3) \
+                        SM_CASE((N)+4) SM_CASE((N)+5) SM_CASE((N)+6) SM_CASE((N)+7)
+#define SM_CASE_32(N)   SM_CASE_8((N)+0) SM_CASE_8((N)+8) SM_CASE_8((N)+16) SM_CASE_8((N)+24)
+
+KERNEL_FN
+KERNEL_ATTR
+uint32_t KERNEL(state_machine)(void)
+{
+    unsigned state = 0;
+    uint32_t acc = 1;
+
+    for(int k = 0; k < SM_INPUT_BYTES; k++) {
+        const unsigned c = sm_input[k];
+
+        switch(state) {
+            SM_CASE_32(0)
+            SM_CASE_32(32)
+            SM_CASE_32(64)
+            SM_CASE_32(96)
+            default:
+                state = 0;
+                break;
+        }
+    }
+
+    return acc ^ state;
+}
+
+#undef SM_CASE
+#undef SM_CASE_8
+#undef SM_CASE_32
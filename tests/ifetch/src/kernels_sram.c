@@ -0,0 +1,8 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// The kernels, executing from SRAM
+#define KERNEL_ATTR
+#define KERNEL(NAME)  NAME##_sram
+
+#include "kernels_impl.h"
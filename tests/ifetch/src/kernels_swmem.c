@@ -0,0 +1,10 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// The kernels, executing from SwMem (or SRAM too when USE_SWMEM is 0)
+#include "swmem_macros.h"
+
+#define KERNEL_ATTR   XCORE_CODE_SECTION_ATTRIBUTE
+#define KERNEL(NAME)  NAME##_swmem
+
+#include "kernels_impl.h"
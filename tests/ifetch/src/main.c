@@ -0,0 +1,195 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Instruction fetch benchmark. The same kernels are built into SRAM and into SwMem (see
+ * kernels_impl.h); each is timed from both, and the SwMem copies' speed is given as a share
+ * of the SRAM copies'.
+ *
+ * With USE_SWMEM=0 both copies run from SRAM, which gives the noise floor.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <platform.h> // for PLATFORM_REFERENCE_MHZ
+#include <xcore/hwtimer.h>
+#include <xcore/thread.h>
+#include <xscope.h>
+
+#include "app_common.h"
+#include "flash_handler.h"
+#include "kernels.h"
+#include "l2_cache.h"
+#include "swmem_macros.h"
+#include "debug_print.h"
+
+#define L2_CACHE_STACK_WORDS    (1000)
+
+#if BENCH_TWO_WAY
+#define ENGINE_NAME            "two-way"
+#define L2_CACHE_SETUP         l2_cache_setup_two_way
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_TWO_WAY
+#define SWMEM_THREAD           l2_cache_two_way
+#else
+#define ENGINE_NAME            "direct-map"
+#define L2_CACHE_SETUP         l2_cache_setup_direct_map
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
+#define SWMEM_THREAD           l2_cache_direct_map
+#endif // BENCH_TWO_WAY
+
+#define SWMEM_STACK_WORDS      L2_CACHE_STACK_WORDS
+
+#define L2_CACHE_BUFFER_ELMS L2_CACHE_BUFFER_SIZE(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+
+// Timed passes of each kernel, after the first
+#define BENCH_PASSES          (16)
+
+DWORD_ALIGNED
+static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
+
+DWORD_ALIGNED
+static int swmem_stack[SWMEM_STACK_WORDS];
+
+
+typedef struct {
+    uint32_t checksum;
+    unsigned first_ticks;   /// the first pass, with a cold cache
+    unsigned ticks;         /// each of the passes after that, on average
+#if L2_CACHE_DEBUG_ON
+    unsigned first_fills;
+    unsigned first_misses;
+    unsigned fills;         /// on average
+    unsigned misses;        /// on average
+#endif // L2_CACHE_DEBUG_ON
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    unsigned fetched_bytes; /// over all the passes
+    unsigned efficiency;    /// percentage of fetched bytes used
+    unsigned useful_ticks;  /// flash ticks per KiB used
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+} bench_result_t;
+
+
+static void run_kernel(
+    KERNEL_FN kernel_fn kernel,
+    bench_result_t* result)
+{
+#if L2_CACHE_DEBUG_ON
+    l2_cache_debug_stats_reset();
+#endif // L2_CACHE_DEBUG_ON
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    l2_cache_adaptive_stats_reset();
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+
+    unsigned t0 = get_reference_time();
+    result->checksum = kernel();
+    result->first_ticks = get_reference_time() - t0;
+
+#if L2_CACHE_DEBUG_ON
+    result->first_fills = get_fill_request_count();
+    result->first_misses = get_miss_count();
+    l2_cache_debug_stats_reset();
+#endif // L2_CACHE_DEBUG_ON
+
+    t0 = get_reference_time();
+    for(int k = 0; k < BENCH_PASSES; k++) {
+        const uint32_t checksum = kernel();
+        assert( checksum == result->checksum );
+    }
+    result->ticks = (get_reference_time() - t0) / BENCH_PASSES;
+
+#if L2_CACHE_DEBUG_ON
+    result->fills = get_fill_request_count() / BENCH_PASSES;
+    result->misses = get_miss_count() / BENCH_PASSES;
+#endif // L2_CACHE_DEBUG_ON
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    result->fetched_bytes = l2_cache_adaptive_stats.fetched_bytes;
+    result->efficiency = l2_cache_adaptive_efficiency();
+    result->useful_ticks = l2_cache_adaptive_ticks_per_useful_kib();
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+}
+
+
+// How fast a run of `ticks` was, as a percentage of the SRAM copy's speed
+static unsigned percent_of_sram(
+    const bench_result_t* sram,
+    const unsigned ticks)
+{
+    return (unsigned) (((uint64_t) sram->ticks * 100) / ticks);
+}
+
+
+static void report(
+    const kernel_t* kernel,
+    const bench_result_t* sram,
+    const bench_result_t* swmem)
+{
+    debug_printf("%s:\n", kernel->name);
+    debug_printf("  SRAM:           %u ticks\n", sram->ticks);
+    debug_printf("  SwMem (cold):   %u ticks  (%u%% of SRAM)\n", swmem->first_ticks,
+                 percent_of_sram(sram, swmem->first_ticks));
+    debug_printf("  SwMem:          %u ticks  (%u%% of SRAM)\n", swmem->ticks,
+                 percent_of_sram(sram, swmem->ticks));
+
+#if L2_CACHE_DEBUG_ON
+    // Fills per millisecond of run time
+    debug_printf("  Fills (cold):   %u  (%u misses, %u/ms)\n", swmem->first_fills, swmem->first_misses,
+                 (unsigned) (((uint64_t) swmem->first_fills * PLATFORM_REFERENCE_MHZ * 1000)
+                                / swmem->first_ticks));
+    debug_printf("  Fills:          %u  (%u misses, %u/ms)\n", swmem->fills, swmem->misses,
+                 (unsigned) (((uint64_t) swmem->fills * PLATFORM_REFERENCE_MHZ * 1000)
+                                / swmem->ticks));
+#endif // L2_CACHE_DEBUG_ON
+
+#if L2_CACHE_ADAPTIVE_FETCH_ON
+    debug_printf("  Flash:          %u bytes  (%u%% used, %u ticks/KiB used)\n", swmem->fetched_bytes,
+                 swmem->efficiency, swmem->useful_ticks);
+#endif // L2_CACHE_ADAPTIVE_FETCH_ON
+}
+
+
+int main(int argc, char *argv[]) {
+
+  // Without xScope enabled, the debug_printf()'s below can interfere with the flash reads
+  xscope_config_io(XSCOPE_IO_BASIC);
+
+  // Initialize flash driver
+  flash_setup();
+
+  kernels_init();
+
+  // Initialize L2 cache
+  L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
+                  L2_CACHE_LINE_SIZE_BYTES,
+                  l2_cache_buffer,
+                  flash_read_bytes  );
+
+  // Start SwMem thread
+  run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
+
+  debug_printf("\n\nInstruction fetch benchmark, %s cache, %u x %u byte lines%s\n",
+               ENGINE_NAME, L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES,
+               USE_SWMEM? "" : " (kernels in SRAM)");
+
+#if L2_CACHE_DEBUG_ON
+  debug_printf("(L2 cache debug is on, so SwMem timings are pessimistic)\n");
+#endif // L2_CACHE_DEBUG_ON
+
+  debug_printf("\n");
+
+  for(int k = 0; k < kernel_count; k++) {
+    bench_result_t sram, swmem;
+
+    run_kernel(kernels[k].sram, &sram);
+    run_kernel(kernels[k].swmem, &swmem);
+
+    // Both copies are the same code, so they had better get the same answer
+    assert( sram.checksum == swmem.checksum );
+
+    report(&kernels[k], &sram, &swmem);
+  }
+
+  debug_printf("\nSUCCESS\n\n");
+}
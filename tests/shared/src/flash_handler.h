@@ -12,6 +12,42 @@
 
 #define FLASH_PAGE_SIZE_BYTES (1<<FLASH_PAGE_SIZE_BYTES_LOG2)
 
+/**
+ * Set to have the L2 cache read flash through a flash server thread (see
+ * l2_cache_flash_server.h), which then owns the flash.
+ */
+#ifndef USE_FLASH_SERVER
+#define USE_FLASH_SERVER  (0)
+#endif
+
+/**
+ * Set to read SwMem from the flash image file on the host (through the simulator's or xrun's
+ * host file I/O) instead of from the QSPI flash, so the app runs under xsim with no board.
+ */
+#ifndef USE_FLASH_SIM
+#define USE_FLASH_SIM  (0)
+#endif
+
+#ifndef FLASH_SIM_IMAGE_PATH
+#define FLASH_SIM_IMAGE_PATH  "image_n0c0.swmem"
+#endif
+
+/**
+ * Latency model for the simulated flash: each read takes FLASH_SIM_COMMAND_NS plus
+ * FLASH_SIM_BYTE_NS per byte. The defaults roughly match the QSPI driver at 80 MHz SCLK.
+ */
+#ifndef FLASH_SIM_COMMAND_NS
+#define FLASH_SIM_COMMAND_NS  (1000)
+#endif
+
+#ifndef FLASH_SIM_BYTE_NS
+#define FLASH_SIM_BYTE_NS     (25)
+#endif
+
+#ifndef FLASH_READV_BOUNCE_BYTES
+#define FLASH_READV_BOUNCE_BYTES  (1024)
+#endif
+
 /**
  * Perform a flash read
  *
@@ -25,6 +61,20 @@ void flash_read_bytes(
     const void* src_addr,
     const size_t len);
 
+/**
+ * Perform a vectored flash read
+ *
+ * Segments which follow on from one another in flash are read in a single flash
+ * transaction, even when their destinations are scattered.
+ *
+ * \param segs       The segments to read, in ascending flash address order
+ * \param seg_count  The number of segments
+ */
+L2_CACHE_SWMEM_READV_FN
+void flash_readv_bytes(
+    const l2_cache_read_seg_t* segs,
+    const unsigned seg_count);
+
 /**
  * Initialize flash access
  */
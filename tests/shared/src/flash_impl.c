@@ -5,6 +5,7 @@
 #include <platform.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <xcore/port.h>
 
@@ -17,7 +18,52 @@
 
 #define USE_XTC_LIB_QUADSPI 0
 
-#if !USE_XTC_LIB_QUADSPI
+#if USE_FLASH_SIM
+#include <xcore/hwtimer.h>
+
+// Reference clock ticks are 10 ns
+#define NS_TO_TICKS(NS)   ((NS) / 10)
+
+static FILE* flash_image;
+
+#if FLASH_DEBUG_ON
+flash_dbg_data_t flash_dbg_data = {0, 0};
+#endif
+
+void flash_setup(void) {
+    flash_image = fopen(FLASH_SIM_IMAGE_PATH, "rb");
+
+    if(flash_image == NULL) {
+        printf("Unable to open flash image '%s'\n", FLASH_SIM_IMAGE_PATH);
+        exit(1);
+    }
+}
+
+L2_CACHE_SWMEM_READ_FN
+void flash_read_bytes(
+    void* dst_addr,
+    const void* src_addr,
+    const size_t len)
+{
+    const unsigned t1 = get_reference_time();
+
+    fseek(flash_image, ((unsigned) src_addr) - XS1_SWMEM_BASE, SEEK_SET);
+    const size_t got = fread(dst_addr, 1, len, flash_image);
+
+    // Flash beyond the end of the image is erased
+    if(got < len)
+        memset(&((uint8_t*) dst_addr)[got], 0xFF, len - got);
+
+    const unsigned latency = NS_TO_TICKS(FLASH_SIM_COMMAND_NS + len * FLASH_SIM_BYTE_NS);
+    while(get_reference_time() - t1 < latency);
+
+#if FLASH_DEBUG_ON
+    flash_dbg_data.read_count++;
+    flash_dbg_data.read_time += get_reference_time() - t1;
+#endif /* FLASH_DEBUG_ON */
+}
+
+#elif !USE_XTC_LIB_QUADSPI
 
 #include "qspi_flash.h"
 
@@ -139,4 +185,62 @@ void flash_read_bytes(
 #endif
 }
 
-#endif /* !USE_XTC_LIB_QUADSPI */
+#endif /* USE_FLASH_SIM */
+
+
+L2_CACHE_SWMEM_READV_FN
+void flash_readv_bytes(
+    const l2_cache_read_seg_t* segs,
+    const unsigned seg_count)
+{
+    // Only the L2 cache thread calls this, so one bounce buffer is enough
+    static uint32_t bounce[FLASH_READV_BOUNCE_BYTES / sizeof(uint32_t)];
+
+    unsigned k = 0;
+
+    while(k < seg_count) {
+
+        // Find the run of segments that follow on from one another in flash
+        unsigned end = k + 1;
+        unsigned run_bytes = segs[k].bytes;
+        while(end < seg_count && ((unsigned) segs[end].src) == ((unsigned) segs[k].src) + run_bytes) {
+            run_bytes += segs[end].bytes;
+            end++;
+        }
+
+        // A single segment can be read straight into place
+        if(end == k + 1) {
+            flash_read_bytes(segs[k].dst, segs[k].src, segs[k].bytes);
+            k = end;
+            continue;
+        }
+
+        // Otherwise read the run through the bounce buffer, one transaction per buffer-full
+        const uint8_t* src = segs[k].src;
+        unsigned seg_offset = 0;
+
+        while(run_bytes > 0) {
+            const unsigned chunk = (run_bytes < sizeof(bounce))? run_bytes : sizeof(bounce);
+
+            flash_read_bytes(bounce, src, chunk);
+
+            for(unsigned done = 0; done < chunk; ) {
+                unsigned n = segs[k].bytes - seg_offset;
+                if(n > chunk - done)
+                    n = chunk - done;
+
+                memcpy(&((uint8_t*) segs[k].dst)[seg_offset], &((uint8_t*) bounce)[done], n);
+
+                done += n;
+                seg_offset += n;
+                if(seg_offset == segs[k].bytes) {
+                    seg_offset = 0;
+                    k++;
+                }
+            }
+
+            src += chunk;
+            run_bytes -= chunk;
+        }
+    }
+}
@@ -0,0 +1,6 @@
+## Sources every test app builds: the flash read function and its setup, and common macros
+set(TEST_SHARED_PATH ${CMAKE_SOURCE_DIR}/tests/shared)
+
+file( GLOB_RECURSE    TEST_SHARED_SOURCES      ${TEST_SHARED_PATH}/src/*.c )
+
+set( TEST_SHARED_INCLUDES  ${TEST_SHARED_PATH}/src )
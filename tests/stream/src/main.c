@@ -0,0 +1,228 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Tile streaming test. Streams STREAM_TILES tiles of SwMem data through l2_cache_stream.h with
+ * a real fetch thread, checking every word of every tile, and spends a set time working on
+ * each tile before releasing it. Each run prints one line:
+ *
+ *   STREAM {"engine": ..., "reader": ..., "work_ticks": ..., "wait_ticks": ..., ...}
+ *
+ * All the figures are reference clock ticks. "tile_ticks" is how long one tile takes to read
+ * on its own. With no work, the application waits for nearly every read; with twice a tile's
+ * read time of work on each tile, it should only wait for the first. Both are checked.
+ *
+ * Each run is made once on its own and once with another thread reading the rest of the
+ * data through the cache at random, so that the fetch thread's reads and the cache's misses
+ * share the flash (under the flash lock).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <xcore/hwtimer.h>
+#include <xcore/thread.h>
+#include <xscope.h>
+
+#include "app_common.h"
+#include "flash_handler.h"
+#include "l2_cache.h"
+#include "stream_data.h"
+#include "debug_print.h"
+
+#define L2_CACHE_STACK_WORDS    (1000)
+
+#if BENCH_TWO_WAY
+#define ENGINE_NAME            "two_way"
+#define L2_CACHE_SETUP         l2_cache_setup_two_way
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_TWO_WAY
+#define SWMEM_THREAD           l2_cache_two_way
+#else
+#define ENGINE_NAME            "direct_map"
+#define L2_CACHE_SETUP         l2_cache_setup_direct_map
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
+#define SWMEM_THREAD           l2_cache_direct_map
+#endif // BENCH_TWO_WAY
+
+#define SWMEM_STACK_WORDS      L2_CACHE_STACK_WORDS
+
+#define L2_CACHE_BUFFER_ELMS L2_CACHE_BUFFER_SIZE(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+
+// Tiles streamed in each run, from the first half of the data
+#ifndef STREAM_TILES
+#define STREAM_TILES          (16)
+#endif
+
+#define TILE_WORDS            ((STREAM_DATA_LEN / 2) / STREAM_TILES)
+#define TILE_BYTES            (TILE_WORDS * sizeof(int))
+
+// The reader thread reads the second half
+#define READER_FIRST          (STREAM_DATA_LEN / 2)
+#define READER_WORDS          (STREAM_DATA_LEN / 2)
+
+// The fetch thread reads flash with the cache's read function, so needs as much stack
+#define FETCH_STACK_WORDS     L2_CACHE_STACK_WORDS
+#define READER_STACK_WORDS    (256)
+
+DWORD_ALIGNED
+static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
+
+DWORD_ALIGNED
+static int swmem_stack[SWMEM_STACK_WORDS];
+
+DWORD_ALIGNED
+static int fetch_stack[FETCH_STACK_WORDS];
+
+DWORD_ALIGNED
+static int reader_stack[READER_STACK_WORDS];
+
+DWORD_ALIGNED
+static int tile_buffer[2][TILE_WORDS];
+
+static l2_cache_stream_tile_t tiles[STREAM_TILES];
+
+
+typedef struct {
+    volatile unsigned stop;
+    unsigned reads;
+} reader_t;
+
+static reader_t reader;
+
+
+// Reads the second half of the data at random, one word a fill, until stopped
+static void reader_thread(
+    void* arg)
+{
+    reader_t* r = arg;
+    uint32_t seed = 0x9E3779B9;
+
+    r->reads = 0;
+
+    while(!r->stop) {
+        // xorshift32
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        const unsigned index = READER_FIRST + ((seed % READER_WORDS) & ~7);
+        const int value = ((volatile const int*) stream_data)[index];
+
+        assert( value == index );
+        r->reads++;
+    }
+}
+
+
+// Check every word of tile k, then keep working on it until `work_ticks` have passed
+static void work_on(
+    const int* tile,
+    const unsigned k,
+    const unsigned work_ticks)
+{
+    const unsigned t0 = get_reference_time();
+    const unsigned first = (const int*) tiles[k].src - stream_data;
+
+    for(int j = 0; j < TILE_WORDS; j++)
+        assert( tile[j] == first + j );
+
+    while(get_reference_time() - t0 < work_ticks)
+        ;
+}
+
+
+static void run_stream(
+    const unsigned tile_ticks,
+    const unsigned work_ticks,
+    const unsigned with_reader)
+{
+    l2_cache_stream_t stream;
+    l2_cache_stream_init(&stream, tiles, STREAM_TILES, tile_buffer[0], tile_buffer[1]);
+
+    threadgroup_t group = thread_group_alloc();
+
+    thread_group_add(group, l2_cache_stream_thread, &stream,
+                     STACK_BASE(fetch_stack, FETCH_STACK_WORDS));
+
+    reader.stop = 0;
+    if(with_reader) {
+        thread_group_add(group, reader_thread, &reader,
+                         STACK_BASE(reader_stack, READER_STACK_WORDS));
+    }
+
+    thread_group_start(group);
+
+    const unsigned t0 = get_reference_time();
+    unsigned k = 0;
+    const void* tile;
+
+    while((tile = l2_cache_stream_acquire(&stream)) != NULL) {
+        work_on(tile, k++, work_ticks);
+        l2_cache_stream_release(&stream);
+    }
+
+    const unsigned total_ticks = get_reference_time() - t0;
+
+    assert( k == STREAM_TILES );
+
+    reader.stop = 1;
+    l2_cache_stream_free(&stream);
+    thread_group_wait_and_free(group);
+
+    debug_printf("STREAM {\"engine\": \"%s\", \"reader\": %u, \"reader_fills\": %u, "
+                 "\"tiles\": %u, \"tile_bytes\": %u, \"tile_ticks\": %u, "
+                 "\"work_ticks\": %u, \"wait_ticks\": %u, \"total_ticks\": %u}\n",
+                 ENGINE_NAME, with_reader, with_reader? reader.reads : 0,
+                 STREAM_TILES, (unsigned) TILE_BYTES, tile_ticks,
+                 work_ticks, stream.wait_ticks, total_ticks);
+
+    // Only the first read can't be hidden behind the work...
+    if(work_ticks >= 2 * tile_ticks)
+        assert( stream.wait_ticks <= 2 * tile_ticks );
+
+    // ...and with no work, little of any of them can (checking a tile takes some time)
+    if(work_ticks == 0)
+        assert( stream.wait_ticks >= (STREAM_TILES / 4) * tile_ticks );
+}
+
+
+int main(int argc, char *argv[]) {
+
+  // Without xScope enabled, the debug_printf()'s below can interfere with the flash reads
+  xscope_config_io(XSCOPE_IO_BASIC);
+
+  // Initialize flash driver
+  flash_setup();
+
+  // Initialize L2 cache
+  L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
+                  L2_CACHE_LINE_SIZE_BYTES,
+                  l2_cache_buffer,
+                  flash_read_bytes  );
+
+  // Start SwMem thread
+  run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
+
+  debug_printf("\n\nTile streaming test, %s cache, %u x %u byte lines\n",
+               ENGINE_NAME, L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES);
+
+  // Out of order, so the fetch thread can't get away with reading straight through
+  for(int k = 0; k < STREAM_TILES; k++) {
+    tiles[k].src = &stream_data[((k * 5) % STREAM_TILES) * TILE_WORDS];
+    tiles[k].bytes = TILE_BYTES;
+  }
+
+  // One tile's read on its own, with nothing else reading flash
+  const unsigned t0 = get_reference_time();
+  flash_read_bytes(tile_buffer[0], tiles[0].src, TILE_BYTES);
+  const unsigned tile_ticks = get_reference_time() - t0;
+
+  for(int with_reader = 0; with_reader < 2; with_reader++) {
+    run_stream(tile_ticks, 0, with_reader);
+    run_stream(tile_ticks, tile_ticks / 2, with_reader);
+    run_stream(tile_ticks, 2 * tile_ticks, with_reader);
+  }
+
+  debug_printf("\nSUCCESS\n\n");
+}
@@ -0,0 +1,21 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef SWMEM_MACROS_H_
+#define SWMEM_MACROS_H_
+
+#include <stdint.h>
+
+#ifndef USE_SWMEM
+#define USE_SWMEM  (0)
+#endif // USE_SWMEM
+
+#if USE_SWMEM
+#define XCORE_DATA_SECTION_ATTRIBUTE    __attribute__((section(".SwMem_data")))
+#define XCORE_CODE_SECTION_ATTRIBUTE    __attribute__((section(".SwMem_code")))
+#else
+#define XCORE_DATA_SECTION_ATTRIBUTE
+#define XCORE_CODE_SECTION_ATTRIBUTE
+#endif // USE_SWMEM
+
+#endif // SWMEM_MACROS_H_
@@ -0,0 +1,375 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Contention stress benchmark. The cache thread serves SwMem fills for every other thread on
+ * the tile, one at a time; this runs 1 to STRESS_MAX_THREADS application threads at once,
+ * each timing STRESS_ACCESSES reads of SwMem data, one per fill, and reports how the fill
+ * latency, its fairness between threads and the total fill rate change with the thread count.
+ *
+ * Each run is one access pattern (sequential or random fills) over either one region shared
+ * by all the threads or a region of each thread's own, and prints one line:
+ *
+ *   STRESS {"engine": ..., "threads": ..., "fills_per_ms": ..., "fairness_permille": ..., ...}
+ *
+ * All the figures are integers. Latencies are in core cycles, first over all the threads and
+ * then for each ("thread_p50", "thread_p99", in thread order). Fairness is Jain's index of the
+ * threads' fill rates, in permille: 1000 when they all get the same rate, 1000 / threads when
+ * one gets them all.
+ *
+ * Built with L2_CACHE_BULK_READ_ON, it then checks l2_cache_read() against the cache thread:
+ * one thread copies random ranges of the shared region out with it while the others keep the
+ * cache replacing lines, so that copies of resident lines race the engine's l2_cache_fill_seq
+ * updates. Every word copied is checked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <platform.h> // for PLATFORM_REFERENCE_MHZ
+#include <xcore/hwtimer.h>
+#include <xcore/thread.h>
+#include <xscope.h>
+
+#include "app_common.h"
+#include "flash_handler.h"
+#include "l2_cache.h"
+#include "stress_data.h"
+#include "debug_print.h"
+
+#define L2_CACHE_STACK_WORDS    (1000)
+
+#if BENCH_TWO_WAY
+#define ENGINE_NAME            "two_way"
+#define L2_CACHE_SETUP         l2_cache_setup_two_way
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_TWO_WAY
+#define SWMEM_THREAD           l2_cache_two_way
+#else
+#define ENGINE_NAME            "direct_map"
+#define L2_CACHE_SETUP         l2_cache_setup_direct_map
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
+#define SWMEM_THREAD           l2_cache_direct_map
+#endif // BENCH_TWO_WAY
+
+#define SWMEM_STACK_WORDS      L2_CACHE_STACK_WORDS
+
+#define L2_CACHE_BUFFER_ELMS L2_CACHE_BUFFER_SIZE(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+
+// SystemFrequency in XCORE-AI-EXPLORER.xn
+#define STRESS_CORE_MHZ       (600)
+
+#define TICKS_TO_CYCLES(T)    ((unsigned) (((uint64_t) (T) * STRESS_CORE_MHZ) / PLATFORM_REFERENCE_MHZ))
+
+// Eight threads a tile, less the cache thread
+#ifndef STRESS_MAX_THREADS
+#define STRESS_MAX_THREADS    (7)
+#endif
+
+// Timed reads per thread, after as many again to warm up
+#ifndef STRESS_ACCESSES
+#define STRESS_ACCESSES       (1024)
+#endif
+
+// The data is split into one shared region and a private region for each thread
+#define REGION_WORDS          (STRESS_DATA_LEN / (STRESS_MAX_THREADS + 1))
+
+#define FILL_WORDS            (32 / sizeof(int))
+
+#define WORKER_STACK_WORDS    (256)
+
+DWORD_ALIGNED
+static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
+
+DWORD_ALIGNED
+static int swmem_stack[SWMEM_STACK_WORDS];
+
+// The main thread is worker 0
+DWORD_ALIGNED
+static int worker_stack[STRESS_MAX_THREADS - 1][WORKER_STACK_WORDS];
+
+
+typedef struct {
+    unsigned random;
+
+    unsigned first;         /// first word of the region read
+    uint32_t seed;
+
+    unsigned start;         /// reference time of the first timed read...
+    unsigned end;           /// ...and just after the last
+
+    unsigned latency[STRESS_ACCESSES];
+} worker_t;
+
+static worker_t workers[STRESS_MAX_THREADS];
+
+static unsigned timer_overhead;
+
+// All the threads' latencies, for the percentiles over all of them
+static unsigned all_latency[STRESS_MAX_THREADS * STRESS_ACCESSES];
+
+
+// Index into stress_data[] of the next word read, always the first of a fill
+static unsigned next_index(
+    worker_t* w,
+    const unsigned k)
+{
+    unsigned offset;
+
+    if(w->random) {
+        // xorshift32
+        w->seed ^= w->seed << 13;
+        w->seed ^= w->seed >> 17;
+        w->seed ^= w->seed << 5;
+        offset = w->seed;
+    } else {
+        offset = k * FILL_WORDS;
+    }
+
+    return w->first + ((offset % REGION_WORDS) & ~(FILL_WORDS - 1));
+}
+
+
+static void worker(
+    void* arg)
+{
+    worker_t* w = arg;
+
+    for(int pass = 0; pass < 2; pass++) {
+        if(pass == 1)
+            w->start = get_reference_time();
+
+        for(int k = 0; k < STRESS_ACCESSES; k++) {
+            const unsigned index = next_index(w, pass * STRESS_ACCESSES + k);
+
+            const unsigned t0 = get_reference_time();
+            const int value = ((volatile const int*) stress_data)[index];
+            const unsigned t1 = get_reference_time();
+
+            assert( value == index );
+            w->latency[k] = t1 - t0 - timer_overhead;
+        }
+    }
+
+    w->end = get_reference_time();
+}
+
+
+static int compare_unsigned(
+    const void* a,
+    const void* b)
+{
+    const unsigned x = *(const unsigned*) a;
+    const unsigned y = *(const unsigned*) b;
+    return (x > y) - (x < y);
+}
+
+
+// The p-th permille of `count` sorted values, in core cycles
+static unsigned permille(
+    const unsigned sorted[],
+    const unsigned count,
+    const unsigned p)
+{
+    return TICKS_TO_CYCLES(sorted[((count - 1) * p) / 1000]);
+}
+
+
+static void run_threads(
+    const unsigned threads,
+    const unsigned shared,
+    const unsigned random)
+{
+    for(int t = 0; t < threads; t++) {
+        workers[t].random = random;
+        workers[t].first = shared? 0 : (t + 1) * REGION_WORDS;
+        workers[t].seed = 0x12345678 + (shared? 0 : t);
+    }
+
+    // Worker 0 runs on this thread, alongside the others
+    threadgroup_t group = thread_group_alloc();
+
+    for(int t = 1; t < threads; t++) {
+        thread_group_add(group, worker, &workers[t],
+                         STACK_BASE(worker_stack[t - 1], WORKER_STACK_WORDS));
+    }
+
+    thread_group_start(group);
+    worker(&workers[0]);
+    thread_group_wait_and_free(group);
+
+    // Fill rates, in fills per millisecond, and Jain's fairness index of them
+    unsigned first_start = workers[0].start;
+    unsigned last_end = workers[0].end;
+    uint64_t rate_sum = 0;
+    uint64_t rate_sum_sq = 0;
+
+    for(int t = 0; t < threads; t++) {
+        const worker_t* w = &workers[t];
+        const uint64_t rate = ((uint64_t) STRESS_ACCESSES * PLATFORM_REFERENCE_MHZ * 1000)
+                                    / (w->end - w->start);
+
+        rate_sum += rate;
+        rate_sum_sq += rate * rate;
+
+        if((int) (w->start - first_start) < 0)
+            first_start = w->start;
+        if((int) (w->end - last_end) > 0)
+            last_end = w->end;
+    }
+
+    const unsigned fills = threads * STRESS_ACCESSES;
+    const unsigned fills_per_ms = (unsigned) (((uint64_t) fills * PLATFORM_REFERENCE_MHZ * 1000)
+                                                / (last_end - first_start));
+    const unsigned fairness = (unsigned) ((rate_sum * rate_sum * 1000) / (threads * rate_sum_sq));
+
+    // Latencies over all the threads...
+    uint64_t total = 0;
+
+    for(int t = 0; t < threads; t++) {
+        for(int k = 0; k < STRESS_ACCESSES; k++) {
+            all_latency[t * STRESS_ACCESSES + k] = workers[t].latency[k];
+            total += workers[t].latency[k];
+        }
+    }
+
+    qsort(all_latency, fills, sizeof(all_latency[0]), compare_unsigned);
+
+    debug_printf("STRESS {\"engine\": \"%s\", \"line_bytes\": %u, \"line_count\": %u, "
+                 "\"region\": \"%s\", \"pattern\": \"%s\", \"threads\": %u, "
+                 "\"fills_per_ms\": %u, \"fairness_permille\": %u, \"mean\": %u, "
+                 "\"p50\": %u, \"p90\": %u, \"p99\": %u, \"max\": %u, ",
+                 ENGINE_NAME, L2_CACHE_LINE_SIZE_BYTES, L2_CACHE_LINE_COUNT,
+                 shared? "shared" : "private", random? "random" : "seq", threads,
+                 fills_per_ms, fairness, TICKS_TO_CYCLES(total / fills),
+                 permille(all_latency, fills, 500), permille(all_latency, fills, 900),
+                 permille(all_latency, fills, 990), permille(all_latency, fills, 1000));
+
+    // ...and for each thread
+    for(int t = 0; t < threads; t++) {
+        qsort(workers[t].latency, STRESS_ACCESSES, sizeof(unsigned), compare_unsigned);
+    }
+
+    debug_printf("\"thread_p50\": [");
+    for(int t = 0; t < threads; t++)
+        debug_printf("%s%u", t? ", " : "", permille(workers[t].latency, STRESS_ACCESSES, 500));
+
+    debug_printf("], \"thread_p99\": [");
+    for(int t = 0; t < threads; t++)
+        debug_printf("%s%u", t? ", " : "", permille(workers[t].latency, STRESS_ACCESSES, 990));
+
+    debug_printf("]}\n");
+}
+
+
+#if L2_CACHE_BULK_READ_ON
+
+// Words copied at most by each l2_cache_read()
+#define BULK_MAX_WORDS        (4 * L2_CACHE_LINE_SIZE_BYTES / sizeof(int))
+
+static int bulk_buffer[BULK_MAX_WORDS];
+
+static void run_bulk_read(
+    const unsigned threads)
+{
+    // The others read their own regions, at random, to keep lines being replaced
+    for(int t = 1; t < threads; t++) {
+        workers[t].random = 1;
+        workers[t].first = (t + 1) * REGION_WORDS;
+        workers[t].seed = 0x9E3779B9 + t;
+        workers[t].end = 0;
+    }
+
+    threadgroup_t group = thread_group_alloc();
+
+    for(int t = 1; t < threads; t++) {
+        thread_group_add(group, worker, &workers[t],
+                         STACK_BASE(worker_stack[t - 1], WORKER_STACK_WORDS));
+    }
+
+    thread_group_start(group);
+
+    uint32_t seed = 0x2545F491;
+    unsigned words_copied = 0;
+    unsigned copies = 0;
+
+    // Until the others are done
+    for(int t = 1; t < threads; t++) {
+        while(((volatile worker_t*) &workers[t])->end == 0) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+
+            const unsigned first = seed % REGION_WORDS;
+            unsigned count = 1 + (seed >> 16) % BULK_MAX_WORDS;
+            if(count > REGION_WORDS - first)
+                count = REGION_WORDS - first;
+
+            l2_cache_read(bulk_buffer, &stress_data[first], count * sizeof(int));
+
+            for(int k = 0; k < count; k++)
+                assert( bulk_buffer[k] == first + k );
+
+            words_copied += count;
+            copies++;
+        }
+    }
+
+    thread_group_wait_and_free(group);
+
+    debug_printf("BULK {\"engine\": \"%s\", \"threads\": %u, \"copies\": %u, \"words\": %u}\n",
+                 ENGINE_NAME, threads, copies, words_copied);
+}
+
+#endif // L2_CACHE_BULK_READ_ON
+
+
+int main(int argc, char *argv[]) {
+
+  // Without xScope enabled, the debug_printf()'s below can interfere with the flash reads
+  xscope_config_io(XSCOPE_IO_BASIC);
+
+  // Initialize flash driver
+  flash_setup();
+
+  // Initialize L2 cache
+  L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
+                  L2_CACHE_LINE_SIZE_BYTES,
+                  l2_cache_buffer,
+                  flash_read_bytes  );
+
+  // Start SwMem thread
+  run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
+
+  debug_printf("\n\nContention stress benchmark, %s cache, %u x %u byte lines\n",
+               ENGINE_NAME, L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES);
+
+#if L2_CACHE_DEBUG_ON
+  debug_printf("(L2 cache debug is on, so timings are pessimistic)\n");
+#endif // L2_CACHE_DEBUG_ON
+
+  // Fewest ticks between two reads of the timer, taken off every timed read
+  timer_overhead = ~0u;
+  for(int k = 0; k < 16; k++) {
+    const unsigned t0 = get_reference_time();
+    const unsigned t1 = get_reference_time();
+    if(t1 - t0 < timer_overhead)
+      timer_overhead = t1 - t0;
+  }
+
+  for(int shared = 1; shared >= 0; shared--) {
+    for(int random = 0; random < 2; random++) {
+      for(int threads = 1; threads <= STRESS_MAX_THREADS; threads++) {
+        run_threads(threads, shared, random);
+      }
+    }
+  }
+
+#if L2_CACHE_BULK_READ_ON
+  for(int threads = 2; threads <= STRESS_MAX_THREADS; threads++) {
+    run_bulk_read(threads);
+  }
+#endif // L2_CACHE_BULK_READ_ON
+
+  debug_printf("\nSUCCESS\n\n");
+}
@@ -0,0 +1,90 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// An IMA ADPCM decoder playing a clip, a frame at a time
+#include "app_common.h"
+#include "gen_data.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+
+#define ADPCM_BYTES         (16 * 1024)
+#define ADPCM_FRAME_BYTES   (512)
+#define ADPCM_FRAME_SAMPLES (2 * ADPCM_FRAME_BYTES)
+
+// Two codes a byte, mostly small steps with either sign
+#define ADPCM_BYTE(I)   ((GEN_MIX(I) & 0x33) | ((GEN_MIX(I) >> 8) & 0x88))
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const uint8_t clip[ADPCM_BYTES] = { GEN_7(ADPCM_BYTE, 0) };
+
+XCORE_DATA_SECTION_ATTRIBUTE
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60,
+    66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371,
+    408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878,
+    2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845,
+    8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086,
+    29794, 32767
+};
+
+XCORE_DATA_SECTION_ATTRIBUTE
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+const unsigned adpcm_decode_table_bytes = sizeof(clip) + sizeof(step_table) + sizeof(index_table);
+
+static int16_t frame[ADPCM_FRAME_SAMPLES];
+
+
+typedef struct {
+    int predictor;
+    int index;
+} adpcm_state_t;
+
+
+static int16_t decode(
+    adpcm_state_t* state,
+    const unsigned code)
+{
+    const int step = step_table[state->index];
+    int diff = step >> 3;
+
+    if(code & 4) diff += step;
+    if(code & 2) diff += step >> 1;
+    if(code & 1) diff += step >> 2;
+
+    state->predictor += (code & 8)? -diff : diff;
+    if(state->predictor > 32767) state->predictor = 32767;
+    if(state->predictor < -32768) state->predictor = -32768;
+
+    state->index += index_table[code];
+    if(state->index < 0) state->index = 0;
+    if(state->index > 88) state->index = 88;
+
+    return state->predictor;
+}
+
+
+uint32_t adpcm_decode_run(
+    unsigned* outputs)
+{
+    uint32_t checksum = 0;
+    adpcm_state_t state = { 0, 0 };
+
+    for(int f = 0; f < ADPCM_BYTES / ADPCM_FRAME_BYTES; f++) {
+        const uint8_t* in = &clip[f * ADPCM_FRAME_BYTES];
+
+        for(int k = 0; k < ADPCM_FRAME_BYTES; k++) {
+            frame[2 * k] = decode(&state, in[k] & 0xF);
+            frame[2 * k + 1] = decode(&state, in[k] >> 4);
+        }
+
+        for(int k = 0; k < ADPCM_FRAME_SAMPLES; k++)
+            checksum = checksum * 31 + (uint16_t) frame[k];
+    }
+
+    *outputs += 2 * ADPCM_BYTES;
+    return checksum;
+}
@@ -0,0 +1,67 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// A bank of FIR filters, from which each channel's filter is picked afresh for every block,
+// as an equaliser's presets would be
+#include <string.h>
+
+#include "app_common.h"
+#include "gen_data.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+
+#define FIR_FILTERS     (32)
+#define FIR_TAPS        (128)
+#define FIR_CHANNELS    (4)
+#define FIR_BLOCK       (32)
+#define FIR_BLOCKS      (4)
+
+// Q1.23 coefficients
+#define FIR_COEF(I)     ((int32_t) (GEN_MIX(I) << 8) - 0x800000)
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const int32_t coef[FIR_FILTERS * FIR_TAPS] = { GEN_6(FIR_COEF, 0) };
+
+const unsigned fir_bank_table_bytes = sizeof(coef);
+
+// Each channel's last FIR_TAPS - 1 inputs, then the block
+static int32_t history[FIR_CHANNELS][FIR_TAPS - 1 + FIR_BLOCK];
+
+
+uint32_t fir_bank_run(
+    unsigned* outputs)
+{
+    uint32_t checksum = 0;
+    uint32_t seed = 0x9E3779B9;
+
+    memset(history, 0, sizeof(history));
+
+    for(int b = 0; b < FIR_BLOCKS; b++) {
+        for(int ch = 0; ch < FIR_CHANNELS; ch++) {
+            int32_t* x = history[ch];
+
+            memmove(x, &x[FIR_BLOCK], (FIR_TAPS - 1) * sizeof(int32_t));
+
+            for(int k = 0; k < FIR_BLOCK; k++) {
+                seed = seed * 1664525 + 1013904223;
+                x[FIR_TAPS - 1 + k] = ((int32_t) seed) >> 16;
+            }
+
+            seed = seed * 1664525 + 1013904223;
+            const int32_t* h = &coef[(seed >> 16) % FIR_FILTERS * FIR_TAPS];
+
+            for(int k = 0; k < FIR_BLOCK; k++) {
+                int64_t acc = 0;
+
+                for(int t = 0; t < FIR_TAPS; t++)
+                    acc += (int64_t) h[t] * x[FIR_TAPS - 1 + k - t];
+
+                checksum = checksum * 31 + (uint32_t) (acc >> 23);
+            }
+        }
+    }
+
+    *outputs += FIR_BLOCKS * FIR_CHANNELS * FIR_BLOCK;
+    return checksum;
+}
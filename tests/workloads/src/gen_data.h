@@ -0,0 +1,25 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef GEN_DATA_H_
+#define GEN_DATA_H_
+
+/*
+ * Initialisers for the workloads' tables, worked out by the compiler so that they land in the
+ * flash image like any other constant data. GEN_N(F, X) is the list F(X), F(X+1), ...,
+ * F(X + 4^N - 1).
+ */
+#define GEN_1(F, X)  F((X)+0), F((X)+1), F((X)+2), F((X)+3)
+#define GEN_2(F, X)  GEN_1(F, (X)+0), GEN_1(F, (X)+4), GEN_1(F, (X)+8), GEN_1(F, (X)+12)
+#define GEN_3(F, X)  GEN_2(F, (X)+0), GEN_2(F, (X)+16), GEN_2(F, (X)+32), GEN_2(F, (X)+48)
+#define GEN_4(F, X)  GEN_3(F, (X)+0), GEN_3(F, (X)+64), GEN_3(F, (X)+128), GEN_3(F, (X)+192)
+#define GEN_5(F, X)  GEN_4(F, (X)+0), GEN_4(F, (X)+256), GEN_4(F, (X)+512), GEN_4(F, (X)+768)
+#define GEN_6(F, X)  GEN_5(F, (X)+0), GEN_5(F, (X)+1024), GEN_5(F, (X)+2048), GEN_5(F, (X)+3072)
+#define GEN_7(F, X)  GEN_6(F, (X)+0), GEN_6(F, (X)+4096), GEN_6(F, (X)+8192), GEN_6(F, (X)+12288)
+#define GEN_8(F, X)  GEN_7(F, (X)+0), GEN_7(F, (X)+16384), GEN_7(F, (X)+32768), GEN_7(F, (X)+49152)
+
+/// 16 well-mixed bits of an index
+#define GEN_MIX(X)  (((((unsigned) (X) * 0x9E3779B1u) ^ (((unsigned) (X) * 0x9E3779B1u) >> 15)) \
+                      * 0x85EBCA6Bu) >> 16)
+
+#endif // GEN_DATA_H_
@@ -0,0 +1,91 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// A text renderer, blending anti-aliased glyphs from a font into a line of a frame buffer
+#include <string.h>
+
+#include "app_common.h"
+#include "gen_data.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+
+#define GLYPH_COUNT     (128)
+#define GLYPH_WIDTH     (16)
+#define GLYPH_HEIGHT    (32)
+#define GLYPH_BYTES     (GLYPH_WIDTH * GLYPH_HEIGHT / 2)   // 4 bits per pixel
+#define GLYPH_ADVANCE   (12)                               // neighbours overlap
+
+#define TEXT_COLUMNS    (32)
+#define TEXT_LINES      (8)
+
+#define FB_WIDTH        (TEXT_COLUMNS * GLYPH_ADVANCE + GLYPH_WIDTH)
+
+// A quarter of each glyph's pixel pairs are inked
+#define GLYPH_BYTE(I)   (((GEN_MIX(I) & 3) == 0)? (uint8_t) (GEN_MIX(I) >> 8) : 0)
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const uint8_t font[GLYPH_COUNT * GLYPH_BYTES] = {
+    GEN_7(GLYPH_BYTE, 0), GEN_7(GLYPH_BYTE, 16384)
+};
+
+const unsigned glyph_render_table_bytes = sizeof(font);
+
+static uint8_t frame[GLYPH_HEIGHT][FB_WIDTH];
+
+
+static void blend(
+    uint8_t* pixel,
+    const unsigned alpha)
+{
+    *pixel += ((255 - *pixel) * alpha) >> 4;
+}
+
+
+static void draw_glyph(
+    const unsigned c,
+    const unsigned x)
+{
+    const uint8_t* glyph = &font[c * GLYPH_BYTES];
+
+    for(int y = 0; y < GLYPH_HEIGHT; y++) {
+        for(int k = 0; k < GLYPH_WIDTH / 2; k++) {
+            const uint8_t pair = *glyph++;
+
+            blend(&frame[y][x + 2 * k], pair & 0xF);
+            blend(&frame[y][x + 2 * k + 1], pair >> 4);
+        }
+    }
+}
+
+
+uint32_t glyph_render_run(
+    unsigned* outputs)
+{
+    uint32_t checksum = 0;
+    uint32_t seed = 0xA54FF53A;
+
+    for(int line = 0; line < TEXT_LINES; line++) {
+        memset(frame, 0, sizeof(frame));
+
+        for(int col = 0; col < TEXT_COLUMNS; col++) {
+            seed = seed * 1664525 + 1013904223;
+
+            // Mostly lower case, with spaces between words
+            unsigned c = 'a' + (seed >> 24) % 26;
+            if(((seed >> 21) & 7) == 0)
+                c = ' ';
+            else if(((seed >> 16) & 31) == 0)
+                c = 32 + (seed >> 8) % 96;
+
+            draw_glyph(c, col * GLYPH_ADVANCE);
+        }
+
+        for(int y = 0; y < GLYPH_HEIGHT; y++)
+            for(int x = 0; x < FB_WIDTH; x++)
+                checksum = checksum * 31 + frame[y][x];
+    }
+
+    *outputs += TEXT_LINES * TEXT_COLUMNS;
+    return checksum;
+}
@@ -0,0 +1,88 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// A lookup service: an open-addressed hash table of records, most queries going to a small
+// share of the keys, and some for keys which aren't there
+#include "app_common.h"
+#include "gen_data.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+
+#define HASH_BITS       (12)
+#define HASH_SLOTS      (1 << HASH_BITS)
+#define HASH_QUERIES    (4096)
+#define HASH_HOT_SLOTS  (256)
+
+// Multiplicative hash: a key's slot is the top bits of key * HASH_MUL
+#define HASH_MUL        (0x9E3779B1u)
+#define HASH_INV        (0x0E8B2F51u)     // HASH_MUL * HASH_INV == 1 (mod 2^32)
+
+#define HASH_OF(KEY)    (((KEY) * HASH_MUL) >> (32 - HASH_BITS))
+
+// Slot I's key, which hashes to I. Its low bits are odd, so a key made the same way with
+// even low bits is never in the table.
+#define HASH_KEY(I, ODD) \
+    ((((unsigned) (I) << (32 - HASH_BITS)) | (GEN_MIX(I) << 1) | (ODD)) * HASH_INV)
+
+// One slot in eight is empty (key 0), so absent keys' probes are short
+#define HASH_EMPTY(I)   ((GEN_MIX((I) + 0x20000) & 7) == 0)
+
+#define HASH_RECORD(I)  { HASH_EMPTY(I)? 0 : HASH_KEY(I, 1), \
+                          { GEN_MIX((I) + 0x30000), GEN_MIX((I) + 0x40000), GEN_MIX((I) + 0x50000) } }
+
+typedef struct {
+    uint32_t key;
+    uint32_t value[3];
+} record_t;
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const record_t table[HASH_SLOTS] = { GEN_6(HASH_RECORD, 0) };
+
+const unsigned hash_lookup_table_bytes = sizeof(table);
+
+
+static const record_t* lookup(
+    const uint32_t key)
+{
+    unsigned slot = HASH_OF(key);
+
+    while(1) {
+        const record_t* record = &table[slot];
+
+        if(record->key == key)
+            return record;
+        if(record->key == 0)
+            return NULL;
+
+        slot = (slot + 1) & (HASH_SLOTS - 1);
+    }
+}
+
+
+uint32_t hash_lookup_run(
+    unsigned* outputs)
+{
+    uint32_t checksum = 0;
+    uint32_t seed = 0x3C6EF372;
+
+    for(int k = 0; k < HASH_QUERIES; k++) {
+        seed = seed * 1664525 + 1013904223;
+
+        // Three in four queries are for the hot keys, spread through the table, and one in
+        // eight is for a missing key
+        const unsigned slot = ((seed >> 30) != 0)?
+            ((seed >> 8) % HASH_HOT_SLOTS) * (HASH_SLOTS / HASH_HOT_SLOTS) : (seed >> 8) % HASH_SLOTS;
+        const uint32_t key = HASH_KEY(slot, ((seed >> 27) & 7) != 0);
+
+        const record_t* record = lookup(key);
+
+        if(record == NULL)
+            checksum = checksum * 31 + 1;
+        else
+            checksum = checksum * 31 + record->value[0] + record->value[1] + record->value[2];
+    }
+
+    *outputs += HASH_QUERIES;
+    return checksum;
+}
@@ -0,0 +1,167 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+/*
+ * Workload benchmark, for tools/l2_cache_bench.py. Each workload (see workloads.h) is run once
+ * with a cold cache, then WORKLOAD_PASSES more times, and reported on one line:
+ *
+ *   WORKLOAD {"engine": ..., "workload": ..., "cycles": ..., "flash_bytes": ..., ...}
+ *
+ * cycles and flash_bytes are per pass after the first, cold_cycles and cold_flash_bytes for the
+ * first. With USE_SWMEM=0 the tables are in SRAM and the engine is reported as "sram", which
+ * is the baseline the engines' slowdown is worked out from. The compressed engine is given the
+ * same buffer as the two-way cache, to show where holding more lines pays for slower hits.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <platform.h> // for PLATFORM_REFERENCE_MHZ
+#include <xcore/hwtimer.h>
+#include <xcore/thread.h>
+#include <xscope.h>
+
+#include "app_common.h"
+#include "flash_handler.h"
+#include "l2_cache.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+#include "debug_print.h"
+
+#define L2_CACHE_STACK_WORDS    (1000)
+
+#if BENCH_COMPRESSED
+// The two-way cache's buffer, with four line indexes for each line it holds and the rest
+// for the pool
+#define ENGINE_NAME            "compressed"
+#define L2_CACHE_INDEX_COUNT   (8 * L2_CACHE_LINE_COUNT)
+#define L2_CACHE_BUFFER_ELMS   L2_CACHE_BUFFER_WORDS_TWO_WAY(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+#define L2_CACHE_POOL_BYTES    (sizeof(int) * L2_CACHE_BUFFER_ELMS - L2_CACHE_LINE_SIZE_BYTES  \
+                                  - sizeof(uint16_t) * L2_CACHE_INDEX_COUNT)
+#define SWMEM_THREAD           l2_cache_compressed
+#elif BENCH_TWO_WAY
+#define ENGINE_NAME            "two_way"
+#define L2_CACHE_SETUP         l2_cache_setup_two_way
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_TWO_WAY
+#define SWMEM_THREAD           l2_cache_two_way
+#else
+#define ENGINE_NAME            "direct_map"
+#define L2_CACHE_SETUP         l2_cache_setup_direct_map
+#define L2_CACHE_BUFFER_SIZE   L2_CACHE_BUFFER_WORDS_DIRECT_MAP
+#define SWMEM_THREAD           l2_cache_direct_map
+#endif // BENCH_COMPRESSED
+
+#define SWMEM_STACK_WORDS      L2_CACHE_STACK_WORDS
+
+#if !BENCH_COMPRESSED
+#define L2_CACHE_BUFFER_ELMS L2_CACHE_BUFFER_SIZE(L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES)
+#endif // !BENCH_COMPRESSED
+
+// SystemFrequency in XCORE-AI-EXPLORER.xn
+#define BENCH_CORE_MHZ        (600)
+
+#define TICKS_TO_CYCLES(T)    ((unsigned) (((uint64_t) (T) * BENCH_CORE_MHZ) / PLATFORM_REFERENCE_MHZ))
+
+// Passes of each workload after the first
+#define WORKLOAD_PASSES       (2)
+
+DWORD_ALIGNED
+static int l2_cache_buffer[L2_CACHE_BUFFER_ELMS];
+
+DWORD_ALIGNED
+static int swmem_stack[SWMEM_STACK_WORDS];
+
+// Bytes the cache has read from flash
+static unsigned flash_bytes;
+
+
+L2_CACHE_SWMEM_READ_FN
+static void flash_read_counted(
+    void* dst_addr,
+    const void* src_addr,
+    const size_t len)
+{
+    flash_bytes += len;
+    flash_read_bytes(dst_addr, src_addr, len);
+}
+
+
+static void run_workload(
+    const workload_t* w)
+{
+    unsigned outputs = 0;
+
+    flash_bytes = 0;
+    unsigned t0 = get_reference_time();
+    const uint32_t checksum = w->run(&outputs);
+    const unsigned cold_ticks = get_reference_time() - t0;
+    const unsigned cold_flash_bytes = flash_bytes;
+
+    outputs = 0;
+    flash_bytes = 0;
+    t0 = get_reference_time();
+    for(int k = 0; k < WORKLOAD_PASSES; k++) {
+        const uint32_t again = w->run(&outputs);
+        assert( again == checksum );
+    }
+    const unsigned ticks = (get_reference_time() - t0) / WORKLOAD_PASSES;
+
+    debug_printf("WORKLOAD {\"engine\": \"%s\", \"line_bytes\": %u, \"line_count\": %u, "
+                 "\"workload\": \"%s\", \"unit\": \"%s\", \"table_bytes\": %u, "
+                 "\"outputs\": %u, \"cycles\": %u, \"flash_bytes\": %u, "
+                 "\"cold_cycles\": %u, \"cold_flash_bytes\": %u, \"checksum\": %u}\n",
+                 USE_SWMEM? ENGINE_NAME : "sram", L2_CACHE_LINE_SIZE_BYTES, L2_CACHE_LINE_COUNT,
+                 w->name, w->unit, *w->table_bytes,
+                 outputs / WORKLOAD_PASSES, TICKS_TO_CYCLES(ticks), flash_bytes / WORKLOAD_PASSES,
+                 TICKS_TO_CYCLES(cold_ticks), cold_flash_bytes, checksum);
+
+#if BENCH_COMPRESSED
+    debug_printf("(%u lines held, against %u for the two-way cache)\n",
+                 l2_cache_compressed_lines_held(), 2 * L2_CACHE_LINE_COUNT);
+#endif // BENCH_COMPRESSED
+}
+
+
+int main(int argc, char *argv[]) {
+
+  // Without xScope enabled, the debug_printf()'s below can interfere with the flash reads
+  xscope_config_io(XSCOPE_IO_BASIC);
+
+  // Initialize flash driver
+  flash_setup();
+
+  // Initialize L2 cache, counting what it reads
+#if BENCH_COMPRESSED
+  if(l2_cache_setup_compressed( L2_CACHE_INDEX_COUNT,
+                                L2_CACHE_LINE_SIZE_BYTES,
+                                L2_CACHE_POOL_BYTES,
+                                l2_cache_buffer,
+                                flash_read_counted  ) != 0) {
+    debug_printf("Compressed cache pool out of range\n");
+    return 1;
+  }
+#else
+  L2_CACHE_SETUP( L2_CACHE_LINE_COUNT,
+                  L2_CACHE_LINE_SIZE_BYTES,
+                  l2_cache_buffer,
+                  flash_read_counted  );
+#endif // BENCH_COMPRESSED
+
+  // Start SwMem thread
+  run_async(SWMEM_THREAD, NULL, STACK_BASE(swmem_stack, SWMEM_STACK_WORDS));
+
+  debug_printf("\n\nWorkload benchmark, %s cache, %u x %u byte lines%s\n",
+               ENGINE_NAME, L2_CACHE_LINE_COUNT, L2_CACHE_LINE_SIZE_BYTES,
+               USE_SWMEM? "" : " (tables in SRAM)");
+
+#if L2_CACHE_DEBUG_ON
+  debug_printf("(L2 cache debug is on, so timings are pessimistic)\n");
+#endif // L2_CACHE_DEBUG_ON
+
+  for(int k = 0; k < workload_count; k++) {
+    run_workload(&workloads[k]);
+  }
+
+  debug_printf("\nSUCCESS\n\n");
+}
@@ -0,0 +1,59 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+// A fully connected int8 layer: every weight is read once per inference, in order
+#include "app_common.h"
+#include "gen_data.h"
+#include "swmem_macros.h"
+#include "workloads.h"
+
+#define NN_INPUTS       (256)
+#define NN_OUTPUTS      (256)
+#define NN_INFERENCES   (2)
+
+// About half the weights are zero, the rest small, as after quantisation and pruning
+#define NN_WEIGHT(I)    ((GEN_MIX(I) & 1)? 0 : (int8_t) ((int) ((GEN_MIX(I) >> 1) & 0x3F) - 32))
+#define NN_BIAS(I)      ((int32_t) (GEN_MIX((I) + 0x10000) & 0x3FFF) - 0x2000)
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const int8_t weights[NN_OUTPUTS * NN_INPUTS] = { GEN_8(NN_WEIGHT, 0) };
+
+XCORE_DATA_SECTION_ATTRIBUTE
+WORD_ALIGNED
+static const int32_t bias[NN_OUTPUTS] = { GEN_4(NN_BIAS, 0) };
+
+const unsigned nn_layer_table_bytes = sizeof(weights) + sizeof(bias);
+
+static int8_t input[NN_INPUTS];
+
+
+uint32_t nn_layer_run(
+    unsigned* outputs)
+{
+    uint32_t checksum = 0;
+    uint32_t seed = 0x2545F491;
+
+    for(int n = 0; n < NN_INFERENCES; n++) {
+        for(int i = 0; i < NN_INPUTS; i++) {
+            seed = seed * 1664525 + 1013904223;
+            input[i] = (int8_t) (seed >> 24);
+        }
+
+        for(int o = 0; o < NN_OUTPUTS; o++) {
+            const int8_t* row = &weights[o * NN_INPUTS];
+            int32_t acc = bias[o];
+
+            for(int i = 0; i < NN_INPUTS; i++)
+                acc += row[i] * input[i];
+
+            acc >>= 8;
+            const int8_t out = (acc > 127)? 127 : (acc < -128)? -128 : acc;
+
+            checksum = checksum * 31 + (uint8_t) out;
+        }
+    }
+
+    *outputs += NN_INFERENCES * NN_OUTPUTS;
+    return checksum;
+}
@@ -0,0 +1,16 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include "workloads.h"
+
+#define WORKLOAD_ENTRY(NAME, UNIT)  { #NAME, UNIT, &NAME##_table_bytes, NAME##_run }
+
+const workload_t workloads[] = {
+    WORKLOAD_ENTRY(nn_layer, "output"),
+    WORKLOAD_ENTRY(fir_bank, "sample"),
+    WORKLOAD_ENTRY(hash_lookup, "lookup"),
+    WORKLOAD_ENTRY(glyph_render, "glyph"),
+    WORKLOAD_ENTRY(adpcm_decode, "sample"),
+};
+
+const unsigned workload_count = sizeof(workloads) / sizeof(workloads[0]);
@@ -0,0 +1,40 @@
+// Copyright 2023 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#ifndef WORKLOADS_H_
+#define WORKLOADS_H_
+
+#include <stdint.h>
+
+#define WORKLOAD_FN  __attribute__((fptrgroup("workload_fptr_grp")))
+typedef uint32_t (*workload_fn)(unsigned* outputs);
+
+/**
+ * A workload standing in for part of a product, with its large tables in SwMem (or SRAM when
+ * USE_SWMEM is 0) and its working buffers in SRAM. Each run does the same work, adds the
+ * number of outputs it made to *outputs and returns a checksum of them, which doesn't depend
+ * on where the tables are.
+ */
+typedef struct {
+    const char* name;
+    const char* unit;               /// what one output is
+    const unsigned* table_bytes;    /// size of its tables
+
+    WORKLOAD_FN
+    workload_fn run;
+} workload_t;
+
+extern const workload_t workloads[];
+extern const unsigned workload_count;
+
+#define WORKLOAD_DECLARE(NAME) \
+    extern const unsigned NAME##_table_bytes; \
+    uint32_t NAME##_run(unsigned* outputs);
+
+WORKLOAD_DECLARE(nn_layer)
+WORKLOAD_DECLARE(fir_bank)
+WORKLOAD_DECLARE(hash_lookup)
+WORKLOAD_DECLARE(glyph_render)
+WORKLOAD_DECLARE(adpcm_decode)
+
+#endif // WORKLOADS_H_
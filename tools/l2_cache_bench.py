@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+# Copyright 2023 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+"""
+Run the fill latency benchmark (tests/bench) under xsim and check it against a baseline.
+
+'run' builds the benchmark app for each cache engine and geometry with the simulated flash
+(FLASH_SIM), runs each under xsim and writes the results as a JSON report: for each engine,
+geometry and workload, the mean cycles per fill, the hit rate (permille), the mean hit cycles
+and the 50th, 90th and 99th percentile and worst miss cycles. It needs the XCore tools on the
+path and XCORE_SDK_PATH set, as for any other build.
+
+'compare' checks a report against a baseline report, printing the change in every figure. A
+figure more than the tolerance worse than the baseline is a regression, and the exit status
+is then 1 (2 if there's no baseline yet). Results in the report with no baseline are listed but aren't regressions; results
+in the baseline missing from the report are.
+
+'workloads' runs the workload benchmark (tests/workloads) the same way, for each engine and
+geometry and once more with its tables in SRAM (USE_SWMEM=0). It prints and reports each
+engine's slowdown against SRAM and the flash bytes read per output, and fails if any
+workload's output differs from the SRAM run's. It also runs the compressed engine, given the
+two-way cache's buffer, and shows for each workload whether the extra lines it holds make up
+for its slower hits.
+
+  $ tools/l2_cache_bench.py run -o bench.json
+  $ tools/l2_cache_bench.py compare bench.json tests/bench/baseline.json
+  $ tools/l2_cache_bench.py workloads -o workloads.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ENGINES = ["direct_map", "two_way"]
+# The compressed engine only has a workload app; it gets the two-way cache's buffer
+WORKLOAD_ENGINES = ENGINES + ["compressed"]
+GEOMETRIES = ["256x64", "64x128", "1024x16"]   # line bytes x line count
+WORKLOAD_GEOMETRY = "256x64"
+
+KEY = ("engine", "line_bytes", "line_count", "workload")
+
+# Figures in cycles, where more is worse, compared as a percentage of the baseline
+CYCLE_FIGURES = ["cycles_per_fill", "hit_cycles", "miss_p50", "miss_p90", "miss_p99"]
+
+# The worst miss is reported, but one slow fill isn't a regression
+REPORT_ONLY_FIGURES = ["miss_max"]
+
+
+def parse_geometry(text):
+    try:
+        line_bytes, line_count = (int(x) for x in text.lower().split("x"))
+    except ValueError:
+        raise argparse.ArgumentTypeError("expected LINE_BYTESxLINE_COUNT, e.g. 256x64")
+    if line_bytes < 32 or line_bytes & (line_bytes - 1):
+        raise argparse.ArgumentTypeError("line size must be a power of two, at least 32")
+    return line_bytes, line_count
+
+
+def run_app(bin_dir, app, prefix="BENCH "):
+    """Split out the flash image next to the app, run it under xsim and return its results."""
+    subprocess.run(["xobjdump", "--strip", app + ".xe"], cwd=bin_dir, check=True,
+                   stdout=subprocess.DEVNULL)
+    subprocess.run(["xobjdump", "--split", app + ".xb"], cwd=bin_dir, check=True,
+                   stdout=subprocess.DEVNULL)
+    sim = subprocess.run(["xsim", app + ".xe"], cwd=bin_dir, check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True)
+
+    if "SUCCESS" not in sim.stdout:
+        sys.stdout.write(sim.stdout)
+        raise RuntimeError("%s didn't finish" % app)
+
+    return [json.loads(line[len(prefix):]) for line in sim.stdout.splitlines()
+            if line.startswith(prefix)]
+
+
+def run(args):
+    results = []
+
+    for line_bytes, line_count in args.geometry or [parse_geometry(g) for g in GEOMETRIES]:
+        build_dir = os.path.join(args.build_dir, "%ux%u" % (line_bytes, line_count))
+
+        subprocess.run(["cmake", "-S", REPO_DIR, "-B", build_dir, "-DFLASH_SIM=1",
+                        "-DBENCH_LINE_SIZE_LOG2=%u" % (line_bytes.bit_length() - 1),
+                        "-DBENCH_LINE_COUNT=%u" % line_count] + args.cmake_arg, check=True)
+
+        for engine in args.engine or ENGINES:
+            print("Benchmarking %s, %u x %u byte lines" % (engine, line_count, line_bytes))
+            subprocess.run(["cmake", "--build", build_dir, "--target", "install_bench_" + engine],
+                           check=True)
+            results += run_app(os.path.join(build_dir, "tests", "bench", "bin"),
+                               "l2_cache_bench_" + engine)
+
+    report = {"cmake_args": args.cmake_arg, "results": results}
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    print("Wrote %d results to %s" % (len(results), args.output))
+    return 0
+
+
+def run_workloads_app(args, build_dir, engine, cmake_args):
+    subprocess.run(["cmake", "-S", REPO_DIR, "-B", build_dir, "-DFLASH_SIM=1"] + cmake_args
+                   + args.cmake_arg, check=True)
+    subprocess.run(["cmake", "--build", build_dir, "--target", "install_workloads_" + engine],
+                   check=True)
+    return run_app(os.path.join(build_dir, "tests", "workloads", "bin"),
+                   "l2_cache_workloads_" + engine, prefix="WORKLOAD ")
+
+
+def workloads(args):
+    print("Running the workloads from SRAM")
+    sram = {r["workload"]: r for r in
+            run_workloads_app(args, os.path.join(args.build_dir, "sram"), ENGINES[0],
+                              ["-DUSE_SWMEM=0"])}
+    results = list(sram.values())
+    mismatches = []
+
+    for line_bytes, line_count in args.geometry or [parse_geometry(WORKLOAD_GEOMETRY)]:
+        build_dir = os.path.join(args.build_dir, "%ux%u" % (line_bytes, line_count))
+        cmake_args = ["-DUSE_SWMEM=1",
+                      "-DBENCH_LINE_SIZE_LOG2=%u" % (line_bytes.bit_length() - 1),
+                      "-DBENCH_LINE_COUNT=%u" % line_count]
+
+        for engine in args.engine or WORKLOAD_ENGINES:
+            print("Running the workloads with %s, %u x %u byte lines"
+                  % (engine, line_count, line_bytes))
+            for result in run_workloads_app(args, build_dir, engine, cmake_args):
+                base = sram[result["workload"]]
+                result["slowdown"] = round(float(result["cycles"]) / base["cycles"], 3)
+                result["cold_slowdown"] = round(float(result["cold_cycles"])
+                                                / base["cold_cycles"], 3)
+                result["flash_bytes_per_output"] = round(float(result["flash_bytes"])
+                                                         / result["outputs"], 2)
+                if result["checksum"] != base["checksum"]:
+                    mismatches.append(key_name(result))
+                results.append(result)
+
+    print("\n%-36s %9s %9s %14s" % ("", "slowdown", "cold", "flash B/output"))
+    for r in results:
+        if r["engine"] != "sram":
+            print("%-36s %8.2fx %8.2fx %9.1f/%s" % (key_name(r), r["slowdown"],
+                                                   r["cold_slowdown"],
+                                                   r["flash_bytes_per_output"], r["unit"]))
+
+    print_break_even(results)
+
+    report = {"cmake_args": args.cmake_arg, "results": results}
+
+    with open(args.output, "w") as f:
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+    print("\nWrote %d results to %s" % (len(results), args.output))
+
+    if mismatches:
+        print("\nOutput differs from the SRAM run's:")
+        for mismatch in mismatches:
+            print("  " + mismatch)
+        return 1
+
+    return 0
+
+
+def print_break_even(results):
+    """Where both ran, whether holding more lines compressed beat the two-way cache's faster hits."""
+    two_way = {(r["line_bytes"], r["line_count"], r["workload"]): r
+               for r in results if r["engine"] == "two_way"}
+    rows = [(r, two_way.get((r["line_bytes"], r["line_count"], r["workload"])))
+            for r in results if r["engine"] == "compressed"]
+    rows = [(r, base) for r, base in rows if base]
+    if not rows:
+        return
+
+    print("\n%-36s %9s %12s" % ("compressed against two_way", "cycles", "flash bytes"))
+    for r, base in rows:
+        flash = (float(r["flash_bytes"]) / base["flash_bytes"]) if base["flash_bytes"] else 1.0
+        print("%-36s %8.2fx %11.2fx  %s" % (key_name(r), float(r["cycles"]) / base["cycles"],
+                                           flash, "pays off" if r["cycles"] < base["cycles"]
+                                           else "doesn't pay off"))
+
+
+def key_name(result):
+    return "%s %ux%u %s" % (result["engine"], result["line_bytes"], result["line_count"],
+                            result["workload"])
+
+
+def compare(args):
+    if not os.path.exists(args.baseline):
+        print("No baseline at %s; record one with 'run -o %s'" % (args.baseline, args.baseline))
+        return 2
+
+    with open(args.report) as f:
+        report = {tuple(r[k] for k in KEY): r for r in json.load(f)["results"]}
+    with open(args.baseline) as f:
+        baseline = {tuple(r[k] for k in KEY): r for r in json.load(f)["results"]}
+
+    regressions = []
+
+    for key in sorted(set(report) | set(baseline)):
+        if key not in baseline:
+            print("%-36s  (not in the baseline)" % key_name(report[key]))
+            continue
+        if key not in report:
+            print("%-36s  MISSING" % key_name(baseline[key]))
+            regressions.append("%s missing" % key_name(baseline[key]))
+            continue
+
+        now, then = report[key], baseline[key]
+        changes = []
+
+        for figure in CYCLE_FIGURES + REPORT_ONLY_FIGURES:
+            delta = now[figure] - then[figure]
+            percent = (100.0 * delta / then[figure]) if then[figure] else 0.0
+            changes.append("%s %d (%+.1f%%)" % (figure, now[figure], percent))
+
+            if figure in CYCLE_FIGURES and delta > 0 and \
+                    (then[figure] == 0 or percent > args.cycle_tolerance):
+                regressions.append("%s %s %d -> %d" % (key_name(now), figure, then[figure],
+                                                       now[figure]))
+
+        delta = now["hit_permille"] - then["hit_permille"]
+        changes.append("hit_permille %d (%+d)" % (now["hit_permille"], delta))
+
+        if -delta > args.hit_tolerance:
+            regressions.append("%s hit_permille %d -> %d" % (key_name(now), then["hit_permille"],
+                                                             now["hit_permille"]))
+
+        print("%-36s  %s" % (key_name(now), ", ".join(changes)))
+
+    if regressions:
+        print("\n%d regressions:" % len(regressions))
+        for regression in regressions:
+            print("  " + regression)
+        return 1
+
+    print("\nNo regressions")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command")
+    commands.required = True
+
+    run_parser = commands.add_parser("run", help="build and run the benchmark, write a report")
+    run_parser.add_argument("--engine", action="append", choices=ENGINES,
+                            help="engine to run, repeatable (default all)")
+    run_parser.add_argument("--geometry", action="append", type=parse_geometry,
+                            help="LINE_BYTESxLINE_COUNT, repeatable (default %s)"
+                                 % " ".join(GEOMETRIES))
+    run_parser.add_argument("--cmake-arg", action="append", default=[],
+                            help="extra configure argument, repeatable (e.g. -DL2_CACHE_DEBUG=1)")
+    run_parser.add_argument("--build-dir", default="build_bench",
+                            help="build directory, one subdirectory per geometry")
+    run_parser.add_argument("-o", "--output", default="bench.json", help="report file")
+    run_parser.set_defaults(func=run)
+
+    compare_parser = commands.add_parser("compare", help="check a report against a baseline")
+    compare_parser.add_argument("report", help="report from 'run'")
+    compare_parser.add_argument("baseline", help="baseline report")
+    compare_parser.add_argument("--cycle-tolerance", type=float, default=5.0,
+                                help="percentage by which cycle figures may grow")
+    compare_parser.add_argument("--hit-tolerance", type=int, default=10,
+                                help="permille by which the hit rate may fall")
+    compare_parser.set_defaults(func=compare)
+
+    workloads_parser = commands.add_parser("workloads",
+                                           help="run the workloads, report slowdown against SRAM")
+    workloads_parser.add_argument("--engine", action="append", choices=WORKLOAD_ENGINES,
+                                  help="engine to run, repeatable (default all)")
+    workloads_parser.add_argument("--geometry", action="append", type=parse_geometry,
+                                  help="LINE_BYTESxLINE_COUNT, repeatable (default %s)"
+                                       % WORKLOAD_GEOMETRY)
+    workloads_parser.add_argument("--cmake-arg", action="append", default=[],
+                                  help="extra configure argument, repeatable")
+    workloads_parser.add_argument("--build-dir", default="build_workloads",
+                                  help="build directory, one subdirectory per geometry")
+    workloads_parser.add_argument("-o", "--output", default="workloads.json", help="report file")
+    workloads_parser.set_defaults(func=workloads)
+
+    args = parser.parse_args()
+    sys.exit(args.func(args))
+
+
+if __name__ == "__main__":
+    main()
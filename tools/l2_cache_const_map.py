@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+# Copyright 2023 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+"""
+Build an L2 cache constant-fill map (see l2_cache_set_const_map()) from a SwMem image.
+
+The image is the SwMem section as written to flash (e.g. image_n0c0.swmem, split out of the
+app with 'xobjdump --split'), starting at the start of SwMem. Every run of 32-byte fills in
+which all the words have the same value, and which is at least --min-bytes long, goes in the
+map; zero-initialised tables and erased (0xFF) padding are the usual ones.
+
+The map is written as a C source file defining the runs and their count.
+"""
+
+import argparse
+import struct
+import sys
+
+FILL_BYTES = 32
+
+
+def const_runs(image, min_bytes):
+    """(start, bytes, value) for each constant run of fills in the image."""
+    runs = []
+    fill_count = len(image) // FILL_BYTES
+
+    for fill in range(fill_count):
+        words = struct.unpack_from("<8I", image, fill * FILL_BYTES)
+        if words.count(words[0]) != len(words):
+            continue
+
+        start = fill * FILL_BYTES
+        if runs and runs[-1][0] + runs[-1][1] == start and runs[-1][2] == words[0]:
+            runs[-1][1] += FILL_BYTES
+        else:
+            runs.append([start, FILL_BYTES, words[0]])
+
+    return [tuple(run) for run in runs if run[1] >= min_bytes]
+
+
+def write_c(out, name, runs, image_bytes):
+    covered = sum(run[1] for run in runs)
+    out.write("// Generated by l2_cache_const_map.py: %d runs covering %d of %d bytes\n"
+              % (len(runs), covered, image_bytes))
+    out.write('#include "l2_cache.h"\n\n')
+    out.write("const l2_cache_const_run_t %s[] = {\n" % name)
+    for start, length, value in runs:
+        out.write("  { 0x%08X, 0x%08X, 0x%08X },\n" % (start, length, value))
+    if not runs:
+        # C has no empty arrays; the count says there's nothing in it
+        out.write("  { 0, 0, 0 },\n")
+    out.write("};\n\n")
+    out.write("const unsigned %s_count = %d;\n" % (name, len(runs)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", help="SwMem image file")
+    parser.add_argument("--min-bytes", type=int, default=256,
+                        help="shortest run kept; usually the cache's line size")
+    parser.add_argument("--name", default="l2_cache_const_map", help="C variable name")
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    args = parser.parse_args()
+
+    if args.min_bytes < FILL_BYTES:
+        parser.error("--min-bytes must be at least %d" % FILL_BYTES)
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    runs = const_runs(image, args.min_bytes)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    with out:
+        write_c(out, args.name, runs, len(image))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+# Copyright 2023 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+"""
+Suggest a cache-friendly placement for the contents of the SwMem sections.
+
+Objects in .SwMem_data (and SwMem code) are laid out in link order, so hot objects end up
+sharing L2 cache lines, and sets, with cold ones. Given a fill trace and the link map, this
+works out how hot each input section is and places them:
+
+  * hottest first (by fills per byte), packed so that none touches more lines than it
+    has to,
+  * cold sections after all of the hot ones, in their original order,
+  * each SwMem output section's hot region starting on the cache set after the previous
+    one's ends, so hot code and hot data don't compete for the same sets.
+
+The result is written as a linker script fragment which lists the input sections in the new
+order. The linker can only move whole input sections, so give each SwMem object its own
+section (e.g. __attribute__((section(".SwMem_data.name")))) to place objects individually.
+
+Every section keeps its alignment. A GNU-style map doesn't give input section alignments, so
+each is taken as the largest power of two its address in the map is a multiple of (which the
+linker must have honoured), up to --max-align. The fragment only ever moves the location
+counter forward, with ". = ALIGN(n)" and ". += n", so it stays valid if the output section
+moves.
+
+The trace is any text with 0x4xxxxxxx fill addresses in it (see l2_cache_warm_list.py).
+The map is the one produced with -Wm,--map,memory.map.
+"""
+
+import argparse
+import bisect
+import re
+import sys
+
+from l2_cache_warm_list import SWMEM_BASE, read_fills
+
+SWMEM_END = SWMEM_BASE + (1 << 28)
+
+# An input section, either all on one line or with its name alone on the line before:
+#   " .SwMem_data   0x40000000   0x40000 benchmark_data.c.obj"
+INPUT_SECTION_RE = re.compile(r"^ (\.SwMem\S*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+WRAPPED_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+OUTPUT_SECTION_RE = re.compile(r"^(\.SwMem\S*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+SYMBOL_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$")
+
+
+class InputSection:
+    def __init__(self, output, name, addr, size, obj):
+        self.output = output
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.obj = obj
+        self.symbols = []
+        self.fills = 0
+        self.align = 1
+        self.new_addr = None
+        self.line_start = False     # placed at the start of a line...
+        self.skip = 0               # ...or this many bytes after one, to start on a given set
+
+    @property
+    def density(self):
+        return self.fills / self.size if self.size else 0
+
+    @property
+    def label(self):
+        names = ", ".join(self.symbols[:3]) + (", ..." if len(self.symbols) > 3 else "")
+        return "%s(%s)%s" % (self.obj, self.name, (" [" + names + "]") if names else "")
+
+
+def parse_map(stream):
+    """Returns {output section name: (address, [InputSection])} for the SwMem sections."""
+    outputs = {}
+    current_output = None
+    pending_name = None
+    last = None
+
+    for text in stream:
+        text = text.rstrip("\n")
+
+        m = OUTPUT_SECTION_RE.match(text)
+        if m:
+            current_output = m.group(1)
+            addr = int(m.group(2), 16) if m.group(2) else None
+            outputs.setdefault(current_output, [addr, []])
+            last = None
+            continue
+
+        if text and not text[0].isspace():
+            current_output = None   # some other output section
+            continue
+
+        if current_output is None:
+            continue
+
+        m = INPUT_SECTION_RE.match(text)
+        if m:
+            if m.group(2) is None:
+                pending_name = m.group(1)
+            else:
+                last = add_input(outputs, current_output, m.group(1),
+                                 int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+            continue
+
+        m = WRAPPED_RE.match(text)
+        if m and pending_name:
+            last = add_input(outputs, current_output, pending_name,
+                             int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+            pending_name = None
+            continue
+
+        m = SYMBOL_RE.match(text)
+        if m and last is not None:
+            addr = int(m.group(1), 16)
+            if last.addr <= addr < last.addr + max(last.size, 1):
+                last.symbols.append(m.group(2))
+
+    result = {}
+    for name, (addr, inputs) in outputs.items():
+        inputs = [i for i in inputs if SWMEM_BASE <= i.addr < SWMEM_END and i.size > 0]
+        if not inputs:
+            continue
+        if addr is None:
+            addr = min(i.addr for i in inputs)
+        result[name] = (addr, sorted(inputs, key=lambda i: i.addr))
+    return result
+
+
+def add_input(outputs, output, name, addr, size, obj):
+    section = InputSection(output, name, addr, size, obj.strip())
+    outputs[output][1].append(section)
+    return section
+
+
+def set_alignments(sections, max_align):
+    """Sets each input section's alignment from its address in the map."""
+    for _, (_, inputs) in sections.items():
+        for section in inputs:
+            # Lowest set bit of the address
+            section.align = min(section.addr & -section.addr, max_align)
+
+
+def input_pattern(obj):
+    """Linker script file pattern for an object from the map, which may be an archive member."""
+    m = re.match(r"^(.*)\((.*)\)$", obj)
+    if m:
+        return "*%s:%s" % (m.group(1).split("/")[-1], m.group(2))
+    return "*%s" % obj.split("/")[-1]
+
+
+def count_fills(sections, fills):
+    inputs = sorted((i for _, (_, inputs) in sections.items() for i in inputs), key=lambda i: i.addr)
+    starts = [i.addr for i in inputs]
+
+    for addr in fills:
+        k = bisect.bisect_right(starts, addr) - 1
+        if k >= 0 and addr < inputs[k].addr + inputs[k].size:
+            inputs[k].fills += 1
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def lines_spanned(offset, size, line_bytes):
+    return (offset % line_bytes + size + line_bytes - 1) // line_bytes
+
+
+def place(sections, line_bytes, sets):
+    """Sets new_addr (and line_start and skip) for every input section."""
+    next_set = 0
+
+    for name, (base, inputs) in sorted(sections.items(), key=lambda item: item[1][0]):
+        hot = sorted((i for i in inputs if i.fills), key=lambda i: (-i.density, i.addr))
+        cold = [i for i in inputs if not i.fills]
+
+        addr = base
+
+        # Start the hot region on the set after the previous section's hot region
+        if hot:
+            addr = align_up(addr, line_bytes)
+            hot[0].line_start = True
+            hot[0].skip = ((next_set - addr // line_bytes) % sets) * line_bytes
+            addr += hot[0].skip
+
+        for section in hot:
+            addr = align_up(addr, section.align)
+
+            # Start a new line only if that means the section touches fewer lines
+            if lines_spanned(addr, section.size, line_bytes) > lines_spanned(0, section.size, line_bytes):
+                addr = align_up(addr, line_bytes)
+                section.line_start = True
+            section.new_addr = addr
+            addr += section.size
+
+        if hot:
+            addr = align_up(addr, line_bytes)
+            next_set = (addr // line_bytes) % sets
+            if cold:
+                cold[0].line_start = True
+
+        for section in cold:
+            addr = align_up(addr, section.align)
+            section.new_addr = addr
+            addr += section.size
+
+
+def hot_footprint(sections, line_bytes, sets, ways, use_new):
+    """(lines touched by hot sections, those lines in sets holding more than `ways` of them)"""
+    lines = set()
+    for _, (_, inputs) in sections.items():
+        for section in inputs:
+            if section.fills:
+                addr = section.new_addr if use_new else section.addr
+                lines.update(range(addr // line_bytes, (addr + section.size - 1) // line_bytes + 1))
+
+    per_set = {}
+    for line in lines:
+        per_set.setdefault(line % sets, []).append(line)
+    conflicted = sum(len(l) for l in per_set.values() if len(l) > ways)
+    return len(lines), conflicted
+
+
+def write_script(out, sections, line_bytes):
+    out.write("/* Generated by l2_cache_layout.py */\n\n")
+    for name, (base, inputs) in sorted(sections.items(), key=lambda item: item[1][0]):
+        out.write("%s :\n{\n" % name)
+        for section in sorted(inputs, key=lambda i: i.new_addr):
+            # Line starts, and the sets skipped to keep hot regions apart, are relative to
+            # wherever the linker puts the section; the section's own alignment comes after
+            if section.line_start:
+                out.write("  . = ALIGN(%d);\n" % line_bytes)
+                if section.skip:
+                    out.write("  . += 0x%x;\n" % section.skip)
+            if section.align > (line_bytes if section.line_start else 1):
+                out.write("  . = ALIGN(%d);\n" % section.align)
+            comment = " /* %d fills */" % section.fills if section.fills else ""
+            out.write("  KEEP(%s(%s))%s\n" % (input_pattern(section.obj), section.name, comment))
+        out.write("}\n\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="text file containing fill addresses ('-' for stdin)")
+    parser.add_argument("map", help="link map (memory.map)")
+    parser.add_argument("--line-bytes", type=int, default=256, help="L2 cache line size")
+    parser.add_argument("--line-count", type=int, default=64, help="L2 cache line count")
+    parser.add_argument("--ways", type=int, choices=(1, 2), default=1,
+                        help="1 for the direct-mapped cache, 2 for the two-way cache")
+    parser.add_argument("--max-align", type=int,
+                        help="largest alignment assumed for an input section (default "
+                             "--line-bytes; raise it for anything explicitly aligned more)")
+    parser.add_argument("-o", "--output", help="linker script fragment (default stdout)")
+    args = parser.parse_args()
+
+    if args.line_bytes < 32 or args.line_bytes & (args.line_bytes - 1):
+        parser.error("--line-bytes must be a power of two, at least 32")
+
+    with open(args.map) as stream:
+        sections = parse_map(stream)
+
+    if not sections:
+        sys.exit("No SwMem sections found in %s" % args.map)
+
+    set_alignments(sections, args.max_align or args.line_bytes)
+
+    stream = sys.stdin if args.trace == "-" else open(args.trace)
+    with stream:
+        count_fills(sections, read_fills(stream))
+
+    # The two-way cache has line_count sets of two lines
+    sets = args.line_count
+    place(sections, args.line_bytes, sets)
+
+    before = hot_footprint(sections, args.line_bytes, sets, args.ways, use_new=False)
+    after = hot_footprint(sections, args.line_bytes, sets, args.ways, use_new=True)
+
+    report = sys.stderr
+    for name, (_, inputs) in sections.items():
+        for section in sorted(inputs, key=lambda i: -i.density):
+            if section.fills:
+                report.write("%8d fills  %8d bytes  0x%08x -> 0x%08x  %s\n" % (
+                    section.fills, section.size, section.addr, section.new_addr, section.label))
+    report.write("Hot lines: %d -> %d; in over-subscribed sets: %d -> %d\n"
+                 % (before[0], after[0], before[1], after[1]))
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    with out:
+        write_script(out, sections, args.line_bytes)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# Copyright 2023 XMOS LIMITED.
+# This Software is subject to the terms of the XMOS Public Licence: Version 1.
+"""
+Build an L2 cache warm list (see l2_cache_warm_from_list()) from a trace of SwMem fill
+addresses.
+
+The trace is any text file; every 0x4xxxxxxx hex number in it is taken as a fill address,
+so the output of the debug fill printing, or a simulator trace, can be used as it is.
+
+The hottest lines (those with the most fills) are kept, up to --max-lines, and written either
+as a C source file defining the list, or as a little-endian binary image for writing straight
+to flash.
+"""
+
+import argparse
+import collections
+import re
+import struct
+import sys
+
+SWMEM_BASE = 0x40000000
+WARM_LIST_MAGIC = 0x4C57324C
+RUN_MAX_LINES = 256
+
+ADDRESS_RE = re.compile(r"0x(4[0-9a-fA-F]{7})\b")
+
+
+def read_fills(stream):
+    for text in stream:
+        for match in ADDRESS_RE.finditer(text):
+            yield int(match.group(1), 16)
+
+
+def hot_lines(fills, line_bytes, max_lines):
+    counts = collections.Counter((addr - SWMEM_BASE) // line_bytes for addr in fills)
+    # Ties go to the lower line, so the output is stable
+    ranked = sorted(counts.items(), key=lambda item: (-item[1], item[0]))
+    return sorted(line for line, _ in ranked[:max_lines])
+
+
+def make_runs(lines):
+    runs = []
+    for line in lines:
+        if runs and runs[-1][0] + runs[-1][1] == line and runs[-1][1] < RUN_MAX_LINES:
+            runs[-1][1] += 1
+        else:
+            runs.append([line, 1])
+    return [(first << 8) | (count - 1) for first, count in runs]
+
+
+def write_c(out, name, line_bytes, runs, line_count):
+    out.write("// Generated by l2_cache_warm_list.py: %d lines in %d runs\n" % (line_count, len(runs)))
+    out.write('#include "l2_cache.h"\n\n')
+    out.write("const l2_cache_warm_list_t %s = {\n" % name)
+    out.write("  .magic = L2_CACHE_WARM_LIST_MAGIC,\n")
+    out.write("  .line_bytes = %d,\n" % line_bytes)
+    out.write("  .run_count = %d,\n" % len(runs))
+    out.write("  .run = {\n")
+    for run in runs:
+        out.write("    L2_CACHE_WARM_RUN(%d, %d),\n" % (run >> 8, (run & 0xFF) + 1))
+    out.write("  },\n};\n")
+
+
+def write_bin(out, line_bytes, runs):
+    out.write(struct.pack("<%dI" % (3 + len(runs)), WARM_LIST_MAGIC, line_bytes, len(runs), *runs))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace", help="text file containing fill addresses ('-' for stdin)")
+    parser.add_argument("--line-bytes", type=int, default=256, help="L2 cache line size")
+    parser.add_argument("--max-lines", type=int, required=True,
+                        help="most lines to keep; usually the cache's line count (times 2 for two-way)")
+    parser.add_argument("--format", choices=("c", "bin"), default="c")
+    parser.add_argument("--name", default="l2_cache_warm_list", help="C variable name")
+    parser.add_argument("-o", "--output", help="output file (default stdout)")
+    args = parser.parse_args()
+
+    if args.line_bytes < 32 or args.line_bytes & (args.line_bytes - 1):
+        parser.error("--line-bytes must be a power of two, at least 32")
+
+    stream = sys.stdin if args.trace == "-" else open(args.trace)
+    with stream:
+        lines = hot_lines(read_fills(stream), args.line_bytes, args.max_lines)
+
+    runs = make_runs(lines)
+
+    if args.format == "bin":
+        out = open(args.output, "wb") if args.output else sys.stdout.buffer
+        with out:
+            write_bin(out, args.line_bytes, runs)
+    else:
+        out = open(args.output, "w") if args.output else sys.stdout
+        with out:
+            write_c(out, args.name, args.line_bytes, runs, len(lines))
+
+
+if __name__ == "__main__":
+    main()